@@ -0,0 +1,313 @@
+#include "bead_spring.h"
+using namespace std;
+
+static const double wcaCut2 = pow(2., 1. / 3.);   // (2^(1/6))^2
+static const double cellSize = pow(2., 1. / 6.);
+static const double feneK = 30.;
+static const double feneR02 = 1.5 * 1.5;
+
+static double wca(double r2) {
+    if (r2 >= wcaCut2)
+        return 0.;
+    double s6 = 1. / (r2 * r2 * r2);
+    return 4. * (s6 * s6 - s6) + 1.;
+}
+
+// infinite when stretched beyond R0
+static double fene(double r2) {
+    if (r2 >= feneR02)
+        return HUGE_VAL;
+    return -0.5 * feneK * feneR02 * log(1. - r2 / feneR02);
+}
+
+static double distance2(const Bead & a, const Bead & b) {
+    double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+Site3 BeadSpring::cellOf(Bead b) const {
+    Site3 c;
+    c.x = int(floor(b.x / cellSize));
+    c.y = int(floor(b.y / cellSize));
+    c.z = int(floor(b.z / cellSize));
+    return c;
+}
+
+void BeadSpring::link(int i, Site3 c) {
+    int first = head.get(c);
+    next[i] = first;
+    prev[i] = -1;
+    if (first >= 0)
+        prev[first] = i;
+    head.insert(c, i);
+    cell[i] = c;
+}
+
+void BeadSpring::unlink(int i, Site3 c) {
+    if (prev[i] >= 0)
+        next[prev[i]] = next[i];
+    else if (next[i] >= 0)
+        head.insert(c, next[i]);
+    else
+        head.erase(c);
+    if (next[i] >= 0)
+        prev[next[i]] = prev[i];
+}
+
+void BeadSpring::straighten() {
+    const double bond = 0.97;       // about the mean bond length at T = 1
+    beads.resize(n_beads);
+    cell.resize(n_beads);
+    next.resize(n_beads);
+    prev.resize(n_beads);
+    head.clear();
+    head.reserve(n_beads);
+    for (unsigned int i = 0; i < n_beads; i++) {
+        beads[i].x = i * bond;
+        beads[i].y = beads[i].z = 0.;
+        link(i, cellOf(beads[i]));
+    }
+    U = energy();
+}
+
+void BeadSpring::grow() {
+    const double bond = 0.97, closest = 1.;
+    straighten();
+    unsigned int i = 1;
+    while (i < n_beads) {
+        // each bead a bond away from the last in a random direction,
+        // retried while it comes closer than closest to an earlier one;
+        // start over if that keeps happening
+        bool placed = false;
+        for (int tries = 0; tries < 100 && !placed; tries++) {
+            double z = 2. * disUniform(gen) - 1.;
+            double phi = 2. * M_PI * disUniform(gen);
+            double rho = sqrt(1. - z * z);
+            Bead b = beads[i - 1];
+            b.x += bond * rho * cos(phi);
+            b.y += bond * rho * sin(phi);
+            b.z += bond * z;
+            placed = true;
+            Site3 c = cellOf(b), d;
+            for (d.x = c.x - 1; d.x <= c.x + 1; d.x++)
+                for (d.y = c.y - 1; d.y <= c.y + 1; d.y++)
+                    for (d.z = c.z - 1; d.z <= c.z + 1; d.z++)
+                        for (int j = head.get(d); j >= 0; j = next[j])
+                            if (j < int(i) - 1 && distance2(b, beads[j]) < closest * closest)
+                                placed = false;
+            if (placed) {
+                unlink(i, cell[i]);
+                beads[i] = b;
+                link(i, c);
+            }
+        }
+        if (placed)
+            ++i;
+        else {
+            straighten();
+            i = 1;
+        }
+    }
+    U = energy();
+}
+
+double BeadSpring::localEnergy(int i, Bead b) const {
+    double u = 0.;
+    if (i > 0)
+        u += fene(distance2(b, beads[i - 1]));
+    if (i + 1 < int(n_beads))
+        u += fene(distance2(b, beads[i + 1]));
+    if (u == HUGE_VAL)
+        return u;
+
+    Site3 c = cellOf(b), d;
+    for (d.x = c.x - 1; d.x <= c.x + 1; d.x++)
+        for (d.y = c.y - 1; d.y <= c.y + 1; d.y++)
+            for (d.z = c.z - 1; d.z <= c.z + 1; d.z++)
+                for (int j = head.get(d); j >= 0; j = next[j])
+                    if (j != i)
+                        u += wca(distance2(b, beads[j]));
+    return u;
+}
+
+bool BeadSpring::move(int i, double dx, double dy, double dz) {
+    ++attempts;
+    Bead b = beads[i];
+    b.x += dx;
+    b.y += dy;
+    b.z += dz;
+    double uNew = localEnergy(i, b);
+    if (uNew == HUGE_VAL)
+        return false;
+    double dU = uNew - localEnergy(i, beads[i]);
+    if (dU > 0. && disUniform(gen) >= exp(-dU / temperature))
+        return false;
+
+    Site3 c = cellOf(b);
+    if (c != cell[i]) {
+        unlink(i, cell[i]);
+        link(i, c);
+    }
+    beads[i] = b;
+    U += dU;
+    ++accepted;
+    return true;
+}
+
+// repulsion of a bead at b with the beads that stay put in a pivot about
+// bead k: those before k if the ones after it move, else those after
+double BeadSpring::fixedEnergy(Bead b, int k, bool forward) const {
+    double u = 0.;
+    Site3 c = cellOf(b), d;
+    for (d.x = c.x - 1; d.x <= c.x + 1; d.x++)
+        for (d.y = c.y - 1; d.y <= c.y + 1; d.y++)
+            for (d.z = c.z - 1; d.z <= c.z + 1; d.z++)
+                for (int j = head.get(d); j >= 0; j = next[j])
+                    if (forward ? j < k : j > k)
+                        u += wca(distance2(b, beads[j]));
+    return u;
+}
+
+bool BeadSpring::pivot(int k, double q0, double q1, double q2, double q3) {
+    int n = n_beads;
+    double norm = sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    if (k <= 0 || k >= n - 1 || norm == 0.)
+        return false;
+    ++pivotAttempts;
+    q0 /= norm;
+    q1 /= norm;
+    q2 /= norm;
+    q3 /= norm;
+    const double R[3][3] = {
+        { 1. - 2. * (q2 * q2 + q3 * q3), 2. * (q1 * q2 - q0 * q3), 2. * (q1 * q3 + q0 * q2) },
+        { 2. * (q1 * q2 + q0 * q3), 1. - 2. * (q1 * q1 + q3 * q3), 2. * (q2 * q3 - q0 * q1) },
+        { 2. * (q1 * q3 - q0 * q2), 2. * (q2 * q3 + q0 * q1), 1. - 2. * (q1 * q1 + q2 * q2) } };
+
+    // rotate the beads after k if there are no more of them than before
+    // k; the bonds keep their lengths, and so do the distances within
+    // each part, so only the repulsion between the parts changes
+    bool forward = n - 1 - k <= k;
+    int step = forward ? 1 : -1;
+    int end = forward ? n : -1;
+    Bead p = beads[k];
+    trial.resize(n);
+    double dU = 0.;
+    for (int i = k + step; i != end; i += step) {
+        double dx = beads[i].x - p.x, dy = beads[i].y - p.y, dz = beads[i].z - p.z;
+        Bead b;
+        b.x = p.x + R[0][0] * dx + R[0][1] * dy + R[0][2] * dz;
+        b.y = p.y + R[1][0] * dx + R[1][1] * dy + R[1][2] * dz;
+        b.z = p.z + R[2][0] * dx + R[2][1] * dy + R[2][2] * dz;
+        dU += fixedEnergy(b, k, forward) - fixedEnergy(beads[i], k, forward);
+        trial[i] = b;
+    }
+    if (dU > 0. && disUniform(gen) >= exp(-dU / temperature))
+        return false;
+
+    for (int i = k + step; i != end; i += step) {
+        Site3 c = cellOf(trial[i]);
+        if (c != cell[i]) {
+            unlink(i, cell[i]);
+            link(i, c);
+        }
+        beads[i] = trial[i];
+    }
+    U += dU;
+    ++pivotAccepted;
+    return true;
+}
+
+// four Gaussians make a quaternion uniform on the sphere, and so a
+// rotation uniform over all rotations, as likely as its inverse
+bool BeadSpring::pivot() {
+    if (n_beads < 3)
+        return false;
+    std::uniform_int_distribution<> disPivot(1, n_beads - 2);
+    int k = disPivot(gen);
+    double q0 = gauss(gen), q1 = gauss(gen), q2 = gauss(gen), q3 = gauss(gen);
+    return pivot(k, q0, q1, q2, q3);
+}
+
+bool BeadSpring::move() {
+    int i = disBead(gen);
+    double dx = delta * (2. * disUniform(gen) - 1.);
+    double dy = delta * (2. * disUniform(gen) - 1.);
+    double dz = delta * (2. * disUniform(gen) - 1.);
+    return move(i, dx, dy, dz);
+}
+
+void BeadSpring::sweep() {
+    for (unsigned int k = 0; k < n_beads; k++)
+        move();
+    for (unsigned int k = 0; k < n_pivots; k++)
+        pivot();
+}
+
+void BeadSpring::run() {
+    for (unsigned int s = 0; s < n_equilibrate; s++)
+        sweep();
+    attempts = accepted = 0;
+    pivotAttempts = pivotAccepted = 0;
+
+    // the error of <R^2> from the scatter of the means of blocks of
+    // consecutive sweeps, each much longer than the correlation time
+    const int blocks = 20;
+    double blockSum[blocks] = { 0. };
+    int blockCount[blocks] = { 0 };
+    r2av = r4av = rg2av = 0.;
+    for (unsigned int s = 0; s < n_sweeps; s++) {
+        sweep();
+        double r2 = rSquared();
+        r2av += r2;
+        r4av += r2 * r2;
+        rg2av += rGyration();
+        int b = int((long long)s * blocks / n_sweeps);
+        blockSum[b] += r2;
+        ++blockCount[b];
+    }
+    if (n_sweeps > 0) {
+        r2av /= n_sweeps;
+        r4av /= n_sweeps;
+        rg2av /= n_sweeps;
+    }
+    stdDev = sqrt(max(0., r4av - r2av * r2av));
+    r2err = 0.;
+    if (n_sweeps >= unsigned(blocks)) {
+        for (int b = 0; b < blocks; b++) {
+            double d = blockSum[b] / blockCount[b] - r2av;
+            r2err += d * d;
+        }
+        r2err = sqrt(r2err / (blocks * (blocks - 1.)));
+    }
+}
+
+double BeadSpring::energy() const {
+    double u = 0.;
+    for (unsigned int i = 0; i < n_beads; i++) {
+        if (i + 1 < n_beads)
+            u += fene(distance2(beads[i], beads[i + 1]));
+        for (unsigned int j = i + 1; j < n_beads; j++)
+            u += wca(distance2(beads[i], beads[j]));
+    }
+    return u;
+}
+
+double BeadSpring::rSquared() const {
+    return distance2(beads.front(), beads.back());
+}
+
+double BeadSpring::rGyration() const {
+    Bead mean = { 0., 0., 0. };
+    for (unsigned int i = 0; i < n_beads; i++) {
+        mean.x += beads[i].x;
+        mean.y += beads[i].y;
+        mean.z += beads[i].z;
+    }
+    mean.x /= n_beads;
+    mean.y /= n_beads;
+    mean.z /= n_beads;
+    double rg2 = 0.;
+    for (unsigned int i = 0; i < n_beads; i++)
+        rg2 += distance2(beads[i], mean);
+    return rg2 / n_beads;
+}
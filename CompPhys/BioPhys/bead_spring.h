@@ -0,0 +1,149 @@
+#ifndef bead_spring_h
+#define bead_spring_h
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "lattice.h"
+#include "site_set.h"
+
+struct Bead {               // position of a bead in units of sigma
+    double x;
+    double y;
+    double z;
+};
+
+// Off-lattice bead-spring chain in three dimensions, the model of Kremer
+// and Grest: every pair of beads repels with the WCA potential
+//
+//   U(r) = 4 (r^-12 - r^-6) + 1  for r < 2^(1/6),  0 beyond,
+//
+// in units of epsilon and sigma, and neighbours along the chain are also
+// held together by the FENE spring
+//
+//   U(r) = -k R0^2 / 2 log(1 - (r / R0)^2),  k = 30, R0 = 1.5,
+//
+// which keeps bonds from crossing. The chain is sampled by Metropolis
+// Monte Carlo at temperature T; in this good solvent <R^2> ~
+// n_beads^(2 nu) with nu = 0.588. A sweep is n_beads moves of single
+// beads by up to delta along each axis and n_pivots pivots: a random
+// rotation of the shorter part of the chain about a random bead, which
+// leaves every bond length as it was and changes only the repulsion
+// between the part moved and the rest. Local moves alone are slow: the
+// chain relaxes like a Rouse chain, after of order
+// n_beads^(1 + 2 nu) / (acceptance delta^2) sweeps, some 5 10^5 for 32
+// beads. The pivots bring <R^2> to equilibrium in a few accepted ones
+// instead, and the local moves keep the bonds and the short scales in
+// equilibrium. The chain starts from grow(), a random coil.
+//
+// Excluded volume is found with a cell list: space is divided into cubes
+// of side 2^(1/6), the cells holding beads are kept in a
+// BasicSiteMap<Site3> with the first bead in each, and the beads of a
+// cell are linked in a list through next / prev. A move then only looks
+// at the 27 cells around the bead, so a sweep costs O(n_beads) instead of
+// O(n_beads^2), and no memory is needed for the empty space the chain
+// spans.
+class BeadSpring{
+
+public:
+  BeadSpring(unsigned int n_beads_in,              // beads in the chain
+	     unsigned int n_sweeps_in,             // sweeps to sample
+	     unsigned int n_equilibrate_in = 1000, // sweeps before the first
+	     double temperature_in = 1.0,          // in units of epsilon
+	     double delta_in = 0.1,                // largest displacement
+	     unsigned int n_pivots_in = 1) :       // pivots tried per sweep
+    rd(), gen(rd()), disUniform(0., 1.), disBead(0, n_beads_in - 1), gauss(0., 1.),
+    n_beads(n_beads_in), n_sweeps(n_sweeps_in), n_equilibrate(n_equilibrate_in),
+    n_pivots(n_pivots_in), temperature(temperature_in), delta(delta_in),
+    attempts(0), accepted(0), pivotAttempts(0), pivotAccepted(0),
+    U(0.), r2av(0.), r4av(0.), stdDev(0.), r2err(0.), rg2av(0.)
+  {
+    grow();
+  }
+
+  void straighten();          // start over from a straight chain along x
+  void grow();                // start over from a random chain grown bead
+                              // by bead without overlaps
+
+  bool move(                  // try a move and return true if accepted
+	    int i,                   // of this bead
+	    double dx, double dy, double dz);   // by this displacement
+  bool move();                // try a random move of a random bead
+  bool pivot(                 // try a pivot and return true if accepted
+	     int k,                  // about this bead, 0 < k < n_beads - 1
+	     double q0, double q1, double q2, double q3);   // rotation by
+				     // this quaternion, normalized first
+  bool pivot();               // try a pivot by a uniformly random rotation
+  void sweep();               // try n_beads random moves and n_pivots pivots
+
+  void run();                 // equilibrate, then take n_sweeps samples
+  void seed(unsigned int s) { gen.seed(s); }
+
+  double energy() const;      // total energy summed over all pairs
+  double rSquared() const;    // end-to-end distance squared
+  double rGyration() const;   // radius of gyration squared
+
+  unsigned int get_nbeads() const { return n_beads; }
+  unsigned int get_nsweeps() const { return n_sweeps; }
+  unsigned int get_npivots() const { return n_pivots; }
+  void set_npivots(unsigned int p) { n_pivots = p; }
+  double get_temperature() const { return temperature; }
+  double get_delta() const { return delta; }
+  void set_delta(double d) { delta = d; }
+  long long get_attempts() const { return attempts; }
+  long long get_accepted() const { return accepted; }
+  double get_acceptance() const { return attempts > 0 ? accepted / double(attempts) : 0.; }
+  long long get_pivot_attempts() const { return pivotAttempts; }
+  long long get_pivot_accepted() const { return pivotAccepted; }
+  double get_pivot_acceptance() const {
+    return pivotAttempts > 0 ? pivotAccepted / double(pivotAttempts) : 0.;
+  }
+  double get_energy() const { return U; }      // kept up to date by move()
+  double get_r2av() const { return r2av; }
+  double get_r4av() const { return r4av; }
+  double get_stdDev() const { return stdDev; }
+  double get_r2err() const { return r2err; }   // error of r2av from 20 blocks
+  double get_rg2av() const { return rg2av; }
+  std::vector<Bead> const & get_beads() const { return beads; }
+
+protected:
+  double localEnergy(         // energy of bead i if it were at b
+		     int i, Bead b) const;
+  double fixedEnergy(         // repulsion of a bead at b with the beads
+		     Bead b, int k,          // that stay put in a pivot about k
+		     bool forward) const;    // of the beads after k
+  Site3 cellOf(Bead b) const;
+  void link(int i, Site3 c);  // put bead i in the list of cell c
+  void unlink(int i, Site3 c);
+
+  std::random_device rd;
+  std::mt19937 gen;
+  std::uniform_real_distribution<> disUniform;
+  std::uniform_int_distribution<> disBead;
+  std::normal_distribution<> gauss;
+
+  unsigned int n_beads, n_sweeps, n_equilibrate, n_pivots;
+  double temperature;
+  double delta;
+  long long attempts;
+  long long accepted;
+  long long pivotAttempts;
+  long long pivotAccepted;
+  double U;                   // current energy
+  double r2av;
+  double r4av;
+  double stdDev;
+  double r2err;
+  double rg2av;
+  std::vector<Bead> beads;
+  std::vector<Site3> cell;    // cell of each bead
+  std::vector<int> next;      // next bead in the same cell, or -1
+  std::vector<int> prev;      // previous one, or -1
+  BasicSiteMap<Site3> head;   // first bead in each occupied cell
+  std::vector<Bead> trial;    // moved beads of a pivot being tried
+};
+
+#endif
@@ -0,0 +1,171 @@
+// Running radius of gyration and FFT structure factor against direct
+// sums over the chain: Rg^2 after many reptation moves on each lattice,
+// the cost of a sample either way, S(q) at every grid point against the
+// sum of phases, and S(q) of a reptating chain with the Guinier law
+// S(q) / N = 1 - q^2 Rg^2 / d at small q
+//
+//   usage: bench_chain_observables [length] [moves]
+#include "reptation.h"
+#include "sawalk.h"
+#include "bench_util.h"
+using namespace std;
+
+// the snake itself, for the direct sums
+template <typename L>
+struct Probe : public LatticeReptation<L> {
+  Probe(int steps) : LatticeReptation<L>(steps, 0, LatticeReptation<L>::LINE) { }
+  vector<typename L::site_type> sites() const {
+    vector<typename L::site_type> s;
+    for (size_t i = 0; i < this->snake.size(); i++)
+      s.push_back(this->snake[i]);
+    return s;
+  }
+};
+
+// Rg^2 as half the mean squared distance over all pairs
+template <typename L>
+double rg2_direct(vector<typename L::site_type> const & s)
+{
+  double sum = 0;
+  for (size_t i = 0; i < s.size(); i++)
+    for (size_t j = 0; j < i; j++)
+      sum += L::distance2(s[i], s[j]);
+  return sum / (double(s.size()) * s.size());
+}
+
+template <typename L>
+bool check(char const * name, int length, int moves)
+{
+  const int D = L::dimension, M = 8;
+  Probe<L> chain(length);
+  chain.createSnake(length, Probe<L>::COIL);
+  LatticeStructureFactor<L> sf(M, 3);
+  vector< vector<typename L::site_type> > kept;
+  double worst = 0;
+  for (int k = 0; k < 20; k++) {
+    for (int i = 0; i < moves / 20; i++)
+      chain.reptate();
+    vector<typename L::site_type> s = chain.sites();
+    double direct = rg2_direct<L>(s);
+    worst = max(worst, fabs(chain.rgSquared() - direct) / direct);
+    chain.sampleStructure(sf);
+    kept.push_back(s);
+  }
+
+  // |sum_j exp(-2 pi i k . c_j / M)|^2 / N at every grid point
+  vector<double> fft = sf.get_grid_S();
+  double worst_S = 0;
+  for (size_t k = 0; k < fft.size(); k++) {
+    int kc[3] = { int(k % M), int(k / M % M), int(k / M / M % M) };
+    double S = 0;
+    for (size_t c = 0; c < kept.size(); c++) {
+      complex<double> rho = 0;
+      for (size_t j = 0; j < kept[c].size(); j++) {
+	long long x[3];
+	site_coords(kept[c][j], x);
+	double phase = 0;
+	for (int a = 0; a < D; a++)
+	  phase += kc[a] * x[a];
+	rho += polar(1.0, -2 * M_PI * phase / M);
+      }
+      S += norm(rho) / kept[c].size();
+    }
+    worst_S = max(worst_S, fabs(S / kept.size() - fft[k]));
+  }
+  cout << setw(12) << name << setw(16) << worst << setw(16) << worst_S << endl;
+  return worst < 1e-12 && worst_S < 1e-9 * length;
+}
+
+int main(int argc, char * argv[])
+{
+  int length = int_arg(argc, argv, 1, 200);
+  int moves = int_arg(argc, argv, 2, 1000000);
+  bool ok = true;
+
+  cout << " " << length << "-step chains against direct sums" << endl
+       << setw(12) << "lattice" << setw(16) << "Rg^2 rel. err" << setw(16) << "S(q) abs. err" << endl;
+  ok = check<SquareLattice>("square", length, moves) && ok;
+  ok = check<TriangularLattice>("triangular", length, moves) && ok;
+  ok = check<CubicLattice>("cubic", length, moves) && ok;
+  ok = check<FCCLattice>("fcc", length, moves) && ok;
+
+  // a sample each move, running sums against the direct O(N^2) sum and
+  // the O(N) one about the centre of mass
+  cout << endl << setw(8) << "N" << setw(16) << "running (ns)" << setw(16) << "O(N) (ns)" << endl;
+  for (int n = 100; n <= 10000; n *= 10) {
+    Probe<SquareLattice> chain(n);
+    chain.createSnake(n, Probe<SquareLattice>::COIL);
+    int samples = 1000000;
+    double sum = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) {
+      chain.reptate();
+      sum += chain.rgSquared();
+    }
+    double running = seconds_since(t0) * 1e9 / samples;
+    int slow = max(100, samples / n);
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < slow; i++) {
+      chain.reptate();
+      vector<Site> s = chain.sites();
+      double cx = 0, cy = 0, r = 0;
+      for (size_t j = 0; j < s.size(); j++) {
+	cx += s[j].x;
+	cy += s[j].y;
+      }
+      cx /= s.size();
+      cy /= s.size();
+      for (size_t j = 0; j < s.size(); j++)
+	r += (s[j].x - cx) * (s[j].x - cx) + (s[j].y - cy) * (s[j].y - cy);
+      sum += r / s.size();
+    }
+    double direct = seconds_since(t0) * 1e9 / slow;
+    cout << setw(8) << n << setw(16) << running << setw(16) << direct
+	 << (sum < 0 ? " " : "") << endl;
+  }
+
+  // S(q) of a reptating chain, sampled every 10 N moves, on a grid fine
+  // enough for q Rg < 1 in the first shells
+  {
+    const int n = 30;
+    Reptation chain(n, 0, Reptation::LINE);
+    chain.createSnake(n, Reptation::COIL);
+    StructureFactor sf(128);
+    double rg2 = 0;
+    int samples = 4000;
+    for (int i = 0; i < 1000 * n; i++)
+      chain.reptate();
+    auto t0 = chrono::steady_clock::now();
+    for (int k = 0; k < samples; k++) {
+      for (int i = 0; i < 10 * n; i++)
+	chain.reptate();
+      chain.sampleStructure(sf);
+      rg2 += chain.rgSquared() / samples;
+    }
+    vector<double> q = sf.get_q(), S = sf.get_S();
+    double t = seconds_since(t0);
+    cout << endl << " S(q) of a " << n << "-step chain on the square lattice, <Rg^2> = "
+	 << rg2 << ", " << t / samples * 1e6 << " us per sample" << endl
+	 << setw(10) << "q" << setw(12) << "S(q)/N" << setw(12) << "Guinier" << endl;
+    for (size_t b = 0; b < q.size() && b < 6; b++)
+      cout << setw(10) << q[b] << setw(12) << S[b] / (n + 1)
+	   << setw(12) << 1 - q[b] * q[b] * rg2 / 2 << endl;
+    ok = fabs(S[0] / (n + 1) - (1 - q[0] * q[0] * rg2 / 2)) < 0.01 && ok;
+  }
+
+  // the universal ratio <R^2> / <Rg^2> of self-avoiding walks, about 7.0
+  // in 2D and 6.3 in 3D (6 for random walks)
+  {
+    SAWalk walk(20, 20000);
+    walk.run();
+    CubicSAWalk walk3(20, 20000);
+    walk3.run();
+    cout << endl << " 20-step SAWalk <R^2>/<Rg^2>: square " << walk.get_r2av() / walk.get_rg2av()
+	 << ", cubic " << walk3.get_r2av() / walk3.get_rg2av() << endl;
+  }
+
+  if (!ok) {
+    cout << " running sums or FFT disagree with the direct sums" << endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,125 @@
+// GeneticAlgorithm on the problems of genetic.ipynb and
+// genetic_protein.ipynb: the HP scoring against a direct count over all
+// pairs, "Hello World!" guessed, the 20-residue protein of Unger and
+// Moult folded with each crossover (its ground state on the square
+// lattice has E = -9, which no fold may beat), and evaluations per
+// second with one thread and with all, which must give the same run
+//
+//   usage: bench_genetic [population] [generations] [threads]
+#include "hp_model.h"
+#include "bench_util.h"
+#include <iomanip>
+#include <thread>
+using namespace std;
+
+// contacts and collisions of the folds of random genomes, by all pairs
+template <typename L>
+bool check_scoring(const string& sequence, int samples)
+{
+  LatticeHPFitness<L> hp(sequence);
+  mt19937_64 gen(1);
+  Genome g(hp.bits());
+  for (int s = 0; s < samples; s++) {
+    g.randomize(gen);
+    vector<typename L::site_type> sites = hp.fold(g);
+    int contacts = 0, collisions = 0;
+    for (int i = 0; i < hp.get_length(); i++) {
+      bool first = true;
+      for (int j = 0; j < i; j++)
+	first = first && sites[j] != sites[i];
+      collisions += !first;
+    }
+    for (int i = 0; i < hp.get_length(); i++)
+      for (int j = i + 2; j < hp.get_length(); j++) {
+	bool hh = (sequence[i] == 'H' || sequence[i] == 'B') && (sequence[j] == 'H' || sequence[j] == 'B');
+	// the first residue on each site is the one counted
+	bool first_i = true, first_j = true;
+	for (int k = 0; k < i; k++)
+	  first_i = first_i && sites[k] != sites[i];
+	for (int k = 0; k < j; k++)
+	  first_j = first_j && sites[k] != sites[j];
+	contacts += hh && first_i && first_j && L::distance2(sites[i], sites[j]) == 1;
+      }
+    if (contacts != hp.contacts(g) || collisions != hp.collisions(g))
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char * argv[])
+{
+  int population = int_arg(argc, argv, 1, 1000);
+  int generations = int_arg(argc, argv, 2, 300);
+  int threads = int_arg(argc, argv, 3, thread::hardware_concurrency());
+  const string protein = "BWBWWBBWBWWBWBBWWBWB";
+  bool ok = true;
+
+  bool scored = check_scoring<SquareLattice>(protein, 10000)
+    && check_scoring<TriangularLattice>(protein, 10000)
+    && check_scoring<CubicLattice>(protein, 10000)
+    && check_scoring<FCCLattice>(protein, 10000);
+  cout << " HP scoring against all pairs: " << (scored ? "agrees" : "DISAGREES") << endl;
+  ok = scored && ok;
+
+  TextFitness text("Hello World!");
+  GeneticAlgorithm guess(text, 400, 0.9, -1, 2, 1, 1, 1);
+  guess.initialize();
+  while (guess.get_best_fitness() < 0 && guess.get_generation() < 1000)
+    guess.step();
+  cout << " \"" << text.text(guess.get_best()) << "\" after " << guess.get_generation()
+       << " generations of " << guess.get_population() << endl;
+  ok = guess.get_best_fitness() == 0 && ok;
+
+  cout << endl << " " << protein << ", population " << population << ", "
+       << generations << " generations, square lattice ground state E = -9" << endl
+       << setw(12) << "lattice" << setw(10) << "crossover" << setw(8) << "E"
+       << setw(12) << "generation" << endl;
+  char const * names[3] = { "one point", "two point", "uniform" };
+  int lowest = 0;
+  for (int c = GeneticAlgorithm::ONE_POINT; c <= GeneticAlgorithm::UNIFORM; c++) {
+    HPFitness hp(protein);
+    GeneticAlgorithm ga(hp, population, 0.9, -1, 3, 2, threads, 7);
+    ga.set_crossover(c);
+    ga.run(generations);
+    const vector<double>& history = ga.get_history_best();
+    int found = int(find(history.begin(), history.end(), history.back()) - history.begin());
+    cout << setw(12) << "square" << setw(10) << names[c] << setw(8) << hp.energy(ga.get_best())
+	 << setw(12) << found << endl;
+    if (hp.collisions(ga.get_best()) == 0)
+      lowest = min(lowest, hp.energy(ga.get_best()));
+  }
+  {
+    CubicHPFitness hp(protein);
+    GeneticAlgorithm ga(hp, population, 0.9, -1, 3, 2, threads, 7);
+    ga.run(generations);
+    const vector<double>& history = ga.get_history_best();
+    int found = int(find(history.begin(), history.end(), history.back()) - history.begin());
+    cout << setw(12) << "cubic" << setw(10) << names[1] << setw(8) << hp.energy(ga.get_best())
+	 << setw(12) << found << endl;
+  }
+  ok = lowest >= -9 && lowest < 0 && ok;
+
+  // the same seed with one thread and with all
+  cout << endl << setw(8) << "threads" << setw(16) << "evaluations/s" << endl;
+  vector<double> reference;
+  for (int T = 1; ; T = threads) {
+    HPFitness hp(protein);
+    GeneticAlgorithm ga(hp, population, 0.9, -1, 3, 2, T, 11);
+    auto t0 = chrono::steady_clock::now();
+    ga.run(generations);
+    double t = seconds_since(t0);
+    cout << setw(8) << ga.get_threads() << setw(16) << ga.get_evaluations() / t << endl;
+    if (reference.empty())
+      reference = ga.get_history_mean();
+    else
+      ok = reference == ga.get_history_mean() && ok;
+    if (T == threads || threads <= 1)
+      break;
+  }
+
+  if (!ok) {
+    cout << " wrong scores, no solution, a fold below the ground state, or runs"
+	 << " that depend on the threads" << endl;
+    return EXIT_FAILURE;
+  }
+}
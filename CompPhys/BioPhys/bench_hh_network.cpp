@@ -0,0 +1,138 @@
+// HHNetwork against fine-step RK4 for a single neuron, the spike of
+// Fig. 12 in hodgkin-huxley.ipynb and tonic firing, then a random
+// network: neuron updates per second, synaptic events against the
+// spikes sent, and the same result with one thread and with many
+//
+//   usage: bench_hh_network [neurons] [synapses per neuron] [ms] [threads]
+#include "hh_network.h"
+#include "bench_util.h"
+#include <iomanip>
+#include <thread>
+using namespace std;
+
+// the notebook's equations, V n m h, in the convention of HHNetwork
+void flow(double I, double const y[4], double f[4])
+{
+  double V = y[0], n = y[1], m = y[2], h = y[3];
+  double an = 0.01 * (V + 55) / (1 - exp(-(V + 55) / 10)), bn = 0.125 * exp(-(V + 65) / 80);
+  double am = 0.1 * (V + 40) / (1 - exp(-(V + 40) / 10)), bm = 4 * exp(-(V + 65) / 18);
+  double ah = 0.07 * exp(-(V + 65) / 20), bh = 1 / (1 + exp(-(V + 35) / 10));
+  f[0] = I - 120 * m * m * m * h * (V - 50) - 36 * n * n * n * n * (V + 77) - 0.3 * (V + 54.387);
+  f[1] = an * (1 - n) - bn * n;
+  f[2] = am * (1 - m) - bm * m;
+  f[3] = ah * (1 - h) - bh * h;
+}
+
+void rk4(double I, double y[4], double dt)
+{
+  double k[4][4], z[4];
+  flow(I, y, k[0]);
+  for (int j = 0; j < 4; j++) z[j] = y[j] + dt / 2 * k[0][j];
+  flow(I, z, k[1]);
+  for (int j = 0; j < 4; j++) z[j] = y[j] + dt / 2 * k[1][j];
+  flow(I, z, k[2]);
+  for (int j = 0; j < 4; j++) z[j] = y[j] + dt * k[2][j];
+  flow(I, z, k[3]);
+  for (int j = 0; j < 4; j++)
+    y[j] += dt / 6 * (k[0][j] + 2 * k[1][j] + 2 * k[2][j] + k[3][j]);
+}
+
+// largest difference of V from RK4 over t_max ms, and the spikes of both
+double compare(double V0, double I, double t_max, double dt, int & spikes, int & spikes_rk4)
+{
+  HHNetwork one(1, dt, 1.0, 1);
+  one.set_V(0, V0);
+  one.set_current(I);
+  double y[4] = { V0, one.get_n(0), one.get_m(0), one.get_h(0) };
+  const double fine = 1e-4, sample = 0.05;
+  int per_sample = int(lround(sample / fine));
+  double diff = 0;
+  bool above = V0 >= 0;
+  spikes_rk4 = 0;
+  for (int s = 1; s * sample <= t_max + 1e-9; s++) {
+    for (int k = 0; k < per_sample; k++) {
+      rk4(I, y, fine);
+      if (y[0] >= 0 && !above)
+	++spikes_rk4;
+      above = y[0] >= 0;
+    }
+    one.run(s * sample - one.get_t());
+    diff = max(diff, fabs(one.get_V(0) - y[0]));
+  }
+  spikes = int(one.get_spikes());
+  return diff;
+}
+
+int main(int argc, char * argv[])
+{
+  int neurons = int_arg(argc, argv, 1, 100000);
+  int k_out = int_arg(argc, argv, 2, 100);
+  double duration = double_arg(argc, argv, 3, 100.);
+  int threads = int_arg(argc, argv, 4, thread::hardware_concurrency());
+  bool ok = true;
+
+  // Fig. 12: V(0) = -90 mV in the notebook is 25 mV here
+  cout << " single neuron against RK4 with dt = 1e-4 ms" << endl
+       << setw(10) << "dt" << setw(16) << "Fig. 12 |dV|" << setw(18) << "I = 10 |dV|"
+       << setw(10) << "spikes" << setw(8) << "RK4" << endl;
+  double previous = 0;
+  for (double dt = 0.04; dt > 0.002; dt /= 2) {
+    int s1, r1, s2, r2;
+    double d1 = compare(25., 0., 6., dt, s1, r1);
+    double d2 = compare(-65., 10., 100., dt, s2, r2);
+    cout << setw(10) << dt << setw(16) << d1 << setw(18) << d2 << setw(10) << s2 << setw(8) << r2 << endl;
+    // first order: the error halves with dt
+    if (previous > 0)
+      ok = d1 < 0.7 * previous && ok;
+    ok = s1 == r1 && s2 == r2 && ok;
+    previous = d1;
+  }
+
+  // a random network, 80% excitatory, each neuron driven by its own
+  // constant current across the threshold of tonic firing
+  cout << endl << " " << neurons << " neurons, " << k_out << " synapses each, "
+       << duration << " ms" << endl << setw(8) << "threads" << setw(12) << "time(s)"
+       << setw(16) << "updates/s" << setw(12) << "rate(Hz)" << setw(14) << "events"
+       << setw(12) << "expected" << endl;
+  vector<double> V_ref;
+  long long spikes_ref = -1;
+  for (int T = 1; ; T = threads) {
+    HHNetwork net(neurons, 0.025, 1.0, T);
+    net.connectRandom(k_out, 0.02, 0.1, 0.8, 1);
+    mt19937 gen(2);
+    uniform_real_distribution<> current(4., 12.), V0(-70., -50.);
+    for (int i = 0; i < neurons; i++) {
+      net.set_current(i, current(gen));
+      net.set_V(i, V0(gen));
+    }
+    net.set_record(true);
+    auto t0 = chrono::steady_clock::now();
+    net.run(duration);
+    double t = seconds_since(t0);
+
+    // every spike but those of the last delay reached all its targets
+    long long delivered = 0;
+    vector<double> const & times = net.get_spike_times();
+    for (size_t k = 0; k < times.size(); k++)
+      delivered += times[k] <= net.get_t() - 1.0 + 1e-9;
+    long long expected = delivered * k_out;
+    cout << setw(8) << net.get_threads() << setw(12) << t
+	 << setw(16) << double(neurons) * net.get_steps() / t
+	 << setw(12) << net.get_spikes() / (neurons * duration / 1000.)
+	 << setw(14) << net.get_events() << setw(12) << expected << endl;
+    ok = net.get_events() == expected && ok;
+    if (spikes_ref < 0) {
+      V_ref = net.get_V();
+      spikes_ref = net.get_spikes();
+    } else {
+      ok = net.get_V() == V_ref && net.get_spikes() == spikes_ref && ok;
+    }
+    if (T == threads || threads <= 1)
+      break;
+  }
+
+  if (!ok) {
+    cout << " disagrees with RK4, between thread counts, or lost synaptic events" << endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,160 @@
+// Local moves of Reptation: <R^2> and <Rg^2> of 6-step chains with each
+// mix of moves against exact enumeration on every lattice, the
+// acceptance of each move, and for a longer chain started as a COIL the
+// integrated autocorrelation time of R^2 in sweeps and the CPU time per
+// independent sample. For a single chain in free space reptation alone
+// stays the cheapest; the local moves relax the inside of the chain when
+// its ends cannot get out.
+//
+//   usage: bench_moves [length] [sweeps]
+#include "reptation.h"
+#include "bench_util.h"
+using namespace std;
+
+// sums of R^2 and Rg^2 over all self-avoiding extensions of walk
+template <typename L>
+void enumerate(vector<typename L::site_type>& walk, int steps, BasicSiteSet<typename L::site_type>& on,
+	       double& count, double& r2, double& rg2)
+{
+  if (int(walk.size()) == steps + 1) {
+    LatticeChainObservables<L> chain;
+    for (size_t i = 0; i < walk.size(); i++)
+      chain.add(walk[i]);
+    count += 1;
+    r2 += L::distance2(walk.front(), walk.back());
+    rg2 += chain.rg2();
+    return;
+  }
+  for (int d = 0; d < L::coordination; d++) {
+    typename L::site_type s = L::neighbour(walk.back(), d);
+    if (on.contains(s))
+      continue;
+    on.insert(s);
+    walk.push_back(s);
+    enumerate<L>(walk, steps, on, count, r2, rg2);
+    walk.pop_back();
+    on.erase(s);
+  }
+}
+
+// integrated autocorrelation time of a series, with Sokal's window
+// M >= 6 tau
+double tau_int(vector<double> const & x)
+{
+  size_t n = x.size();
+  double mean = 0;
+  for (size_t i = 0; i < n; i++)
+    mean += x[i] / n;
+  double c0 = 0;
+  for (size_t i = 0; i < n; i++)
+    c0 += (x[i] - mean) * (x[i] - mean) / n;
+  double tau = 0.5;
+  for (size_t t = 1; t < n / 2; t++) {
+    double c = 0;
+    for (size_t i = 0; i + t < n; i++)
+      c += (x[i] - mean) * (x[i + t] - mean);
+    tau += c / (n - t) / c0;
+    if (t >= 6 * tau)
+      break;
+  }
+  return tau;
+}
+
+struct Mix {
+  char const * name;
+  double w[4];
+};
+
+const Mix mixes[] = {
+  { "reptation", { 1, 0, 0, 0 } },
+  { "local", { 0, 1, 1, 1 } },
+  { "mixed", { 1, 1, 1, 1 } },
+  { "mostly local", { 1, 4, 4, 1 } },
+};
+const int n_mixes = sizeof(mixes) / sizeof(mixes[0]);
+
+template <typename L>
+bool check(char const * name)
+{
+  const int steps = 6;
+  vector<typename L::site_type> walk(1);
+  BasicSiteSet<typename L::site_type> on;
+  on.insert(walk[0]);
+  double count = 0, r2 = 0, rg2 = 0;
+  enumerate<L>(walk, steps, on, count, r2, rg2);
+  r2 /= count;
+  rg2 /= count;
+
+  bool ok = true;
+  const long long moves = 4000000;
+  for (int m = 0; m < n_mixes; m++) {
+    LatticeReptation<L> chain(steps, 0, LatticeReptation<L>::LINE);
+    chain.set_moves(mixes[m].w[0], mixes[m].w[1], mixes[m].w[2], mixes[m].w[3]);
+    chain.createSnake(steps, LatticeReptation<L>::COIL);
+    double r2sum = 0, rg2sum = 0;
+    for (long long i = 0; i < moves; i++) {
+      chain.move();
+      r2sum += chain.rSquared();
+      rg2sum += chain.rgSquared();
+    }
+    vector<double> a = chain.get_acceptance();
+    cout << setw(12) << name << setw(14) << mixes[m].name << setw(10) << r2sum / moves
+	 << setw(10) << r2 << setw(10) << rg2sum / moves << setw(10) << rg2;
+    for (int k = 0; k < 4; k++)
+      cout << setw(8) << setprecision(3) << a[k];
+    cout << setprecision(6) << endl;
+    // local moves alone need not reach every chain, the mixes must
+    if (mixes[m].w[0] > 0)
+      ok = fabs(r2sum / moves - r2) < 0.02 * r2 && fabs(rg2sum / moves - rg2) < 0.02 * rg2 && ok;
+  }
+  return ok;
+}
+
+int main(int argc, char * argv[])
+{
+  int length = int_arg(argc, argv, 1, 100);
+  int sweeps = int_arg(argc, argv, 2, 40000);
+  bool ok = true;
+
+  cout << " 6-step chains against enumeration; acceptance of reptation, kink, crankshaft, end" << endl
+       << setw(12) << "lattice" << setw(14) << "moves" << setw(10) << "<R^2>" << setw(10) << "exact"
+       << setw(10) << "<Rg^2>" << setw(10) << "exact" << setw(32) << "acceptance" << endl;
+  ok = check<SquareLattice>("square") && ok;
+  ok = check<TriangularLattice>("triangular") && ok;
+  ok = check<CubicLattice>("cubic") && ok;
+  ok = check<FCCLattice>("fcc") && ok;
+
+  // R^2 every sweep of length moves after as many sweeps again to leave
+  // the COIL; tau in sweeps, and CPU time per independent sample
+  cout << endl << " " << length << "-step chain on the square lattice from a COIL, "
+       << sweeps << " sweeps" << endl
+       << setw(14) << "moves" << setw(10) << "<R^2>" << setw(12) << "tau(sweeps)"
+       << setw(12) << "ns/move" << setw(14) << "ms/sample" << endl;
+  for (int m = 0; m < n_mixes; m++) {
+    if (mixes[m].w[0] == 0)
+      continue;
+    Reptation chain(length, 0, Reptation::COIL);
+    chain.set_moves(mixes[m].w[0], mixes[m].w[1], mixes[m].w[2], mixes[m].w[3]);
+    chain.createSnake(length, Reptation::COIL);
+    for (long long i = 0; i < (long long)sweeps * length; i++)
+      chain.move();
+    vector<double> series(sweeps);
+    double mean = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int s = 0; s < sweeps; s++) {
+      for (int i = 0; i < length; i++)
+	chain.move();
+      series[s] = chain.rSquared();
+      mean += series[s] / sweeps;
+    }
+    double ns = seconds_since(t0) * 1e9 / ((double)sweeps * length);
+    double tau = tau_int(series);
+    cout << setw(14) << mixes[m].name << setw(10) << mean << setw(12) << tau << setw(12) << ns
+	 << setw(14) << 2 * tau * length * ns * 1e-6 << endl;
+  }
+
+  if (!ok) {
+    cout << " a mix of moves disagrees with enumeration" << endl;
+    return EXIT_FAILURE;
+  }
+}
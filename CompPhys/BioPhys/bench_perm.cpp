@@ -0,0 +1,65 @@
+// PERM estimates of the number of self-avoiding walks c_n and of <R^2>
+// against exact enumeration for short walks, and the connective
+// constant and Flory exponent from long ones
+//
+//   usage: bench_perm [longest walk] [tours] [threads]
+#include "perm_walk.h"
+#include "bench_util.h"
+#include <iomanip>
+using namespace std;
+
+int main(int argc, char * argv[])
+{
+  int longest = int_arg(argc, argv, 1, 1000);
+  int tours = int_arg(argc, argv, 2, 100000);
+  int threads = int_arg(argc, argv, 3, 0);
+
+  // c_n for n = 0..16 and <R^2> at n = 16, by enumeration
+  const double c[17] = { 1, 4, 12, 36, 100, 284, 780, 2172, 5916, 16268, 44100, 120292,
+			 324932, 881500, 2374444, 6416596, 17245332 };
+  const double r2_16 = 51.992501;
+
+  PermWalk perm(longest, tours);
+  auto t0 = chrono::steady_clock::now();
+  perm.run(threads);
+  double t = seconds_since(t0);
+  cout << " " << tours << " tours to N = " << longest << " in " << t << " s, "
+       << perm.get_walks() << " walks of N steps, " << perm.get_walks() / t << " per second"
+       << endl << endl;
+
+  vector<double> const & logZ = perm.get_logZ();
+  vector<double> const & Zerr = perm.get_Zerr();
+  vector<double> const & r2 = perm.get_r2av();
+  vector<double> const & r2err = perm.get_r2err();
+  bool ok = true;
+  cout << "     n           c_n      estimate   rel. error  (sigmas)" << endl;
+  for (int n = 4; n <= min(16, longest); n += 4) {
+    double z = exp(logZ[n]);
+    double dev = (z / c[n] - 1) / Zerr[n];
+    cout << setw(6) << n << setw(14) << c[n] << setw(14) << z << setw(13) << Zerr[n]
+	 << setw(10) << dev << endl;
+    ok = ok && fabs(dev) < 4;
+  }
+  if (longest >= 16) {
+    double dev = (r2[16] - r2_16) / r2err[16];
+    cout << " <R^2>(16) = " << r2[16] << " +- " << r2err[16] << ", exact " << r2_16 << endl;
+    ok = ok && fabs(dev) < 4;
+  }
+
+  // c_n ~ A mu^n n^(gamma - 1), so c_n / c_(n-1) ~ mu (1 + (gamma - 1) / n),
+  // with gamma = 43/32; and <R^2> ~ n^(2 nu), nu = 3/4
+  vector<double> mu = perm.get_mu();
+  cout << endl << "     n       c_n/c_(n-1)    mu estimate         <R^2>    2 nu" << endl;
+  for (int n = 10; n <= longest; n *= 10) {
+    double m = exp((logZ[n] - logZ[n / 2]) / (n - n / 2));
+    cout << setw(6) << n << setw(18) << mu[n - 1]
+	 << setw(15) << m / (1 + (43. / 32 - 1) * log(2.) / (n - n / 2))
+	 << setw(14) << r2[n] << setw(8) << log(r2[n] / r2[n / 2]) / log(2.) << endl;
+  }
+  cout << " connective constant 2.638159" << endl;
+
+  if (!ok) {
+    cout << " estimates do not match the enumeration" << endl;
+    return EXIT_FAILURE;
+  }
+}
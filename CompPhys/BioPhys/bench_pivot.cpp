@@ -0,0 +1,58 @@
+// Pivot sampling of self-avoiding walks against simple sampling with
+// SAWalk for short walks, and its cost and the Flory exponent for long
+// ones, <R^2> ~ N^(2 nu) with nu = 3/4 in two dimensions
+//
+//   usage: bench_pivot [longest walk] [samples]
+#include "pivot_walk.h"
+#include "sawalk.h"
+#include "bench_util.h"
+#include <iomanip>
+using namespace std;
+
+int main(int argc, char * argv[])
+{
+  int longest = int_arg(argc, argv, 1, 100000);
+  int samples = int_arg(argc, argv, 2, 1000);
+
+  // short walks both ways, against <R^2> from enumerating all 17245332
+  // walks of 16 steps; the error bar is one standard error
+  int n = 16, n_walks = 20000;
+  double exact = 51.992501;
+  SAWalk simple(n, n_walks);
+  auto t0 = chrono::steady_clock::now();
+  simple.run();
+  double t_simple = seconds_since(t0);
+  PivotWalk pivot(n, 10 * n_walks, 10);
+  t0 = chrono::steady_clock::now();
+  pivot.run();
+  double t_pivot = seconds_since(t0);
+  cout << " N = " << n << ": simple sampling <R^2> = " << simple.get_r2av() << " +- "
+       << simple.get_stdDev() / sqrt(n_walks) << " in " << t_simple << " s, "
+       << simple.get_failed_walks() << " walks discarded" << endl
+       << "         pivot           <R^2> = " << pivot.get_r2av() << " in " << t_pivot
+       << " s, acceptance " << pivot.get_acceptance() << endl
+       << "         exact           <R^2> = " << exact << endl;
+  bool ok = fabs(simple.get_r2av() - exact) < 4 * simple.get_stdDev() / sqrt(n_walks)
+    && fabs(pivot.get_r2av() - exact) < 0.01 * exact;
+
+  cout << endl << "        N  acceptance   us/pivot        <R^2>       <Rg^2>    2 nu" << endl;
+  double r2_last = 0;
+  for (int steps = 100; steps <= longest; steps *= 10) {
+    PivotWalk walk(steps, samples);
+    t0 = chrono::steady_clock::now();
+    walk.run();
+    double t = seconds_since(t0);
+    cout << setw(9) << steps << setw(12) << walk.get_acceptance()
+	 << setw(11) << 1e6 * t / walk.get_attempts() << setw(13) << walk.get_r2av()
+	 << setw(13) << walk.get_rg2av();
+    if (r2_last > 0)
+      cout << setw(8) << log10(walk.get_r2av() / r2_last);
+    cout << endl;
+    r2_last = walk.get_r2av();
+  }
+
+  if (!ok) {
+    cout << " sampled <R^2> does not match the enumeration" << endl;
+    return EXIT_FAILURE;
+  }
+}
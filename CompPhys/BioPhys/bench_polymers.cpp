@@ -0,0 +1,121 @@
+// The walkers on each lattice of lattice.h against exact enumeration of
+// short self-avoiding walks, reptation moves per second, and the
+// bead-spring chain: its running energy against a sum over all pairs,
+// and the Flory exponent, 2 nu = 1.176 in three dimensions, from <R^2>
+// of successive chains against their number of bonds. The exponent of
+// the two longest must agree within three standard errors plus 0.05,
+// which allows for the corrections to scaling: about 0.05 at 31 -> 63
+// bonds and 0.03 at 63 -> 127
+//
+//   usage: bench_polymers [steps] [walks] [longest chain] [sweeps]
+#include "bead_spring.h"
+#include "reptation.h"
+#include "sawalk.h"
+#include "bench_util.h"
+#include <iomanip>
+using namespace std;
+
+// number of walks of n more steps from s, and the sum of their R^2
+template <typename L>
+void enumerate(typename L::site_type s, typename L::site_type origin, int n,
+	       BasicSiteSet<typename L::site_type> & sites, long long & count, double & r2sum)
+{
+  if (n == 0) {
+    ++count;
+    r2sum += L::distance2(s, origin);
+    return;
+  }
+  for (int d = 0; d < L::coordination; d++) {
+    typename L::site_type t = L::neighbour(s, d);
+    if (sites.insert(t)) {
+      enumerate<L>(t, origin, n - 1, sites, count, r2sum);
+      sites.erase(t);
+    }
+  }
+}
+
+template <typename L>
+bool compare(char const * name, int steps, int walks)
+{
+  typename L::site_type origin = typename L::site_type();
+  BasicSiteSet<typename L::site_type> sites;
+  sites.insert(origin);
+  long long count = 0;
+  double r2sum = 0;
+  enumerate<L>(origin, origin, steps, sites, count, r2sum);
+  double exact = r2sum / count;
+
+  LatticeSAWalk<L> saw(steps, walks);
+  saw.run();
+  double sawError = saw.get_stdDev() / sqrt(double(walks));
+
+  // reptation samples are correlated; compare with a generous margin
+  LatticeReptation<L> rep(steps, 100 * walks, LatticeReptation<L>::LINE);
+  rep.run();
+  double repR2 = rep.get_r2av().back();
+
+  auto t0 = chrono::steady_clock::now();
+  const int length = 1000, moves = 2000000;
+  LatticeReptation<L> fast(length, moves, LatticeReptation<L>::LINE);
+  fast.createSnake(length, LatticeReptation<L>::LINE);
+  for (int i = 0; i < moves; i++)
+    fast.reptate();
+  double rate = moves / seconds_since(t0);
+
+  cout << setw(12) << name << setw(14) << count << setw(12) << exact
+       << setw(12) << saw.get_r2av() << setw(12) << repR2 << setw(14) << rate << endl;
+  return fabs(saw.get_r2av() - exact) < 5 * sawError && fabs(repR2 - exact) < 0.05 * exact;
+}
+
+int main(int argc, char * argv[])
+{
+  int steps = int_arg(argc, argv, 1, 6);
+  int walks = int_arg(argc, argv, 2, 100000);
+  int longest = int_arg(argc, argv, 3, 128);
+  int sweeps = int_arg(argc, argv, 4, 40000);
+
+  cout << " walks of " << steps << " steps: exact <R^2>, simple sampling, reptation;"
+       << " reptation moves/s at length 1000" << endl
+       << setw(12) << "lattice" << setw(14) << "walks" << setw(12) << "exact"
+       << setw(12) << "SAWalk" << setw(12) << "reptation" << setw(14) << "moves/s" << endl;
+  bool ok = compare<SquareLattice>("square", steps, walks);
+  ok = compare<TriangularLattice>("triangular", steps, walks) && ok;
+  ok = compare<CubicLattice>("cubic", steps, walks) && ok;
+  ok = compare<FCCLattice>("fcc", steps, walks) && ok;
+
+  cout << endl << " bead-spring chain, " << sweeps << " sweeps" << endl
+       << setw(8) << "beads" << setw(10) << "accepted" << setw(8) << "pivots"
+       << setw(12) << "<R^2>" << setw(10) << "+-" << setw(12) << "<Rg^2>" << setw(10) << "2 nu"
+       << setw(10) << "+-" << setw(14) << "energy drift" << setw(12) << "us/sweep" << endl;
+  double previous = 0, previous_err = 0, two_nu = 0, two_nu_err = 0;
+  for (int n = 8; n <= longest; n *= 2) {
+    BeadSpring chain(n, sweeps, sweeps / 4);
+    chain.seed(n);
+    chain.grow();
+    auto t0 = chrono::steady_clock::now();
+    chain.run();
+    double t = seconds_since(t0);
+    double drift = fabs(chain.get_energy() - chain.energy()) / n;
+    double r2 = chain.get_r2av(), r2err = chain.get_r2err();
+    cout << setw(8) << n << setprecision(3) << setw(10) << chain.get_acceptance()
+	 << setw(8) << chain.get_pivot_acceptance() << setprecision(6) << setw(12) << r2 << setw(10) << r2err << setw(12) << chain.get_rg2av();
+    if (previous > 0) {
+      double bonds = log((n - 1.) / (n / 2 - 1.));
+      two_nu = log(r2 / previous) / bonds;
+      two_nu_err = sqrt(pow(r2err / r2, 2) + pow(previous_err / previous, 2)) / bonds;
+      cout << setw(10) << two_nu << setw(10) << two_nu_err;
+    } else
+      cout << setw(20) << "";
+    cout << setw(14) << drift << setw(12) << 1e6 * t / (1.25 * sweeps) << endl;
+    previous = r2;
+    previous_err = r2err;
+    ok = drift < 1e-8 && ok;
+  }
+  bool flory = two_nu == 0 || fabs(two_nu - 1.176) < 3 * two_nu_err + 0.05;
+  ok = flory && ok;
+
+  if (!ok) {
+    cout << " samples disagree with enumeration, the energy drifted, or 2 nu is off" << endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,89 @@
+// Reptation moves per second for long chains, and run() against
+// runParallel() over all lengths up to 200; runParallel() has to give the
+// same averages and snapshots for every thread count
+//
+//   usage: bench_reptation [length] [moves] [max threads]
+#include "reptation.h"
+#include "bench_util.h"
+#include <new>
+#include <thread>
+using namespace std;
+
+// heap allocations so far, to check that moves make none
+static long allocations = 0;
+
+void * operator new(size_t n)
+{
+  ++allocations;
+  if (void * p = malloc(n))
+    return p;
+  throw bad_alloc();
+}
+
+void operator delete(void * p) noexcept { free(p); }
+
+int main(int argc, char * argv[])
+{
+  int length = int_arg(argc, argv, 1, 10000);
+  int moves = int_arg(argc, argv, 2, 10000000);
+  int max_threads = int_arg(argc, argv, 3, thread::hardware_concurrency());
+
+  cout << "  length   config     moves/s   accepted        <r^2>  allocations" << endl;
+  char const * names[3] = { "stair", "coil", "line" };
+  for (int config = Reptation::STAIR; config <= Reptation::LINE; config++) {
+    Reptation r(length, moves, config);
+    r.createSnake(length, config);
+    long allocated = allocations;
+    auto t0 = chrono::steady_clock::now();
+    int success = 0;
+    double r2sum = 0;
+    for (int i = 0; i < moves; i++) {
+      if (r.reptate())
+	++success;
+      r2sum += r.rSquared();
+    }
+    double t = seconds_since(t0);
+    cout << setw(8) << length << setw(9) << names[config] << setw(12) << moves / t
+	 << setw(11) << success / double(moves) << setw(13) << r2sum / moves
+	 << setw(13) << allocations - allocated << endl;
+  }
+
+  // the ensemble, 10^5 moves per length; run() without snapshots, since
+  // it would keep all 2 10^7 of them
+  int n_steps = 200, n_walks = 100000;
+  Reptation serial(n_steps, n_walks, Reptation::COIL);
+  auto t0 = chrono::steady_clock::now();
+  serial.run();
+  double t1 = seconds_since(t0);
+  cout << endl << " threads     moves/s  speedup   <r^2>(50)  <r^2>(100)  <r^2>(200)  snakes  same" << endl;
+  auto report = [&](char const * what, double t, Reptation const & r) {
+    cout << setw(8) << what << setw(12) << double(n_steps) * n_walks / t << setw(9) << t1 / t
+	 << setw(12) << r.get_r2av()[49] << setw(12) << r.get_r2av()[99]
+	 << setw(12) << r.get_r2av()[199] << setw(8) << r.get_snakes().size();
+  };
+  report("run()", t1, serial);
+  cout << endl;
+  bool ok = true;
+  vector<double> r2_first;
+  vector< deque<Reptation::site_type> > snakes_first;
+  for (int threads = 1; threads <= max(2, max_threads); threads *= 2) {
+    Reptation parallel(n_steps, n_walks, Reptation::COIL, true);
+    t0 = chrono::steady_clock::now();
+    parallel.runParallel(threads, 0, 1000, 1);
+    double t = seconds_since(t0);
+    report(to_string(threads).c_str(), t, parallel);
+    if (threads == 1) {
+      r2_first = parallel.get_r2av();
+      snakes_first = parallel.get_snakes();
+      cout << endl;
+      continue;
+    }
+    bool same = parallel.get_r2av() == r2_first && parallel.get_snakes() == snakes_first;
+    cout << setw(6) << (same ? "yes" : "no") << endl;
+    ok = ok && same;
+  }
+  if (!ok) {
+    cout << " runParallel() depends on the number of threads" << endl;
+    return EXIT_FAILURE;
+  }
+}
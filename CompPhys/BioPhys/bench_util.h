@@ -0,0 +1,27 @@
+#ifndef bench_util_h
+#define bench_util_h
+
+#include <chrono>
+#include <cstdlib>
+
+// Helpers shared by the bench_*.cpp programs of this directory, whose
+// arguments are all optional and positional, as in their usage lines
+
+// wall-clock seconds since t0
+inline double seconds_since(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// command line argument i, or value if there are fewer
+inline int int_arg(int argc, char * argv[], int i, int value)
+{
+  return argc > i ? std::atoi(argv[i]) : value;
+}
+
+inline double double_arg(int argc, char * argv[], int i, double value)
+{
+  return argc > i ? std::atof(argv[i]) : value;
+}
+
+#endif
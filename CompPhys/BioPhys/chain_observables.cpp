@@ -0,0 +1,221 @@
+#include "chain_observables.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+template <typename L>
+LatticeStructureFactor<L>::LatticeStructureFactor(int grid_in, int batch_in) :
+    M(2), batch(max(1, batch_in)), points(1), samples(0)
+{
+    while (M < grid_in)
+        M *= 2;
+    for (int a = 0; a < D; a++)
+        points *= M;
+    sum.assign(points, 0.);
+
+    int bits = 0;
+    while ((1 << bits) < M)
+        ++bits;
+    reversed.resize(M);
+    for (int j = 0; j < M; j++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((j >> b) & 1) << (bits - 1 - b);
+        reversed[j] = r;
+    }
+    for (int j = 0; j < M / 2; j++)
+        twiddle.push_back(polar(1.0, -2 * M_PI * j / M));
+    work.resize(M);
+
+    // the inverse metric gives |q|^2 = (2 pi / M)^2 k^T G^-1 k
+    double G[3][3], Ginv[3][3];
+    lattice_metric<L>(G);
+    if (D == 2) {
+        double det = G[0][0] * G[1][1] - G[0][1] * G[1][0];
+        Ginv[0][0] = G[1][1] / det;
+        Ginv[1][1] = G[0][0] / det;
+        Ginv[0][1] = -G[0][1] / det;
+        Ginv[1][0] = -G[1][0] / det;
+    } else {
+        for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++) {
+                int a1 = (b + 1) % 3, a2 = (b + 2) % 3, b1 = (a + 1) % 3, b2 = (a + 2) % 3;
+                Ginv[a][b] = G[a1][b1] * G[a2][b2] - G[a1][b2] * G[a2][b1];
+            }
+        double det = G[0][0] * Ginv[0][0] + G[0][1] * Ginv[1][0] + G[0][2] * Ginv[2][0];
+        for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++)
+                Ginv[a][b] /= det;
+    }
+
+    // shifts by M/2 along some axes that leave the phase of every bond,
+    // and so of every site reached from the origin, unchanged
+    vector< vector<int> > aliases;
+    site_type origin = site_type();
+    for (int h = 0; h < (1 << D); h++) {
+        bool same = true;
+        for (int d = 0; d < L::coordination; d++) {
+            long long c[3];
+            site_coords(L::neighbour(origin, d), c);
+            long long phase = 0;
+            for (int a = 0; a < D; a++)
+                phase += ((h >> a) & 1) * (M / 2) * c[a];
+            same = same && phase % M == 0;
+        }
+        if (same) {
+            aliases.push_back(vector<int>(D));
+            for (int a = 0; a < D; a++)
+                aliases.back()[a] = ((h >> a) & 1) * (M / 2);
+        }
+    }
+
+    minus.resize(points);
+    bin.resize(points);
+    double dq = 2 * M_PI / M;
+    int images = 1;
+    for (int a = 0; a < D; a++)
+        images *= 3;
+    for (int k = 0; k < points; k++) {
+        int c[3], m = 0, stride = 1;
+        for (int a = 0; a < D; a++, stride *= M) {
+            c[a] = (k / stride) % M;
+            m += ((M - c[a]) & (M - 1)) * stride;
+        }
+        minus[k] = m;
+        // the shortest wave vector with the phases of k
+        double q2 = -1;
+        for (size_t h = 0; h < aliases.size(); h++)
+            for (int i = 0; i < images; i++) {
+                double v[3];
+                for (int a = 0, j = i; a < D; a++, j /= 3) {
+                    int w = (c[a] + aliases[h][a]) & (M - 1);
+                    v[a] = (w > M / 2 ? w - M : w) + M * (j % 3 - 1);
+                }
+                double r = 0;
+                for (int a = 0; a < D; a++)
+                    for (int b = 0; b < D; b++)
+                        r += Ginv[a][b] * v[a] * v[b];
+                if (q2 < 0 || r < q2)
+                    q2 = r;
+            }
+        double q = dq * sqrt(max(0.0, q2));
+        int b = int(q / dq + 0.5);
+        if (b == 0) {
+            bin[k] = -1;
+            continue;
+        }
+        if (b >= int(count.size())) {
+            count.resize(b + 1, 0);
+            q_shell.resize(b + 1, 0.);
+        }
+        bin[k] = b;
+        ++count[b];
+        q_shell[b] += q;
+    }
+    for (size_t b = 0; b < count.size(); b++)
+        if (count[b] > 0)
+            q_shell[b] /= count[b];
+}
+
+template <typename L>
+void LatticeStructureFactor<L>::fft(vector< complex<double> >& f) {
+    for (int a = 0, stride = 1; a < D; a++, stride *= M) {
+        for (int base = 0; base < points; base++) {
+            if ((base / stride) % M != 0)
+                continue;           // one line along axis a from each base
+            for (int j = 0; j < M; j++)
+                work[reversed[j]] = f[base + j * stride];
+            for (int len = 2; len <= M; len *= 2) {
+                int step = M / len;
+                for (int i = 0; i < M; i += len)
+                    for (int j = 0; j < len / 2; j++) {
+                        complex<double> u = work[i + j], t = twiddle[j * step] * work[i + j + len / 2];
+                        work[i + j] = u + t;
+                        work[i + j + len / 2] = u - t;
+                    }
+            }
+            for (int j = 0; j < M; j++)
+                f[base + j * stride] = work[j];
+        }
+    }
+}
+
+template <typename L>
+void LatticeStructureFactor<L>::flush() {
+    size_t chains = starts.size();
+    if (chains == 0)
+        return;
+    starts.push_back(pending.size());
+    vector< complex<double> > f(points);
+    for (size_t c = 0; c < chains; c += 2) {
+        bool pair = c + 1 < chains;
+        fill(f.begin(), f.end(), complex<double>(0, 0));
+        for (size_t i = starts[c]; i < starts[c + 1]; i++)
+            f[pending[i]] += 1.;
+        if (pair)
+            for (size_t i = starts[c + 1]; i < starts[c + 2]; i++)
+                f[pending[i]] += complex<double>(0, 1);
+        fft(f);
+        double na = double(starts[c + 1] - starts[c]);
+        if (!pair) {
+            for (int k = 0; k < points; k++)
+                sum[k] += norm(f[k]) / na;
+            continue;
+        }
+        // the transforms of the real and imaginary parts, from f(k) and f(-k)
+        double nb = double(starts[c + 2] - starts[c + 1]);
+        for (int k = 0; k < points; k++) {
+            complex<double> z = f[k], zm = conj(f[minus[k]]);
+            sum[k] += norm(z + zm) / (4 * na) + norm(z - zm) / (4 * nb);
+        }
+    }
+    samples += chains;
+    pending.clear();
+    starts.clear();
+}
+
+template <typename L>
+void LatticeStructureFactor<L>::clear() {
+    fill(sum.begin(), sum.end(), 0.);
+    pending.clear();
+    starts.clear();
+    samples = 0;
+}
+
+template <typename L>
+vector<double> LatticeStructureFactor<L>::get_q() {
+    vector<double> q;
+    for (size_t b = 1; b < count.size(); b++)
+        if (count[b] > 0)
+            q.push_back(q_shell[b]);
+    return q;
+}
+
+template <typename L>
+vector<double> LatticeStructureFactor<L>::get_S() {
+    flush();
+    vector<double> shell(count.size(), 0.);
+    for (int k = 0; k < points; k++)
+        if (bin[k] > 0)
+            shell[bin[k]] += sum[k];
+    vector<double> S;
+    for (size_t b = 1; b < count.size(); b++)
+        if (count[b] > 0)
+            S.push_back(samples > 0 ? shell[b] / (count[b] * double(samples)) : 0.);
+    return S;
+}
+
+template <typename L>
+vector<double> LatticeStructureFactor<L>::get_grid_S() {
+    flush();
+    vector<double> S(points, 0.);
+    if (samples > 0)
+        for (int k = 0; k < points; k++)
+            S[k] = sum[k] / samples;
+    return S;
+}
+
+template class LatticeStructureFactor<SquareLattice>;
+template class LatticeStructureFactor<TriangularLattice>;
+template class LatticeStructureFactor<CubicLattice>;
+template class LatticeStructureFactor<FCCLattice>;
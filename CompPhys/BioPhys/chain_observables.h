@@ -0,0 +1,206 @@
+#ifndef chain_observables_h
+#define chain_observables_h
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "lattice.h"
+
+// coordinates of a site, and a site from coordinates
+inline void site_coords(Site s, long long c[]) { c[0] = s.x; c[1] = s.y; }
+inline void site_coords(Site3 s, long long c[]) { c[0] = s.x; c[1] = s.y; c[2] = s.z; }
+inline void coords_site(long long const c[], Site& s) { s.x = int(c[0]); s.y = int(c[1]); }
+inline void coords_site(long long const c[], Site3& s) {
+  s.x = int(c[0]);
+  s.y = int(c[1]);
+  s.z = int(c[2]);
+}
+
+// metric of lattice L: r . r' = sum G[a][b] c_a c'_b for sites with
+// coordinates c and c', in units of the bond length, read off
+// L::distance2 so that it holds for the oblique triangular basis too
+template <typename L>
+void lattice_metric(double G[3][3])
+{
+  typedef typename L::site_type site_type;
+  const int D = L::dimension;
+  site_type origin = site_type();
+  for (int a = 0; a < D; a++)
+    for (int b = 0; b < D; b++) {
+      long long ca[3] = { 0, 0, 0 }, cb[3] = { 0, 0, 0 }, cab[3] = { 0, 0, 0 };
+      ca[a] = 1;
+      cb[b] = 1;
+      cab[a] += 1;
+      cab[b] += 1;
+      site_type sa, sb, sab;
+      coords_site(ca, sa);
+      coords_site(cb, sb);
+      coords_site(cab, sab);
+      double qa = L::distance2(sa, origin), qb = L::distance2(sb, origin);
+      G[a][b] = a == b ? qa : (L::distance2(sab, origin) - qa - qb) / 2;
+    }
+}
+
+
+// Running sums over the sites of a chain on lattice L, updated as sites
+// are added and removed in any order, so that the centre of mass and the
+// radius of gyration cost O(1) however long the chain:
+//
+//   Rg^2 = sum_ab G_ab (n M_ab - S_a S_b) / n^2
+//
+// with S and M the sums of the coordinates and of their products about
+// an origin and G the lattice metric. The sums are integers, so they do
+// not drift over any number of moves and n M - S S is exact; it fits in
+// 64 bits while n |c - origin| stays below about 2^30.
+template <typename L>
+class LatticeChainObservables {
+public:
+  typedef typename L::site_type site_type;
+  enum { D = L::dimension };
+
+  LatticeChainObservables() { lattice_metric<L>(G); clear(); }
+
+  // no sites, coordinates taken about origin
+  void clear(site_type origin_in = site_type()) {
+    site_coords(origin_in, origin);
+    n = 0;
+    for (int a = 0; a < D; a++) {
+      S[a] = 0;
+      for (int b = 0; b < D; b++)
+	M[a][b] = 0;
+    }
+  }
+
+  void add(site_type s) { update(s, 1); }
+  void remove(site_type s) { update(s, -1); }
+
+  long long size() const { return n; }
+
+  double rg2() const {
+    if (n == 0)
+      return 0.0;
+    double r = 0;
+    for (int a = 0; a < D; a++)
+      for (int b = 0; b < D; b++)
+	r += G[a][b] * double(n * M[a][b] - S[a] * S[b]);
+    return r / (double(n) * n);
+  }
+
+  // centre of mass in the coordinates of the sites
+  std::vector<double> center() const {
+    std::vector<double> c(D);
+    for (int a = 0; a < D; a++)
+      c[a] = origin[a] + (n > 0 ? double(S[a]) / n : 0.0);
+    return c;
+  }
+
+protected:
+  void update(site_type s, int sign) {
+    long long c[3];
+    site_coords(s, c);
+    for (int a = 0; a < D; a++)
+      c[a] -= origin[a];
+    n += sign;
+    for (int a = 0; a < D; a++) {
+      S[a] += sign * c[a];
+      for (int b = 0; b < D; b++)
+	M[a][b] += sign * c[a] * c[b];
+    }
+  }
+
+  double G[3][3];             // lattice metric
+  long long origin[3];
+  long long n;                // sites
+  long long S[3];             // sum of c - origin
+  long long M[3][3];          // sum of (c - origin)_a (c - origin)_b
+};
+
+
+// Structure factor S(q) = |sum_j exp(-i q . r_j)|^2 / N of chains on
+// lattice L, averaged over the chains added and over the directions of
+// q. The sites are wrapped onto a periodic grid of M^dimension points,
+// which changes nothing at the wave vectors q_k = 2 pi k / M of the grid,
+// and the sums at all of them come from one FFT of the occupation. Chains
+// are kept until batch of them are pending, then transformed two at a
+// time, one as the real and one as the imaginary part of the grid, so
+// the cost is about M^d log M / 2 per chain whatever its length.
+//
+// Wave vectors that give the same phase on every site of the lattice
+// (k + (M/2, M/2, M/2) on the FCC lattice) are the same q; each grid
+// point is binned at the shortest of them, in shells of width 2 pi / M.
+template <typename L>
+class LatticeStructureFactor {
+public:
+  typedef typename L::site_type site_type;
+  enum { D = L::dimension };
+
+  LatticeStructureFactor(int grid_in = 32,  // points per axis, rounded up to a power of two
+			 int batch_in = 16); // chains per FFT batch
+
+  // a chain of sites: anything with size() and operator[], such as the
+  // snake of Reptation or a vector of sites
+#ifndef SWIG
+  template <typename Chain>
+  void add(const Chain& chain) {
+    if (chain.size() == 0)
+      return;
+    starts.push_back(pending.size());
+    for (std::size_t i = 0; i < chain.size(); i++)
+      pending.push_back(index(chain[i]));
+    if (int(starts.size()) >= batch)
+      flush();
+  }
+#endif
+  void add(const std::vector<site_type>& chain) { add< std::vector<site_type> >(chain); }
+
+  void flush();               // transform the pending chains
+  void clear();               // no chains
+
+  int get_grid() const { return M; }
+  long long get_samples() const { return samples + (long long)starts.size(); }
+  // S(q) averaged over shells of |q| in units of the inverse bond length,
+  // the pending chains flushed first
+  std::vector<double> get_q();
+  std::vector<double> get_S();
+  // the average at each grid point, k_0 + M k_1 + M^2 k_2
+  std::vector<double> get_grid_S();
+
+protected:
+  int index(site_type s) const {
+    long long c[3];
+    site_coords(s, c);
+    int k = 0;
+    for (int a = D - 1; a >= 0; a--)
+      k = k * M + int(c[a] & (M - 1));
+    return k;
+  }
+
+  void fft(std::vector< std::complex<double> >& f);    // forward, along every axis
+
+  int M, batch, points;
+  long long samples;                          // chains transformed
+  std::vector<int> pending;                   // grid indices of the pending chains
+  std::vector<std::size_t> starts;            // first index of each pending chain
+  std::vector<double> sum;                    // sum of |rho_k|^2 / N over the chains
+  std::vector<int> minus;                     // index of -k
+  std::vector<int> bin;                       // shell of each k, -1 for q = 0
+  std::vector<double> q_shell;                // mean |q| of each shell
+  std::vector<int> count;                     // grid points in each shell
+  std::vector<int> reversed;                  // bit reversal of 0 .. M - 1
+  std::vector< std::complex<double> > twiddle;  // exp(-2 pi i j / M), j < M / 2
+  std::vector< std::complex<double> > work;
+};
+
+#ifndef SWIG
+typedef LatticeChainObservables<SquareLattice> ChainObservables;
+typedef LatticeChainObservables<TriangularLattice> TriangularChainObservables;
+typedef LatticeChainObservables<CubicLattice> CubicChainObservables;
+typedef LatticeChainObservables<FCCLattice> FCCChainObservables;
+typedef LatticeStructureFactor<SquareLattice> StructureFactor;
+typedef LatticeStructureFactor<TriangularLattice> TriangularStructureFactor;
+typedef LatticeStructureFactor<CubicLattice> CubicStructureFactor;
+typedef LatticeStructureFactor<FCCLattice> FCCStructureFactor;
+#endif
+
+#endif
@@ -0,0 +1,224 @@
+#include "genetic.h"
+#include <algorithm>
+using namespace std;
+
+unsigned Genome::get_bits(int pos, int width) const {
+    int w = pos >> 6, s = pos & 63;
+    std::uint64_t v = words[w] >> s;
+    if (s + width > 64)
+        v |= words[w + 1] << (64 - s);
+    return unsigned(v & ((std::uint64_t(1) << width) - 1));
+}
+
+void Genome::set_bits(int pos, int width, unsigned value) {
+    int w = pos >> 6, s = pos & 63;
+    std::uint64_t m = (std::uint64_t(1) << width) - 1, v = value & m;
+    words[w] = (words[w] & ~(m << s)) | (v << s);
+    if (s + width > 64) {
+        int r = 64 - s;
+        words[w + 1] = (words[w + 1] & ~(m >> r)) | (v >> r);
+    }
+}
+
+void Genome::splice(const Genome& other, int begin, int end) {
+    if (begin >= end)
+        return;
+    int wb = begin >> 6, we = (end - 1) >> 6;
+    std::uint64_t first = ~std::uint64_t(0) << (begin & 63);
+    std::uint64_t last = ~std::uint64_t(0) >> (63 - ((end - 1) & 63));
+    if (wb == we) {
+        std::uint64_t m = first & last;
+        words[wb] = (words[wb] & ~m) | (other.words[wb] & m);
+        return;
+    }
+    words[wb] = (words[wb] & ~first) | (other.words[wb] & first);
+    for (int w = wb + 1; w < we; w++)
+        words[w] = other.words[w];
+    words[we] = (words[we] & ~last) | (other.words[we] & last);
+}
+
+void Genome::blend(const Genome& a, const Genome& b, const vector<std::uint64_t>& mask) {
+    for (size_t w = 0; w < words.size(); w++)
+        words[w] = (a.words[w] & mask[w]) | (b.words[w] & ~mask[w]);
+}
+
+void Genome::randomize(mt19937_64& gen) {
+    for (size_t w = 0; w < words.size(); w++)
+        words[w] = gen();
+    clear_tail();
+}
+
+int Genome::count() const {
+    int c = 0;
+    for (size_t w = 0; w < words.size(); w++)
+        c += __builtin_popcountll(words[w]);
+    return c;
+}
+
+string Genome::str() const {
+    string s(n, '0');
+    for (int i = 0; i < n; i++)
+        if (get(i))
+            s[i] = '1';
+    return s;
+}
+
+
+unsigned TextFitness::code(const Genome& g, int i) const {
+    unsigned c = g.get_bits(8 * i, 8);
+    c ^= c >> 4;
+    c ^= c >> 2;
+    c ^= c >> 1;
+    return c;
+}
+
+double TextFitness::fitness(const Genome& g) const {
+    double f = 0;
+    for (size_t i = 0; i < target.size(); i++)
+        f -= abs(int(code(g, int(i))) - int((unsigned char)target[i]));
+    return f;
+}
+
+string TextFitness::text(const Genome& g) const {
+    string s(target.size(), ' ');
+    for (size_t i = 0; i < target.size(); i++)
+        s[i] = char(max(1u, code(g, int(i))));
+    return s;
+}
+
+
+GeneticAlgorithm::GeneticAlgorithm(const Fitness& fitness_in, int population_in,
+                                   double p_crossover_in, double p_mutation_in,
+                                   int tournament_in, int elite_in, int threads_in, int seed) :
+    problem(fitness_in), population(max(2, population_in)), n_bits(fitness_in.bits()),
+    p_crossover(p_crossover_in),
+    p_mutation(p_mutation_in < 0 ? 1. / max(1, fitness_in.bits()) : p_mutation_in),
+    tournament(max(1, tournament_in)), elite(max(0, min(elite_in, population_in))),
+    crossover(TWO_POINT), gen(seed < 0 ? random_device()() : unsigned(seed)), dis(0, 1),
+    team(threads_in), generation(0), evaluations(0), best(0)
+{
+}
+
+void GeneticAlgorithm::initialize() {
+    genomes.assign(population, Genome(n_bits));
+    children.assign(population, Genome(n_bits));
+    fitness.assign(population, 0.);
+    mask.assign((n_bits + 63) / 64, 0);
+    for (int k = 0; k < population; k++)
+        genomes[k].randomize(gen);
+    generation = 0;
+    evaluations = 0;
+    history_best.clear();
+    history_mean.clear();
+    evaluate();
+    record();
+}
+
+int GeneticAlgorithm::select() {
+    uniform_int_distribution<> pick(0, population - 1);
+    int winner = pick(gen);
+    for (int t = 1; t < tournament; t++) {
+        int k = pick(gen);
+        if (fitness[k] > fitness[winner])
+            winner = k;
+    }
+    return winner;
+}
+
+void GeneticAlgorithm::mutate(Genome& g) {
+    if (p_mutation <= 0)
+        return;
+    if (p_mutation >= 1) {
+        for (int i = 0; i < n_bits; i++)
+            g.flip(i);
+        return;
+    }
+    // gaps between flips are geometric: floor(log(u) / log(1 - p))
+    double scale = 1. / log1p(-p_mutation);
+    for (double i = floor(log(1. - dis(gen)) * scale); i < n_bits;
+         i += 1. + floor(log(1. - dis(gen)) * scale))
+        g.flip(int(i));
+}
+
+void GeneticAlgorithm::cross(const Genome& a, const Genome& b, Genome& c, Genome& d) {
+    c = a;
+    d = b;
+    if (n_bits < 2 || dis(gen) >= p_crossover)
+        return;
+    if (crossover == UNIFORM) {
+        for (size_t w = 0; w < mask.size(); w++)
+            mask[w] = gen();
+        c.blend(a, b, mask);
+        d.blend(b, a, mask);
+        return;
+    }
+    // cut points in 1 .. n_bits - 1: the middle part for TWO_POINT, the
+    // tail for ONE_POINT, comes from the other parent
+    uniform_int_distribution<> cut(1, n_bits - 1);
+    int i1 = cut(gen), i2 = n_bits;
+    if (crossover == TWO_POINT) {
+        i2 = cut(gen);
+        if (i1 > i2)
+            swap(i1, i2);
+    }
+    c.splice(b, i1, i2);
+    d.splice(a, i1, i2);
+}
+
+void GeneticAlgorithm::step() {
+    if (genomes.empty())
+        initialize();
+
+    // the elite first, fittest first
+    vector<int> order(population);
+    for (int k = 0; k < population; k++)
+        order[k] = k;
+    partial_sort(order.begin(), order.begin() + elite, order.end(),
+                 [this](int a, int b) { return fitness[a] > fitness[b]; });
+    int k = 0;
+    for (; k < elite; k++)
+        children[k] = genomes[order[k]];
+
+    Genome spare(n_bits);
+    while (k < population) {
+        int a = select(), b = select();
+        Genome& c = children[k];
+        Genome& d = k + 1 < population ? children[k + 1] : spare;
+        cross(genomes[a], genomes[b], c, d);
+        mutate(c);
+        mutate(d);
+        k += 2;
+    }
+    genomes.swap(children);
+    ++generation;
+    evaluate();
+    record();
+}
+
+void GeneticAlgorithm::run(int generations) {
+    if (genomes.empty())
+        initialize();
+    for (int g = 0; g < generations; g++)
+        step();
+}
+
+void GeneticAlgorithm::evaluate() {
+    team.parallel_for(0, population, [this](int b, int e) {
+            for (int k = b; k < e; k++)
+                fitness[k] = problem.fitness(genomes[k]);
+        }, max(1, population / (16 * team.size())));
+    evaluations += population;
+    best = int(max_element(fitness.begin(), fitness.end()) - fitness.begin());
+}
+
+double GeneticAlgorithm::get_mean_fitness() const {
+    double sum = 0;
+    for (size_t k = 0; k < fitness.size(); k++)
+        sum += fitness[k];
+    return fitness.empty() ? 0. : sum / fitness.size();
+}
+
+void GeneticAlgorithm::record() {
+    history_best.push_back(get_best_fitness());
+    history_mean.push_back(get_mean_fitness());
+}
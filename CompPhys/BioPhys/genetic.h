@@ -0,0 +1,156 @@
+#ifndef genetic_h
+#define genetic_h
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "worker_team.h"
+
+// String of bits packed 64 to a word, the chromosome of
+// GeneticAlgorithm. Bits past size() in the last word are kept zero.
+class Genome {
+public:
+  Genome(int n_bits = 0) : n(n_bits), words((n_bits + 63) / 64, 0) { }
+
+  int size() const { return n; }
+
+  bool get(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+  void set(int i, bool b) {
+    std::uint64_t bit = std::uint64_t(1) << (i & 63);
+    words[i >> 6] = b ? words[i >> 6] | bit : words[i >> 6] & ~bit;
+  }
+  void flip(int i) { words[i >> 6] ^= std::uint64_t(1) << (i & 63); }
+
+  // width <= 32 bits from pos on as an unsigned, the first the lowest
+  unsigned get_bits(int pos, int width) const;
+  void set_bits(int pos, int width, unsigned value);
+
+  // bits [begin, end) copied from other, a whole word at a time
+  void splice(const Genome& other, int begin, int end);
+  // each bit from a where mask is 1 and from b where it is 0
+  void blend(const Genome& a, const Genome& b, const std::vector<std::uint64_t>& mask);
+
+  void randomize(std::mt19937_64& gen);
+  int count() const;                          // bits set
+  std::string str() const;                    // as '0' and '1'
+
+  bool operator== (const Genome& g) const { return n == g.n && words == g.words; }
+  bool operator!= (const Genome& g) const { return !(*this == g); }
+
+  const std::vector<std::uint64_t>& get_words() const { return words; }
+
+protected:
+  void clear_tail() {
+    if (n & 63)
+      words.back() &= (std::uint64_t(1) << (n & 63)) - 1;
+  }
+
+  int n;                                      // bits
+  std::vector<std::uint64_t> words;
+};
+
+
+// A problem for GeneticAlgorithm: the genome length and the fitness of a
+// genome, larger being fitter. The fitness is called from several
+// threads at once and must not change the object.
+class Fitness {
+public:
+  virtual ~Fitness() { }
+  virtual int bits() const = 0;
+  virtual double fitness(const Genome& g) const = 0;
+};
+
+// The GuessText example of genetic.ipynb: 8 bits per character, and the
+// fitness minus the summed differences of the character codes from the
+// target, 0 when it is matched. The bits of a character are read as a
+// Gray code, so neighbouring codes are one flip apart; in plain binary
+// 'G' is four flips from 'H' and the search stalls one short.
+class TextFitness : public Fitness {
+public:
+  TextFitness(const std::string& target_in) : target(target_in) { }
+
+  int bits() const { return 8 * int(target.size()); }
+  double fitness(const Genome& g) const;
+  std::string text(const Genome& g) const;    // the genome as text
+
+protected:
+  unsigned code(const Genome& g, int i) const;  // character i, Gray decoded
+
+  std::string target;
+};
+
+
+// Genetic algorithm with tournament selection, as in genetic.ipynb: each
+// parent is the fittest of tournament genomes drawn at random, a pair of
+// parents is crossed with probability p_crossover, and every bit of a
+// child flips with probability p_mutation, 1 / bits by default. The
+// elite fittest genomes pass to the next generation unchanged.
+//
+// The children of a generation are bred on the calling thread with one
+// random stream and then evaluated on a WorkerTeam, so the run depends
+// only on the seed, not on the number of threads. Mutations are placed
+// by drawing the geometric gaps between flipped bits, so their cost is
+// proportional to the number of flips rather than of bits.
+class GeneticAlgorithm {
+public:
+  enum { ONE_POINT = 0, TWO_POINT, UNIFORM };     // crossover operators
+
+  GeneticAlgorithm(const Fitness& fitness_in,     // kept by reference, must outlive this
+		   int population_in = 400,
+		   double p_crossover_in = 0.9,
+		   double p_mutation_in = -1,       // -1: 1 / bits
+		   int tournament_in = 2,
+		   int elite_in = 1,
+		   int threads_in = 0,              // 0: one per core
+		   int seed = -1);                  // -1: random
+
+  void initialize();          // random population, evaluated
+  void step();                // breed and evaluate the next generation
+  void run(int generations);  // that many steps, initializing if need be
+
+  void set_crossover(int c) { crossover = c; }
+
+  int get_generation() const { return generation; }
+  int get_population() const { return population; }
+  int get_threads() const { return team.size(); }
+  long long get_evaluations() const { return evaluations; }
+  const Genome& get_best() const { return genomes[best]; }
+  double get_best_fitness() const { return fitness[best]; }
+  double get_mean_fitness() const;
+  const std::vector<Genome>& get_genomes() const { return genomes; }
+  const std::vector<double>& get_fitness() const { return fitness; }
+  // best and mean fitness after each generation, the initial one first
+  const std::vector<double>& get_history_best() const { return history_best; }
+  const std::vector<double>& get_history_mean() const { return history_mean; }
+
+protected:
+  int select();               // index of a tournament winner
+  void mutate(Genome& g);
+  void cross(const Genome& a, const Genome& b, Genome& c, Genome& d);
+  void evaluate();            // fitness of every genome, then best
+  void record();
+
+  const Fitness& problem;
+  int population, n_bits;
+  double p_crossover, p_mutation;
+  int tournament, elite;
+  int crossover;
+  std::mt19937_64 gen;
+  std::uniform_real_distribution<> dis;
+  WorkerTeam team;
+
+  int generation;
+  long long evaluations;
+  int best;                   // index of the fittest genome
+  std::vector<Genome> genomes, children;
+  std::vector<double> fitness;
+  std::vector<std::uint64_t> mask;          // scratch for UNIFORM
+  std::vector<double> history_best, history_mean;
+};
+
+#endif
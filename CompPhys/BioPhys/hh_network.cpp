@@ -0,0 +1,281 @@
+#include "hh_network.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+namespace {
+
+// exp(x) to a few ulp for |x| < 708, in straight-line code the compiler
+// can vectorize, unlike calls to std::exp: x = k ln 2 + r with
+// |r| <= ln 2 / 2, exp(r) by its Taylor series to r^12 / 12!, and 2^k
+// put in the exponent bits. k is rounded by adding 1.5 2^52, which
+// leaves it in the low bits of the sum. There is no clamping, which
+// would keep GCC from vectorizing; the arguments below stay within a
+// few hundred for any V within +-1000 mV.
+inline double exp_inline(double x) {
+    const double shifter = 6755399441055744.0;          // 1.5 * 2^52
+    const double log2e = 1.4426950408889634;
+    const double ln2_hi = 0.6931471805598903;           // ln 2 in two parts
+    const double ln2_lo = 5.497923018708371e-14;
+    double t = x * log2e + shifter;
+    double k = t - shifter;
+    double r = x - k * ln2_hi - k * ln2_lo;
+    double p = 1. / 479001600.;
+    p = p * r + 1. / 39916800.;
+    p = p * r + 1. / 3628800.;
+    p = p * r + 1. / 362880.;
+    p = p * r + 1. / 40320.;
+    p = p * r + 1. / 5040.;
+    p = p * r + 1. / 720.;
+    p = p * r + 1. / 120.;
+    p = p * r + 1. / 24.;
+    p = p * r + 1. / 6.;
+    p = p * r + 0.5;
+    p = p * r + 1.;
+    p = p * r + 1.;
+    int64_t bits, shifted;
+    memcpy(&shifted, &t, sizeof t);
+    memcpy(&bits, &shifter, sizeof shifter);
+    int64_t scale = (shifted - bits + 1023) << 52;
+    double s;
+    memcpy(&s, &scale, sizeof s);
+    return p * s;
+}
+
+// x / (1 - exp(-x / y)), which tends to y at x = 0; within 1e-6 y of
+// there, x is moved away by 2e-6 y, which changes it by 1e-6, instead of
+// branching to the limit
+inline double vtrap(double x, double y) {
+    double u = x / y;
+    u += fabs(u) < 1e-6 ? 2e-6 : 0.;
+    return y * u / (1. - exp_inline(-u));
+}
+
+struct Constants {
+    double gNa, gK, gL, ENa, EK, EL, Ee, Ei;
+    double dt, dtC;             // dt and dt / C_M
+    double decay_e, decay_i;    // exp(-dt / tau_e), exp(-dt / tau_i)
+};
+
+// One step of neurons [b, e). The arrays are restrict parameters, not
+// locals, since GCC only trusts the former not to overlap and would
+// otherwise need more run-time overlap checks than it is willing to make.
+void rushLarsen(int b, int e, double * __restrict V, double * __restrict n,
+                double * __restrict m, double * __restrict h, double * __restrict ge,
+                double * __restrict gi, double const * __restrict I, Constants c) {
+    for (int i = b; i < e; i++) {
+        double v = V[i];
+        double an = 0.01 * vtrap(v + 55., 10.), bn = 0.125 * exp_inline(-(v + 65.) / 80.);
+        double am = 0.1 * vtrap(v + 40., 10.), bm = 4. * exp_inline(-(v + 65.) / 18.);
+        double ah = 0.07 * exp_inline(-(v + 65.) / 20.), bh = 1. / (1. + exp_inline(-(v + 35.) / 10.));
+        double sn = an + bn, sm = am + bm, sh = ah + bh;
+        double xn = an / sn, xm = am / sm, xh = ah / sh;
+        double gn = xn + (n[i] - xn) * exp_inline(-c.dt * sn);
+        double gm = xm + (m[i] - xm) * exp_inline(-c.dt * sm);
+        double gh = xh + (h[i] - xh) * exp_inline(-c.dt * sh);
+        n[i] = gn;
+        m[i] = gm;
+        h[i] = gh;
+
+        double g1 = c.gNa * gm * gm * gm * gh, g2 = c.gK * gn * gn * gn * gn;
+        double e1 = ge[i], e2 = gi[i];
+        double g = g1 + g2 + c.gL + e1 + e2;
+        double vinf = (I[i] + g1 * c.ENa + g2 * c.EK + c.gL * c.EL + e1 * c.Ee + e2 * c.Ei) / g;
+        V[i] = vinf + (v - vinf) * exp_inline(-c.dtC * g);
+        ge[i] = e1 * c.decay_e;
+        gi[i] = e2 * c.decay_i;
+    }
+}
+
+// Threads wait here until all have arrived
+class Barrier {
+public:
+    Barrier(int n_in) : n(n_in), waiting(0), generation(0) { }
+
+    void wait() {
+        unique_lock<mutex> lock(m);
+        unsigned long g = generation;
+        if (++waiting == n) {
+            waiting = 0;
+            ++generation;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [this, g]() { return generation != g; });
+        }
+    }
+
+private:
+    int n, waiting;
+    unsigned long generation;
+    mutex m;
+    condition_variable cv;
+};
+
+} // namespace
+
+HHNetwork::HHNetwork(int n_neurons_in, double dt_in, double delay_in, int threads_in) :
+    n_neurons(n_neurons_in), dt(dt_in), threads(threads_in), record(false),
+    V(n_neurons_in), n(n_neurons_in), m(n_neurons_in), h(n_neurons_in),
+    ge(n_neurons_in), gi(n_neurons_in), I_ext(n_neurons_in, 0.),
+    above(n_neurons_in), excitatory(n_neurons_in, 1), row(n_neurons_in + 1, 0)
+{
+    delay_steps = max(1, int(lround(delay_in / dt)));
+    if (threads <= 0)
+        threads = thread::hardware_concurrency();
+    threads = max(1, min(threads, max(1, n_neurons / 64)));
+    team.reset(new WorkerTeam(threads));
+    reset();
+}
+
+void HHNetwork::reset() {
+    const double v0 = -65.;
+    double an = 0.01 * vtrap(v0 + 55., 10.), bn = 0.125 * exp(-(v0 + 65.) / 80.);
+    double am = 0.1 * vtrap(v0 + 40., 10.), bm = 4. * exp(-(v0 + 65.) / 18.);
+    double ah = 0.07 * exp(-(v0 + 65.) / 20.), bh = 1. / (1. + exp(-(v0 + 35.) / 10.));
+    for (int i = 0; i < n_neurons; i++) {
+        V[i] = v0;
+        n[i] = an / (an + bn);
+        m[i] = am / (am + bm);
+        h[i] = ah / (ah + bh);
+        ge[i] = gi[i] = 0.;
+        above[i] = V[i] >= threshold;
+    }
+    steps = n_spikes = n_events = 0;
+    spikes.assign(delay_steps + 1, vector< vector<int> >(threads));
+    spike_times.clear();
+    spike_neurons.clear();
+}
+
+void HHNetwork::connect(vector<int> const & pre, vector<int> const & post,
+                        vector<double> const & w) {
+    // counting sort by presynaptic neuron, then each row by target
+    row.assign(n_neurons + 1, 0);
+    for (size_t k = 0; k < pre.size(); k++)
+        ++row[pre[k] + 1];
+    for (int i = 0; i < n_neurons; i++)
+        row[i + 1] += row[i];
+    vector<int> fill(row.begin(), row.end() - 1);
+    vector< pair<int, double> > synapses(pre.size());
+    for (size_t k = 0; k < pre.size(); k++)
+        synapses[fill[pre[k]]++] = make_pair(post[k], w[k]);
+    target.resize(pre.size());
+    weight.resize(pre.size());
+    for (int i = 0; i < n_neurons; i++) {
+        sort(synapses.begin() + row[i], synapses.begin() + row[i + 1]);
+        for (int k = row[i]; k < row[i + 1]; k++) {
+            target[k] = synapses[k].first;
+            weight[k] = synapses[k].second;
+        }
+    }
+}
+
+void HHNetwork::connectRandom(int k_out, double w_exc, double w_inh,
+                              double fraction_exc, int seed) {
+    mt19937 gen(seed < 0 ? random_device()() : unsigned(seed));
+    uniform_int_distribution<> dis(0, n_neurons - 2);
+    int n_exc = int(lround(fraction_exc * n_neurons));
+    k_out = min(k_out, n_neurons - 1);
+
+    vector<int> pre, post;
+    vector<double> w;
+    pre.reserve(size_t(n_neurons) * k_out);
+    post.reserve(size_t(n_neurons) * k_out);
+    w.reserve(size_t(n_neurons) * k_out);
+    vector<int> chosen;
+    for (int i = 0; i < n_neurons; i++) {
+        excitatory[i] = i < n_exc;
+        // distinct targets, skipping i itself
+        chosen.clear();
+        while (int(chosen.size()) < k_out) {
+            int j = dis(gen);
+            j += j >= i;
+            if (find(chosen.begin(), chosen.end(), j) == chosen.end())
+                chosen.push_back(j);
+        }
+        for (int j : chosen) {
+            pre.push_back(i);
+            post.push_back(j);
+            w.push_back(i < n_exc ? w_exc : w_inh);
+        }
+    }
+    connect(pre, post, w);
+}
+
+long long HHNetwork::deliver(int b, int e, int slot) {
+    long long events = 0;
+    for (int t = 0; t < threads; t++) {
+        vector<int> const & list = spikes[slot][t];
+        for (size_t s = 0; s < list.size(); s++) {
+            int i = list[s];
+            vector<double> & g = excitatory[i] ? ge : gi;
+            int k = int(lower_bound(target.begin() + row[i], target.begin() + row[i + 1], b)
+                        - target.begin());
+            for (; k < row[i + 1] && target[k] < e; k++) {
+                g[target[k]] += weight[k];
+                ++events;
+            }
+        }
+    }
+    return events;
+}
+
+void HHNetwork::integrate(int b, int e) {
+    Constants c = { g_Na, g_K, g_L, E_Na, E_K, E_L, E_e, E_i, dt, dt / C_M,
+                    exp(-dt / tau_e), exp(-dt / tau_i) };
+    rushLarsen(b, e, &V[0], &n[0], &m[0], &h[0], &ge[0], &gi[0], &I_ext[0], c);
+}
+
+void HHNetwork::detect(int b, int e, vector<int> & spiked) {
+    spiked.clear();
+    for (int i = b; i < e; i++) {
+        unsigned char a = V[i] >= threshold;
+        if (a && !above[i])
+            spiked.push_back(i);
+        above[i] = a;
+    }
+}
+
+void HHNetwork::run(double duration) {
+    long long n_steps = llround(duration / dt);
+    int slots = delay_steps + 1;
+    Barrier barrier(threads);
+    vector<long long> events(threads, 0);
+    long long first = steps;
+
+    // blocks of whole cache lines
+    vector<int> block(threads + 1);
+    for (int t = 0; t <= threads; t++)
+        block[t] = t == threads ? n_neurons : int(((long long)n_neurons * t / threads) & ~7LL);
+
+    // step s delivers the spikes of step s - delay_steps, in slot
+    // (s + 1) mod slots, and writes its own to slot s mod slots, which no
+    // thread reads until after the barrier; then thread 0 records them
+    auto work = [&](int t) {
+        for (long long s = first; s < first + n_steps; s++) {
+            events[t] += deliver(block[t], block[t + 1], int((s + 1) % slots));
+            integrate(block[t], block[t + 1]);
+            detect(block[t], block[t + 1], spikes[s % slots][t]);
+            barrier.wait();
+            if (t == 0) {
+                for (int u = 0; u < threads; u++) {
+                    vector<int> const & list = spikes[s % slots][u];
+                    n_spikes += list.size();
+                    if (record)
+                        for (size_t k = 0; k < list.size(); k++) {
+                            spike_times.push_back((s + 1) * dt);
+                            spike_neurons.push_back(list[k]);
+                        }
+                }
+            }
+        }
+    };
+    team->run_each(work);
+
+    steps += n_steps;
+    for (int t = 0; t < threads; t++)
+        n_events += events[t];
+}
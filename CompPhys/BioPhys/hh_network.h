@@ -0,0 +1,135 @@
+#ifndef hh_network_h
+#define hh_network_h
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "worker_team.h"
+
+// Network of Hodgkin-Huxley neurons coupled by conductance-based
+// synapses. Each neuron follows the equations of hodgkin-huxley.ipynb,
+//
+//   C dV/dt = I - g_Na m^3 h (V - E_Na) - g_K n^4 (V - E_K) - g_L (V - E_L)
+//             - g_e (V - E_e) - g_i (V - E_i),
+//   dx/dt = alpha_x(V) (1 - x) - beta_x(V) x,   x = n, m, h,
+//
+// in the modern convention, V the membrane potential in mV with rest at
+// -65 mV; the notebook's V is -65 - V. Units are ms, mV, uF/cm^2,
+// mS/cm^2 and uA/cm^2. When V crosses 0 mV upward the neuron spikes,
+// and delay ms later the conductance g_e or g_i of each of its targets
+// jumps by the weight of the synapse, g_e if it is excitatory and g_i if
+// inhibitory, after which it decays with time constant tau_e or tau_i.
+//
+// The state is kept as one array per variable, and each step of dt
+// advances it by the Rush-Larsen scheme: with V held fixed every gate
+// relaxes exactly, x -> x_inf + (x - x_inf) exp(-dt / tau_x), and then
+// with the gates held fixed so does V, the equation being linear in it.
+// That is stable for any dt and first order in dt. The update is one
+// loop over the arrays with no branches, and the exponentials are
+// computed inline (hh_network.cpp), so the compiler vectorizes it.
+//
+// Synapses are stored by presynaptic neuron in compressed sparse rows,
+// each row sorted by target. The neurons are split into blocks, one per
+// thread of a WorkerTeam started with the network, which run through
+// the steps of every run() in lockstep: every thread takes the spikes
+// due in the step, from the lists all threads made delay earlier, and
+// applies them to the targets in its own block only, found by
+// bisection in each row. So no two threads write the same
+// neuron, and the results do not depend on the number of threads.
+class HHNetwork{
+
+public:
+  HHNetwork(int n_neurons_in,              // neurons in the network
+	    double dt_in = 0.025,          // time step, ms
+	    double delay_in = 1.0,         // synaptic delay, ms, at least dt
+	    int threads_in = 0);           // threads, 0: one per core
+
+  void reset();               // every neuron at rest, no spikes underway
+
+  // synapses i -> j for each pre[k] = i, post[k] = j with weight[k] in
+  // mS/cm^2, replacing any there were; the type of neuron i decides
+  // whether they are excitatory
+  void connect(std::vector<int> const & pre, std::vector<int> const & post,
+	       std::vector<double> const & weight);
+  // the first fraction_exc of the neurons excitatory, the rest inhibitory,
+  // each with k_out synapses to distinct random other neurons
+  void connectRandom(int k_out, double w_exc, double w_inh,
+		     double fraction_exc = 0.8, int seed = -1);
+
+  void run(double duration);  // advance by duration ms
+
+  void set_current(double I) { for (size_t i = 0; i < I_ext.size(); i++) I_ext[i] = I; }
+  void set_current(int i, double I) { I_ext[i] = I; }
+  void set_V(int i, double v) { V[i] = v; above[i] = v >= threshold; }
+  void set_excitatory(int i, bool e) { excitatory[i] = e; }
+  void set_record(bool r) { record = r; }   // keep the spike times
+
+  int get_nneurons() const { return n_neurons; }
+  int get_nsynapses() const { return int(target.size()); }
+  int get_threads() const { return threads; }
+  double get_t() const { return steps * dt; }
+  double get_dt() const { return dt; }
+  long long get_steps() const { return steps; }
+  long long get_spikes() const { return n_spikes; }
+  long long get_events() const { return n_events; }   // synaptic events delivered
+  double get_V(int i) const { return V[i]; }
+  double get_n(int i) const { return n[i]; }
+  double get_m(int i) const { return m[i]; }
+  double get_h(int i) const { return h[i]; }
+  double get_ge(int i) const { return ge[i]; }
+  double get_gi(int i) const { return gi[i]; }
+  std::vector<double> const & get_V() const { return V; }
+  std::vector<double> const & get_spike_times() const { return spike_times; }
+  std::vector<int> const & get_spike_neurons() const { return spike_neurons; }
+
+  // membrane and synapse constants, as in the notebook
+  double C_M = 1.0;           // capacitance
+  double E_Na = 50.;          // Nernst potentials
+  double E_K = -77.;
+  double E_L = -54.387;
+  double g_Na = 120.;         // maximal conductances
+  double g_K = 36.;
+  double g_L = 0.3;
+  double E_e = 0.;            // excitatory and inhibitory reversal potentials
+  double E_i = -80.;
+  double tau_e = 5.;          // and decay times, ms
+  double tau_i = 10.;
+  double threshold = 0.;      // spikes are upward crossings of this
+
+protected:
+  long long deliver(int b, int e, int slot); // spikes of slot to neurons [b, e)
+  void integrate(int b, int e);             // one step of neurons [b, e)
+  void detect(int b, int e, std::vector<int> & spiked);
+
+  int n_neurons;
+  double dt;
+  int delay_steps;            // delay in steps, at least 1
+  int threads;
+  std::unique_ptr<WorkerTeam> team;  // started once, stepped by every run()
+  bool record;
+  long long steps;
+  long long n_spikes;
+  long long n_events;
+
+  std::vector<double> V, n, m, h;           // state
+  std::vector<double> ge, gi;               // synaptic conductances
+  std::vector<double> I_ext;                // applied current
+  std::vector<unsigned char> above;         // V above threshold
+  std::vector<unsigned char> excitatory;
+
+  std::vector<int> row;       // synapses of neuron i: row[i] .. row[i + 1] - 1
+  std::vector<int> target;    // postsynaptic neuron, ascending in each row
+  std::vector<double> weight;
+
+  // spikes[s][t]: neurons of block t that spiked in a step s mod
+  // (delay_steps + 1), in order
+  std::vector< std::vector< std::vector<int> > > spikes;
+  std::vector<double> spike_times;
+  std::vector<int> spike_neurons;
+};
+
+#endif
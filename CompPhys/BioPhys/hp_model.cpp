@@ -0,0 +1,99 @@
+#include "hp_model.h"
+using namespace std;
+
+template <typename L>
+LatticeHPFitness<L>::LatticeHPFitness(const string& sequence_in, double penalty_in) :
+    sequence(sequence_in), length(int(sequence_in.size())), penalty(penalty_in),
+    bits_per_step(0), hydrophobic(sequence_in.size())
+{
+    for (int i = 0; i < length; i++)
+        hydrophobic[i] = sequence[i] == 'H' || sequence[i] == 'B';
+    const int C = L::coordination;
+    while ((1 << bits_per_step) < C - 1)
+        ++bits_per_step;
+
+    // the directions after d, all but the one back to where d came from
+    site_type origin = site_type();
+    for (int d = 0; d < C; d++) {
+        site_type s = L::neighbour(origin, d);
+        for (int e = 0; e < C; e++)
+            if (L::neighbour(s, e) != origin)
+                turn.push_back(e);
+    }
+}
+
+template <typename L>
+void LatticeHPFitness<L>::decode(const Genome& g, vector<site_type>& sites) const {
+    const int C = L::coordination;
+    sites.resize(length);
+    if (length == 0)
+        return;
+    sites[0] = site_type();
+    int d = 0;
+    for (int i = 1; i < length; i++) {
+        if (i > 1)
+            d = turn[d * (C - 1) + int(g.get_bits(bits_per_step * (i - 2), bits_per_step) % (C - 1))];
+        sites[i] = L::neighbour(sites[i - 1], d);
+    }
+}
+
+template <typename L>
+void LatticeHPFitness<L>::score(const Genome& g, int& contacts, int& collisions) const {
+    static thread_local vector<site_type> sites;
+    static thread_local BasicSiteMap<site_type> occupied;
+    decode(g, sites);
+    occupied.clear();
+    occupied.reserve(length);
+    collisions = 0;
+    for (int i = 0; i < length; i++) {
+        if (occupied.get(sites[i]) >= 0)
+            ++collisions;
+        else
+            occupied.insert(sites[i], i);
+    }
+    // each contact once, from its first residue; only the first residue
+    // on a site takes part
+    contacts = 0;
+    for (int i = 0; i < length; i++) {
+        if (!hydrophobic[i] || occupied.get(sites[i]) != i)
+            continue;
+        for (int d = 0; d < L::coordination; d++) {
+            int j = occupied.get(L::neighbour(sites[i], d));
+            if (j > i + 1 && hydrophobic[j])
+                ++contacts;
+        }
+    }
+}
+
+template <typename L>
+double LatticeHPFitness<L>::fitness(const Genome& g) const {
+    int c, x;
+    score(g, c, x);
+    return c - penalty * x;
+}
+
+template <typename L>
+vector<typename L::site_type> LatticeHPFitness<L>::fold(const Genome& g) const {
+    vector<site_type> sites;
+    decode(g, sites);
+    return sites;
+}
+
+template <typename L>
+int LatticeHPFitness<L>::contacts(const Genome& g) const {
+    int c, x;
+    score(g, c, x);
+    return c;
+}
+
+template <typename L>
+int LatticeHPFitness<L>::collisions(const Genome& g) const {
+    int c, x;
+    score(g, c, x);
+    return x;
+}
+
+template class LatticeHPFitness<SquareLattice>;
+template class LatticeHPFitness<TriangularLattice>;
+template class LatticeHPFitness<CubicLattice>;
+template class LatticeHPFitness<FCCLattice>;
@@ -0,0 +1,66 @@
+#ifndef hp_model_h
+#define hp_model_h
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "genetic.h"
+#include "lattice.h"
+#include "site_set.h"
+
+// The HP model of lattice proteins as a problem for GeneticAlgorithm, on
+// any lattice L of lattice.h: a chain of hydrophobic (H) and polar (P)
+// residues on a self-avoiding walk, with energy -1 for each pair of H
+// residues that are lattice neighbours without being bonded. The
+// notebook's B and W stand for H and P and are accepted as well.
+//
+// The first bond is fixed along neighbour direction 0; each further bond
+// takes bits_per_step bits of the genome, read as a choice among the
+// coordination - 1 directions that do not fold straight back, modulo
+// their number (so where that is not a power of two the first choices
+// are a little more likely). Walks that run into themselves are kept,
+// but the fitness, contacts - penalty * collisions, pushes them out of
+// the population. The sites are kept in a BasicSiteMap with their
+// positions along the chain, as in Reptation and PivotWalk, one per
+// thread, so scoring allocates nothing.
+template <typename L>
+class LatticeHPFitness : public Fitness {
+public:
+  typedef typename L::site_type site_type;
+
+  LatticeHPFitness(const std::string& sequence_in, double penalty_in = 2.0);
+
+  int bits() const { return bits_per_step * std::max(0, length - 2); }
+  double fitness(const Genome& g) const;
+
+  std::vector<site_type> fold(const Genome& g) const;   // sites of the residues
+  int contacts(const Genome& g) const;        // H-H contacts
+  int collisions(const Genome& g) const;      // residues on occupied sites
+  int energy(const Genome& g) const { return -contacts(g); }
+
+  const std::string& get_sequence() const { return sequence; }
+  int get_length() const { return length; }
+  int get_bits_per_step() const { return bits_per_step; }
+  double get_penalty() const { return penalty; }
+
+protected:
+  void decode(const Genome& g, std::vector<site_type>& sites) const;
+  void score(const Genome& g, int& contacts, int& collisions) const;
+
+  std::string sequence;
+  int length;
+  double penalty;
+  int bits_per_step;
+  std::vector<unsigned char> hydrophobic;
+  std::vector<int> turn;      // turn[d * (coordination - 1) + r]: r-th direction after d
+};
+
+#ifndef SWIG
+typedef LatticeHPFitness<SquareLattice> HPFitness;
+typedef LatticeHPFitness<TriangularLattice> TriangularHPFitness;
+typedef LatticeHPFitness<CubicLattice> CubicHPFitness;
+typedef LatticeHPFitness<FCCLattice> FCCHPFitness;
+#endif
+
+#endif
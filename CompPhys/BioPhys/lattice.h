@@ -0,0 +1,141 @@
+#ifndef lattice_h
+#define lattice_h
+
+#include <cstdint>
+
+// Lattice sites and the lattices the walk and chain classes are
+// templated on. A lattice L provides
+//
+//   L::site_type             Site or Site3
+//   L::dimension             2 or 3
+//   L::coordination          number of nearest neighbours
+//   L::neighbour(s, d)       neighbour d = 0..coordination-1 of s
+//   L::distance2(a, b)       squared distance in units of the bond length
+//
+// Neighbours 0..3 are a, b, -a, -b for two independent bond vectors a and
+// b, so walks built from them, straight lines, stairs and square spirals,
+// are self-avoiding on every lattice. Sites are integer coordinates,
+// along an oblique basis for the triangular lattice.
+
+struct Site {               // object to represent lattice site
+    int x;                  // x coordinate
+    int y;                  // y coordinate
+
+    bool operator== (const Site& s) const { return x == s.x && y == s.y; }
+    bool operator!= (const Site& s) const { return !(*this == s); }
+
+    // lexicographic strict weak ordering, e.g. for std::set
+    bool operator< (const Site& s) const {
+        return x < s.x || (x == s.x && y < s.y);
+    }
+};
+
+struct Site3 {              // site of a 3D lattice
+    int x;
+    int y;
+    int z;
+
+    bool operator== (const Site3& s) const { return x == s.x && y == s.y && z == s.z; }
+    bool operator!= (const Site3& s) const { return !(*this == s); }
+
+    bool operator< (const Site3& s) const {
+        return x < s.x || (x == s.x && (y < s.y || (y == s.y && z < s.z)));
+    }
+};
+
+// 64-bit hash keys: both coordinates in 2D, 21 bits of each in 3D, so
+// 3D coordinates must stay within +-2^20. Neither ever equals
+// site_key_vacant(), which marks empty slots in SiteSet and friends.
+inline std::uint64_t site_key(Site s) {
+    return (std::uint64_t(std::uint32_t(s.x)) << 32) | std::uint32_t(s.y);
+}
+
+inline std::uint64_t site_key(Site3 s) {
+    const std::uint64_t m = (1u << 21) - 1;
+    return ((std::uint64_t(s.x) & m) << 42) | ((std::uint64_t(s.y) & m) << 21)
+        | (std::uint64_t(s.z) & m);
+}
+
+inline std::uint64_t site_key_vacant() { return 0x8000000080000000ull; }   // (INT_MIN, INT_MIN)
+
+
+struct SquareLattice {
+    typedef Site site_type;
+    enum { dimension = 2, coordination = 4 };
+
+    static Site neighbour(Site s, int d) {
+        static const int dx[4] = { 1, 0, -1, 0 };
+        static const int dy[4] = { 0, 1, 0, -1 };
+        s.x += dx[d];
+        s.y += dy[d];
+        return s;
+    }
+
+    static double distance2(Site a, Site b) {
+        double dx = a.x - b.x, dy = a.y - b.y;
+        return dx * dx + dy * dy;
+    }
+};
+
+// basis (1, 0) and (1/2, sqrt(3)/2)
+struct TriangularLattice {
+    typedef Site site_type;
+    enum { dimension = 2, coordination = 6 };
+
+    static Site neighbour(Site s, int d) {
+        static const int dx[6] = { 1, 0, -1, 0, 1, -1 };
+        static const int dy[6] = { 0, 1, 0, -1, -1, 1 };
+        s.x += dx[d];
+        s.y += dy[d];
+        return s;
+    }
+
+    static double distance2(Site a, Site b) {
+        double dx = a.x - b.x, dy = a.y - b.y;
+        return dx * dx + dx * dy + dy * dy;
+    }
+};
+
+struct CubicLattice {
+    typedef Site3 site_type;
+    enum { dimension = 3, coordination = 6 };
+
+    static Site3 neighbour(Site3 s, int d) {
+        static const int dx[6] = { 1, 0, -1, 0, 0, 0 };
+        static const int dy[6] = { 0, 1, 0, -1, 0, 0 };
+        static const int dz[6] = { 0, 0, 0, 0, 1, -1 };
+        s.x += dx[d];
+        s.y += dy[d];
+        s.z += dz[d];
+        return s;
+    }
+
+    static double distance2(Site3 a, Site3 b) {
+        double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+};
+
+// sites of the cubic lattice with x + y + z even, bonds of length sqrt(2)
+// scaled to 1
+struct FCCLattice {
+    typedef Site3 site_type;
+    enum { dimension = 3, coordination = 12 };
+
+    static Site3 neighbour(Site3 s, int d) {
+        static const int dx[12] = { 1, -1, -1, 1, 1, -1, -1, 1, 0, 0, 0, 0 };
+        static const int dy[12] = { 1, 1, -1, -1, 0, 0, 0, 0, 1, -1, -1, 1 };
+        static const int dz[12] = { 0, 0, 0, 0, 1, 1, -1, -1, 1, 1, -1, -1 };
+        s.x += dx[d];
+        s.y += dy[d];
+        s.z += dz[d];
+        return s;
+    }
+
+    static double distance2(Site3 a, Site3 b) {
+        double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return (dx * dx + dy * dy + dz * dz) / 2;
+    }
+};
+
+#endif
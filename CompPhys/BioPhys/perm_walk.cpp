@@ -0,0 +1,214 @@
+#include "perm_walk.h"
+#include "worker_team.h"
+#include <algorithm>
+#include <atomic>
+using namespace std;
+
+namespace {
+
+// weights are kept divided by muScale^n, about the connective constant,
+// so that they stay of order one instead of growing like 2.64^n
+const double muScale = 2.638;
+
+const int stepX[4] = { 1, 0, -1, 0 };
+const int stepY[4] = { 0, 1, 0, -1 };
+
+// sums over tours of the total weight b and of the weighted R^2, a, at
+// each length, with their squares and product for the error bars
+struct TourSums {
+    vector<double> a, a2, b, b2, ab;
+    long long tours;
+    long long walks;
+
+    TourSums(int n) : a(n + 1), a2(n + 1), b(n + 1), b2(n + 1), ab(n + 1), tours(0), walks(0) { }
+};
+
+// one thread: a walk growing depth first from the origin
+class Grower {
+public:
+    Grower(int n_in, unsigned seed) :
+        sums(n_in), n(n_in), gen(seed), dis(0, 1), ta(n_in + 1), tb(n_in + 1),
+        walk(n_in + 1), occupied(n_in + 1)
+    {
+        stack.reserve(n + 1);
+    }
+
+    void tour();
+
+    TourSums sums;
+
+private:
+    struct Frame {          // copies still to grow from the end of the walk
+        int dirs[4];        // into these directions
+        int copies;         // this many of them
+        int next;           // the next one
+        double w;           // each with this weight
+    };
+
+    void record(int m, double w) {
+        double dx = walk[m].x, dy = walk[m].y;
+        ta[m] += w * (dx * dx + dy * dy);
+        tb[m] += w;
+        depth = max(depth, m);
+    }
+
+    bool expand(int m, double w);
+
+    int n;
+    std::mt19937 gen;
+    std::uniform_real_distribution<> dis;
+    vector<double> ta, tb;  // sums over the current tour
+    int depth;              // deepest length reached in it
+    vector<Site> walk;
+    SiteSet occupied;
+    vector<Frame> stack;    // one per site of the walk but the last
+};
+
+// Pushes the frame for the walk of m steps with weight w, unless pruned
+// or stuck; false then.
+bool Grower::expand(int m, double w) {
+    Frame f;
+    int free = 0;
+    for (int d = 0; d < 4; d++) {
+        Site s;
+        s.x = walk[m].x + stepX[d];
+        s.y = walk[m].y + stepY[d];
+        if (!occupied.contains(s))
+            f.dirs[free++] = d;
+    }
+    if (free == 0)
+        return false;
+
+    // the weight of a single continuation against the estimate of
+    // c_(m+1) so far, this tour included; none yet means Rosenbluth
+    double wNext = w * free / muScale;
+    double estimate = (sums.b[m + 1] + tb[m + 1]) / (sums.tours + 1);
+    double r = estimate > 0 ? wNext / estimate : 1;
+    if (r < 1) {
+        if (dis(gen) >= r)
+            return false;
+        f.copies = 1;
+        f.w = wNext / r;
+    } else {
+        f.copies = min(free, int(ceil(r)));
+        f.w = wNext / f.copies;
+    }
+    // distinct directions, chosen uniformly among the free ones
+    for (int c = 0; c < f.copies; c++) {
+        int pick = c + int(dis(gen) * (free - c));
+        swap(f.dirs[c], f.dirs[pick]);
+    }
+    f.next = 0;
+    stack.push_back(f);
+    return true;
+}
+
+void Grower::tour() {
+    depth = 0;
+    walk[0].x = walk[0].y = 0;
+    occupied.insert(walk[0]);
+    record(0, 1);
+    if (n > 0)
+        expand(0, 1);
+
+    while (!stack.empty()) {
+        int m = stack.size() - 1;       // steps of the walk the frame grows
+        Frame& f = stack.back();
+        if (f.next == f.copies) {
+            occupied.erase(walk[m]);
+            stack.pop_back();
+            continue;
+        }
+        int d = f.dirs[f.next++];
+        double w = f.w;
+        walk[m + 1].x = walk[m].x + stepX[d];
+        walk[m + 1].y = walk[m].y + stepY[d];
+        occupied.insert(walk[m + 1]);
+        record(m + 1, w);
+        if (m + 1 == n) {
+            ++sums.walks;
+            occupied.erase(walk[m + 1]);
+        } else if (!expand(m + 1, w)) {
+            occupied.erase(walk[m + 1]);
+        }
+    }
+    if (n == 0)
+        occupied.erase(walk[0]);
+
+    for (int m = 0; m <= depth; m++) {
+        sums.a[m] += ta[m];
+        sums.a2[m] += ta[m] * ta[m];
+        sums.b[m] += tb[m];
+        sums.b2[m] += tb[m] * tb[m];
+        sums.ab[m] += ta[m] * tb[m];
+        ta[m] = tb[m] = 0;
+    }
+    ++sums.tours;
+}
+
+} // namespace
+
+void PermWalk::run(int threads, int seed) {
+    if (threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+    threads = max(1, min<int>(threads, n_tours));
+    unsigned base = seed < 0 ? rd() : unsigned(seed);
+
+    // tours differ a lot in size, so threads take the next one when done
+    vector<Grower*> growers;
+    for (int t = 0; t < threads; t++)
+        growers.push_back(new Grower(n_steps, base + 0x9E3779B9u * (t + 1)));
+    std::atomic<long long> next(0);
+    auto work = [&](int t) {
+        while (next++ < (long long)n_tours)
+            growers[t]->tour();
+    };
+    WorkerTeam(threads).run_each(work);
+
+    TourSums total(n_steps);
+    for (int t = 0; t < threads; t++) {
+        TourSums const & s = growers[t]->sums;
+        for (unsigned int m = 0; m <= n_steps; m++) {
+            total.a[m] += s.a[m];
+            total.a2[m] += s.a2[m];
+            total.b[m] += s.b[m];
+            total.b2[m] += s.b2[m];
+            total.ab[m] += s.ab[m];
+        }
+        total.tours += s.tours;
+        total.walks += s.walks;
+        delete growers[t];
+    }
+
+    double T = total.tours;
+    walks = total.walks;
+    logZ.assign(n_steps + 1, 0);
+    Zerr.assign(n_steps + 1, 0);
+    r2av.assign(n_steps + 1, 0);
+    r2err.assign(n_steps + 1, 0);
+    for (unsigned int m = 0; m <= n_steps; m++) {
+        double b = total.b[m] / T;
+        if (b <= 0) {
+            logZ[m] = -HUGE_VAL;
+            continue;
+        }
+        logZ[m] = log(b) + m * log(muScale);
+        double r2 = total.a[m] / total.b[m];
+        r2av[m] = r2;
+        if (T > 1) {
+            Zerr[m] = sqrt(max(0.0, total.b2[m] / T - b * b) / (T - 1)) / b;
+            // the ratio a / b to first order, from the spread of a - r2 b
+            double v = (total.a2[m] - 2 * r2 * total.ab[m] + r2 * r2 * total.b2[m]) / T;
+            r2err[m] = sqrt(max(0.0, v) / (T - 1)) / b;
+        }
+    }
+}
+
+vector<double> PermWalk::get_mu() const {
+    vector<double> mu;
+    for (size_t m = 1; m < logZ.size(); m++)
+        mu.push_back(exp(logZ[m] - logZ[m - 1]));
+    return mu;
+}
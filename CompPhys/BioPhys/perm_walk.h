@@ -0,0 +1,68 @@
+#ifndef perm_walk_h
+#define perm_walk_h
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "site_set.h"
+
+// Self-avoiding walks on the square lattice grown by the pruned-enriched
+// Rosenbluth method (PERM) of Grassberger, in the nPERMss form of Hsu,
+// Nadler and Grassberger. A walk grows one step at a time and carries a
+// weight such that every walk of n steps has expected weight 1, so the
+// mean total weight at n per tour estimates the number of walks c_n, and
+// weighted averages are averages over all walks of n steps, for every n
+// up to n_steps in one run. Unlike SAWalk nothing is thrown away without
+// being accounted for in the weights.
+//
+// Where the weight a step would give is well above the current estimate
+// of c_(n+1), the walk is continued into several distinct free
+// neighbours with the weight shared among them (enrichment); where it is
+// well below, the walk is stopped with a probability that the weight of
+// the survivors makes up for (pruning). The copies are grown depth
+// first, so memory stays at one walk plus one frame per step. A tour is
+// everything grown from one start at the origin; tours are independent
+// and run() hands them out to threads that each keep their own sums.
+class PermWalk{
+
+public:
+  PermWalk(unsigned int n_steps_in,     // longest walks
+	   unsigned int n_tours_in) :   // tours to grow
+    rd(), n_steps(n_steps_in), n_tours(n_tours_in), walks(0)
+  {
+  }
+
+  void run(                   // grow n_tours tours, replacing the results
+	   int threads = 0,        // 0: one per core
+	   int seed = -1);         // seeds the threads, -1: random
+
+  unsigned int get_nsteps() const { return n_steps; }
+  unsigned int get_ntours() const { return n_tours; }
+  long long get_walks() const { return walks; }   // walks of n_steps grown
+
+  // estimates for n = 0..n_steps: log c_n and its relative error, and
+  // <R^2> over all walks of n steps and its error
+  std::vector<double> const & get_logZ() const { return logZ; }
+  std::vector<double> const & get_Zerr() const { return Zerr; }
+  std::vector<double> const & get_r2av() const { return r2av; }
+  std::vector<double> const & get_r2err() const { return r2err; }
+
+  // c_n / c_(n-1), which tends to the connective constant, for n >= 1
+  std::vector<double> get_mu() const;
+
+protected:
+  std::random_device rd;
+
+  unsigned int n_steps, n_tours;
+  long long walks;
+  std::vector<double> logZ;
+  std::vector<double> Zerr;
+  std::vector<double> r2av;
+  std::vector<double> r2err;
+};
+
+#endif
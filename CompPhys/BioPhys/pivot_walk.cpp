@@ -0,0 +1,168 @@
+#include "pivot_walk.h"
+using namespace std;
+
+// the symmetry operations as matrices, x' = a x + b y, y' = c x + d y
+static const int symmetryMatrix[PivotWalk::SYMMETRIES][4] = {
+    {  0, -1,  1,  0 },     // ROTATE_90
+    { -1,  0,  0, -1 },     // ROTATE_180
+    {  0,  1, -1,  0 },     // ROTATE_270
+    {  1,  0,  0, -1 },     // REFLECT_X
+    { -1,  0,  0,  1 },     // REFLECT_Y
+    {  0,  1,  1,  0 },     // REFLECT_DIAGONAL
+    {  0, -1, -1,  0 } };   // REFLECT_ANTIDIAGONAL
+
+void PivotWalk::straighten() {
+    walk.resize(n_steps + 1);
+    trial.resize(n_steps + 1);
+    occupied.clear();
+    occupied.reserve(n_steps + 1);
+    for (unsigned int i = 0; i <= n_steps; i++) {
+        walk[i].x = i;
+        walk[i].y = 0;
+        occupied.insert(walk[i], i);
+    }
+}
+
+void PivotWalk::dimerize() {
+    const unsigned int shortest = 100;      // up to this, pivot a straight walk
+    if (n_steps <= shortest) {
+        straighten();
+        for (unsigned int i = 0; i < 10 * n_steps; i++)
+            pivot();
+        return;
+    }
+
+    PivotWalk first(n_steps / 2, 0), second(n_steps - n_steps / 2, 0);
+    first.gen.seed(gen());
+    second.gen.seed(gen());
+    first.dimerize();
+    second.dimerize();
+
+    // the second half under symmetry g (SYMMETRIES: the identity) with its
+    // start on the end of the first, tested from the joint on
+    int n1 = first.n_steps, n2 = second.n_steps;
+    int span = 4;
+    for (;;) {
+        Site joint = first.walk[n1], start = second.walk[0];
+        int g = std::uniform_int_distribution<>(0, SYMMETRIES)(gen);
+        const int identity[4] = { 1, 0, 0, 1 };
+        const int * m = g < SYMMETRIES ? symmetryMatrix[g] : identity;
+        bool joined = true;
+        for (int i = 1; i <= n2 && joined; i++) {
+            int dx = second.walk[i].x - start.x, dy = second.walk[i].y - start.y;
+            Site & s = walk[n1 + i];
+            s.x = joint.x + m[0] * dx + m[1] * dy;
+            s.y = joint.y + m[2] * dx + m[3] * dy;
+            joined = !first.occupied.contains(s);
+        }
+        if (joined)
+            break;
+        // the ends are tangled, most likely close to the joint: pivot both
+        // about sites within span of it, which moves only the ends, and
+        // widen the span on every failure
+        span = min(2 * span, min(n1, n2) / 2);
+        std::uniform_int_distribution<> disSpan(1, span);
+        first.pivot(n1 - disSpan(gen), disSymmetry(gen));
+        second.pivot(disSpan(gen), disSymmetry(gen));
+    }
+
+    occupied.clear();
+    occupied.reserve(n_steps + 1);
+    for (int i = 0; i <= n1; i++)
+        walk[i] = first.walk[i];
+    for (unsigned int i = 0; i <= n_steps; i++)
+        occupied.insert(walk[i], i);
+}
+
+bool PivotWalk::pivot(int k, int symmetry) {
+    int n = n_steps;
+    if (k <= 0 || k >= n || symmetry < 0 || symmetry >= SYMMETRIES)
+        return false;
+    ++attempts;
+
+    // move the sites after k if there are no more of them than before k
+    bool forward = n - k <= k;
+    int step = forward ? 1 : -1;
+    int end = forward ? n + 1 : -1;
+    const int * m = symmetryMatrix[symmetry];
+    Site p = walk[k];
+
+    for (int i = k + step; i != end; i += step) {
+        int dx = walk[i].x - p.x, dy = walk[i].y - p.y;
+        Site s;
+        s.x = p.x + m[0] * dx + m[1] * dy;
+        s.y = p.y + m[2] * dx + m[3] * dy;
+        // the moved part cannot run into itself, only into the fixed one
+        int j = occupied.get(s);
+        if (j >= 0 && (forward ? j < k : j > k))
+            return false;
+        trial[i] = s;
+    }
+
+    for (int i = k + step; i != end; i += step)
+        occupied.erase(walk[i]);
+    for (int i = k + step; i != end; i += step) {
+        walk[i] = trial[i];
+        occupied.insert(walk[i], i);
+    }
+    ++accepted;
+    return true;
+}
+
+bool PivotWalk::pivot() {
+    if (n_steps < 2)
+        return false;
+    std::uniform_int_distribution<> disSite(1, n_steps - 1);
+    int k = disSite(gen);
+    return pivot(k, disSymmetry(gen));
+}
+
+double PivotWalk::rSquared() const {
+    double dx = walk[n_steps].x - walk[0].x;
+    double dy = walk[n_steps].y - walk[0].y;
+    return dx * dx + dy * dy;
+}
+
+double PivotWalk::rGyration() const {
+    double x = 0, y = 0, x2 = 0, y2 = 0;
+    for (unsigned int i = 0; i <= n_steps; i++) {
+        // relative to the first site, so the sums stay small
+        double dx = walk[i].x - walk[0].x, dy = walk[i].y - walk[0].y;
+        x += dx;
+        y += dy;
+        x2 += dx * dx;
+        y2 += dy * dy;
+    }
+    double n = n_steps + 1;
+    return (x2 + y2) / n - (x * x + y * y) / (n * n);
+}
+
+void PivotWalk::run() {
+
+    dimerize();
+    attempts = 0;
+    accepted = 0;
+    r2av = 0;
+    r4av = 0;
+    rg2av = 0;
+    stdDev = 0;
+
+    for (unsigned int i = 0; i < n_equilibrate; i++)
+        pivot();
+
+    for (unsigned int w = 0; w < n_walks; w++) {
+        for (unsigned int i = 0; i < n_pivots; i++)
+            pivot();
+        double r2 = rSquared();
+        r2av += r2;
+        r4av += r2 * r2;
+        rg2av += rGyration();
+    }
+
+    if (n_walks > 0) {
+        r2av /= n_walks;
+        r4av /= n_walks;
+        rg2av /= n_walks;
+        stdDev = sqrt(r4av - r2av * r2av);
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef pivot_walk_h
+#define pivot_walk_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "site_set.h"
+
+// Self-avoiding walks on the square lattice by the pivot algorithm of
+// Madras and Sokal: choose a site of the walk and one of the seven
+// lattice symmetries other than the identity, apply it to the part of
+// the walk on one side of the site, about the site, and keep the result
+// if it is still self-avoiding. The chain is ergodic and every walk of
+// n_steps steps is equally likely, and since whole parts of the walk
+// move at once, global quantities like the end-to-end distance
+// decorrelate after a few accepted pivots instead of ~n_steps^2 local
+// moves, with no attrition as in SAWalk.
+//
+// The sites are kept in a SiteMap with their positions along the walk.
+// The shorter side of the pivot is the one moved, and its new sites are
+// tested from the pivot outward, where collisions are most likely,
+// until one lands on the fixed side. So rejections are cheap and an
+// accepted pivot costs at most n_steps / 2 hash updates.
+//
+// From a straight walk, it takes of order n_steps pivots before the
+// walk is bent everywhere, so run() starts instead from dimerize(): two
+// halves made the same way, joined under a random symmetry and, while
+// they intersect, each pivoted again near the joint. Madras and Sokal
+// regenerate both halves instead, which makes the start a uniform
+// sample, but a join fails so often in two dimensions that this costs
+// more than the run. So the start is only a cheap, bent walk, and it is
+// the n_equilibrate pivots before the first sample, by default about
+// one per step, that bring it to equilibrium.
+class PivotWalk{
+
+public:
+  enum { ROTATE_90 = 0, ROTATE_180, ROTATE_270,        // counterclockwise
+	 REFLECT_X, REFLECT_Y,                          // y -> -y, x -> -x
+	 REFLECT_DIAGONAL, REFLECT_ANTIDIAGONAL,        // x <-> y, x <-> -y
+	 SYMMETRIES };
+
+  PivotWalk(unsigned int n_steps_in,           // steps per walk
+	    unsigned int n_walks_in,           // walks to sample
+	    unsigned int n_pivots_in = 100,    // pivots tried between samples
+	    unsigned int n_equilibrate_in = 0) :   // and before the first,
+						    // 0: max(1000, n_steps)
+    rd(), gen(rd()), disSymmetry(0, SYMMETRIES - 1),
+    n_steps(n_steps_in), n_walks(n_walks_in), n_pivots(n_pivots_in),
+    n_equilibrate(n_equilibrate_in > 0 ? n_equilibrate_in : std::max(1000u, n_steps_in)),
+    attempts(0), accepted(0),
+    r2av(0.), r4av(0.), stdDev(0.), rg2av(0.)
+  {
+    straighten();
+  }
+
+  void straighten();          // start over from a straight walk along x
+  void dimerize();            // start over from two joined random halves
+
+  bool pivot(                 // try a pivot and return true if accepted
+	     int k,                  // about this site, 0 < k < n_steps
+	     int symmetry);          // with this symmetry operation
+  bool pivot();               // try a random pivot
+
+  void run();                 // equilibrate, then take n_walks samples
+
+  double rSquared() const;    // end-to-end distance squared
+  double rGyration() const;   // radius of gyration squared
+
+  unsigned int get_nsteps() const { return n_steps; }
+  unsigned int get_nwalks() const { return n_walks; }
+  unsigned int get_npivots() const { return n_pivots; }
+  unsigned int get_nequilibrate() const { return n_equilibrate; }
+  long long get_attempts() const { return attempts; }
+  long long get_accepted() const { return accepted; }
+  double get_acceptance() const { return attempts > 0 ? accepted / double(attempts) : 0.; }
+  double get_r2av() const { return r2av; }
+  double get_r4av() const { return r4av; }
+  double get_stdDev() const { return stdDev; }
+  double get_rg2av() const { return rg2av; }
+  std::vector<Site> const & get_walk() const { return walk; }
+
+protected:
+  std::random_device rd;
+  std::mt19937 gen;
+  std::uniform_int_distribution<> disSymmetry;
+
+  unsigned int n_steps, n_walks, n_pivots, n_equilibrate;
+  long long attempts;
+  long long accepted;
+  double r2av;
+  double r4av;
+  double stdDev;
+  double rg2av;
+  std::vector<Site> walk;     // sites 0..n_steps
+  std::vector<Site> trial;    // moved sites of a pivot being tried
+  SiteMap occupied;           // position of each site along the walk
+};
+
+#endif
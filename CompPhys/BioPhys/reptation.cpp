@@ -1,43 +1,59 @@
 #include "reptation.h"
+#include "worker_team.h"
+#include <algorithm>
+#include <iterator>
 using namespace std;
 
-bool Reptation::occupied(Site s) {     // return true if s is occupied
-    return occupiedSites.find(s) != occupiedSites.end();
+template <typename L>
+bool LatticeReptation<L>::occupied(site_type s) {     // return true if s is occupied
+    return occupiedSites.contains(s);
 }
 
-void Reptation::clear() {              // remove all sites
+template <typename L>
+void LatticeReptation<L>::clear() {              // remove all sites
     snake.clear();
     occupiedSites.clear();
+    observables.clear();
 }
 
-void Reptation::addBack(Site s) {      // add s to back of reptile
+template <typename L>
+void LatticeReptation<L>::addBack(site_type s) {      // add s to back of reptile
     snake.push_back(s);
     occupiedSites.insert(s);
+    observables.add(s);
 }
 
-void Reptation::addFront(Site s) {     // add s to back of reptile
+template <typename L>
+void LatticeReptation<L>::addFront(site_type s) {     // add s to back of reptile
     snake.push_front(s);
     occupiedSites.insert(s);
+    observables.add(s);
 }
 
-void Reptation::removeBack() {         // remove back end of reptile
+template <typename L>
+void LatticeReptation<L>::removeBack() {         // remove back end of reptile
     occupiedSites.erase(snake.back());
+    observables.remove(snake.back());
     snake.pop_back();
 }
 
-void Reptation::removeFront() {        // remove front end of reptile
+template <typename L>
+void LatticeReptation<L>::removeFront() {        // remove front end of reptile
     occupiedSites.erase(snake.front());
+    observables.remove(snake.front());
     snake.pop_front();
 }
 
-void Reptation::createSnake(           // make a snake with
+template <typename L>
+void LatticeReptation<L>::createSnake(           // make a snake with
     int steps,              // this number of segments
     int config)             // and this initial configuration
 {
     clear();                // remove all sites
+    snake.reserve(steps + 1);   // so that moves never allocate
+    occupiedSites.reserve(steps + 1);
 
-    Site s;
-    s.x = s.y = 0;
+    site_type s = site_type();
     addFront(s);
 
     for (int step = 1; step <= steps; step++) {
@@ -46,79 +62,48 @@ void Reptation::createSnake(           // make a snake with
 
       switch (config) {
       case STAIR:             // add randomly East or North
-	dis(gen) < 0.5 ? ++s.x : ++s.y;  // distribution chooses 0,1,2,3
+	s = L::neighbour(s, dis(gen) < 0.5 ? EAST : NORTH);
 	break;
       case COIL:              // add in sequence E,N,W,W,S,S,E,E,E,N,N,N,...
 	while (stp < step)
 	  stp += ++dir / 2;
-	switch ((dir + 2) % DIRECTIONS) {
-	case EAST  :  ++s.x;  break;
-	case NORTH :  ++s.y;  break;
-	case WEST  :  --s.x;  break;
-	case SOUTH :  --s.y;  break;
-	}
+	s = L::neighbour(s, (dir + 2) % 4);
 	break;
       case LINE:              // add East
       default:                // also the default
-	++s.x;
+	s = L::neighbour(s, EAST);
       }
 	
       addFront(s);
     }
 }
 
-Site Reptation::randomAllowed(         // return a random allowed site
-    Site head,              // adjacent to this head site
-    Site neck)              // excluding this neck site
+template <typename L>
+typename LatticeReptation<L>::site_type LatticeReptation<L>::randomAllowed(
+    site_type head,         // adjacent to this head site
+    site_type neck)         // excluding this neck site
 {
-    deque<Site> allowed;
+    int neckDir = DIRECTIONS;
+    for (int d = 0; d < DIRECTIONS; d++)
+        if (L::neighbour(head, d) == neck)
+            neckDir = d;
+    int nAllowed = neckDir == DIRECTIONS ? DIRECTIONS : DIRECTIONS - 1;
 
-    // find the 3 allowed directions and add site to allowed deque
-
-    for (int direction = EAST; direction < DIRECTIONS; direction++) {
-
-        Site s;
-        s.x = head.x;
-        s.y = head.y;
-
-        switch (direction) {
-        case EAST:
-            if ( !(head.x == neck.x - 1 && head.y == neck.y) ) {
-                ++s.x;
-                allowed.push_back(s);
-            }
-            break;
-        case NORTH:
-            if ( !(head.x == neck.x && head.y == neck.y - 1) ) {
-                ++s.y;
-                allowed.push_back(s);
-            }
-            break;
-        case WEST:
-            if ( !(head.x == neck.x + 1 && head.y == neck.y) ) {
-                --s.x;
-                allowed.push_back(s);
-            }
-            break;
-        case SOUTH:
-            if ( !(head.x == neck.x && head.y == neck.y + 1) ) {
-                --s.y;
-                allowed.push_back(s);
-            }
-            break;
-        }
-    }
-
-    // choose and return a random allowed site
-    return allowed[ static_cast<int>(dis(gen) * allowed.size()) ];
+    // choose and return a random allowed site, the directions in order
+    // with the neck left out
+    int dir = static_cast<int>(dis(gen) * nAllowed);
+    if (dir >= neckDir)
+        ++dir;
+    return L::neighbour(head, dir);
 }
 
-bool Reptation::reptate() {            // attempt random move and return true if succeeded
+template <typename L>
+bool LatticeReptation<L>::reptate() {            // attempt random move and return true if succeeded
 
     if (snake.size() < 2)               // cannot reptate
         return false;
 
-    Site head, neck, sNext;
+    site_type head, neck, sNext;
 
     if (dis(gen) < 0.5 ) {    // choose front end of snake
         head = snake[0];
@@ -142,34 +127,399 @@ bool Reptation::reptate() {            // attempt random move and return true if
     return true;
 }
 
-double Reptation::rSquared() {         // end-to-end size squared
+namespace {
+
+// s shifted by b - a
+template <typename S>
+S shifted(S s, S a, S b) {
+    long long cs[3], ca[3], cb[3];
+    site_coords(s, cs);
+    site_coords(a, ca);
+    site_coords(b, cb);
+    for (int k = 0; k < 3; k++)
+        cs[k] += cb[k] - ca[k];
+    coords_site(cs, s);
+    return s;
+}
+
+} // namespace
+
+template <typename L>
+void LatticeReptation<L>::moveBead(int i, site_type s) {
+    occupiedSites.erase(snake[i]);
+    observables.remove(snake[i]);
+    snake[i] = s;
+    occupiedSites.insert(s);
+    observables.add(s);
+}
+
+template <typename L>
+bool LatticeReptation<L>::kinkJump() {
+    int n = snake.size();
+    if (n < 3)
+        return false;
+    int i = 1 + static_cast<int>(dis(gen) * (n - 2));
+
+    // the sites next to both bonded beads, bead i among them; the same
+    // set after the jump
+    site_type a = snake[i - 1], b = snake[i + 1];
+    site_type choice[DIRECTIONS];
+    int k = 0;
+    for (int d = 0; d < DIRECTIONS; d++) {
+        site_type c = L::neighbour(a, d);
+        if (L::distance2(c, b) == 1)
+            choice[k++] = c;
+    }
+    site_type s = choice[static_cast<int>(dis(gen) * k)];
+    if (occupied(s))            // bead i itself included
+        return false;
+    moveBead(i, s);
+    return true;
+}
+
+template <typename L>
+bool LatticeReptation<L>::crankshaft() {
+    int n = snake.size();
+    if (n < 4)
+        return false;
+    int i = 1 + static_cast<int>(dis(gen) * (n - 3));
+
+    // beads i and i + 1 bonded parallel to a and b, which are adjacent;
+    // they go to any neighbour s of a and s + b - a
+    site_type a = snake[i - 1], b = snake[i + 2], x = snake[i], y = snake[i + 1];
+    if (L::distance2(a, b) != 1 || shifted(x, a, b) != y)
+        return false;
+    site_type s = L::neighbour(a, static_cast<int>(dis(gen) * DIRECTIONS));
+    site_type t = shifted(s, a, b);
+    if (s == x)
+        return false;
+    if ((occupied(s) && s != y) || (occupied(t) && t != x))
+        return false;
+    occupiedSites.erase(x);
+    occupiedSites.erase(y);
+    observables.remove(x);
+    observables.remove(y);
+    snake[i] = s;
+    snake[i + 1] = t;
+    occupiedSites.insert(s);
+    occupiedSites.insert(t);
+    observables.add(s);
+    observables.add(t);
+    return true;
+}
+
+template <typename L>
+bool LatticeReptation<L>::endRotation() {
+    int n = snake.size();
+    if (n < 2)
+        return false;
+    int end = 0, next = 1;
+    if (dis(gen) < 0.5) {
+        end = n - 1;
+        next = n - 2;
+    }
+    site_type s = L::neighbour(snake[next], static_cast<int>(dis(gen) * DIRECTIONS));
+    if (occupied(s))            // the end itself included
+        return false;
+    moveBead(end, s);
+    return true;
+}
+
+template <typename L>
+void LatticeReptation<L>::set_moves(double reptation, double kink, double crank, double end) {
+    double w[MOVES] = { max(0.0, reptation), max(0.0, kink), max(0.0, crank), max(0.0, end) };
+    double total = w[0] + w[1] + w[2] + w[3];
+    if (total <= 0) {
+        w[REPTATION] = total = 1;
+    }
+    double sum = 0;
+    for (int k = 0; k < MOVES; k++) {
+        sum += w[k];
+        cumulative[k] = sum / total;
+    }
+    cumulative[MOVES - 1] = 1;
+}
+
+template <typename L>
+void LatticeReptation<L>::clearCounts() {
+    attempts.assign(MOVES, 0);
+    accepted.assign(MOVES, 0);
+}
+
+template <typename L>
+vector<double> LatticeReptation<L>::get_acceptance() const {
+    vector<double> a(MOVES, 0.);
+    for (int k = 0; k < MOVES; k++)
+        if (attempts[k] > 0)
+            a[k] = accepted[k] / double(attempts[k]);
+    return a;
+}
+
+template <typename L>
+bool LatticeReptation<L>::move() {
+    // reptation alone draws nothing extra, so runs repeat those of reptate()
+    int kind = REPTATION;
+    if (cumulative[REPTATION] < 1) {
+        double u = dis(gen);
+        while (kind < MOVES - 1 && u >= cumulative[kind])
+            ++kind;
+    }
+    bool moved;
+    switch (kind) {
+    case KINK:
+        moved = kinkJump();
+        break;
+    case CRANKSHAFT:
+        moved = crankshaft();
+        break;
+    case END_ROTATION:
+        moved = endRotation();
+        break;
+    case REPTATION:
+    default:
+        moved = reptate();
+    }
+    ++attempts[kind];
+    accepted[kind] += moved;
+    return moved;
+}
+
+template <typename L>
+double LatticeReptation<L>::rSquared() {         // end-to-end size squared
     if (snake.size() < 2)
         return 0.0;
-    double dx = snake.front().x - snake.back().x;
-    double dy = snake.front().y - snake.back().y;
-    return dx * dx + dy * dy;
+    return L::distance2(snake.front(), snake.back());
 }
 
-void Reptation::run(){
+template <typename L>
+void LatticeReptation<L>::run(){
   for (int steps = 1; steps <= n_steps; steps++) {
     double r2sum = 0;
     double r4sum = 0;
+    double rg2sum = 0;
     int success = 0;
     createSnake(steps, config);
     for (int i = 0; i < n_walks; i++) {
-      if (reptate())
+      if (move())
 	++success;
       double r2 = rSquared();
       r2sum += r2;
       r4sum += r2 * r2;
+      rg2sum += rgSquared();
       
       if ( makePlot ) {
-	snakes.push_back( snake );
+	snakes.push_back( std::deque<site_type>() );
+	for (size_t k = 0; k < snake.size(); k++)
+	  snakes.back().push_back( snake[k] );
       }
     }
     r2av.push_back( r2sum / n_walks );
+    rg2av.push_back( rg2sum / n_walks );
     stdDev.push_back( sqrt(r4sum / n_walks - r2av.back() * r2av.back()) );
     successPercent.push_back( success / double(n_walks) );
 
   }
 }
+
+namespace {
+
+template <typename S>
+struct Snapshot {           // snake saved by a Reservoir
+    double key;             // random priority
+    long long order;        // position in the sequence of walks
+    std::vector<S> sites;
+
+    bool operator< (const Snapshot& s) const { return key < s.key; }
+};
+
+// Uniform sample of at most k snapshots from a stream: each gets a
+// random key and the k smallest keys are kept, in a max-heap. Once full,
+// the number of snapshots until the next key below the largest kept one
+// is geometric, so only that one is drawn for and copied. Reservoirs of
+// separate streams merge by keeping the k smallest keys of all.
+template <typename S>
+class Reservoir {
+public:
+    Reservoir(size_t k_in, std::seed_seq& seed) : k(k_in), gen(seed), dis(0, 1), skip(0) { }
+
+    // true if the next snapshot is to be kept, with this key
+    bool take(double& key) {
+        if (k == 0)
+            return false;
+        if (heap.size() < k) {
+            key = dis(gen);
+            return true;
+        }
+        if (skip > 0) {
+            --skip;
+            return false;
+        }
+        key = heap.front().key * dis(gen);
+        return true;
+    }
+
+    void add(double key, long long order, const BasicSiteRing<S>& snake) {
+        if (heap.size() < k) {
+            heap.push_back(Snapshot<S>());
+        } else {
+            std::pop_heap(heap.begin(), heap.end());
+        }
+        Snapshot<S>& s = heap.back();
+        s.key = key;
+        s.order = order;
+        s.sites.resize(snake.size());
+        for (size_t i = 0; i < snake.size(); i++)
+            s.sites[i] = snake[i];
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() == k) {
+            double u = 1 - dis(gen);
+            double g = log(u) / log1p(-heap.front().key);
+            skip = g < 1e18 ? static_cast<long long>(g) : (1LL << 62);
+        }
+    }
+
+    // move the snapshots to kept and trim that to the k smallest keys
+    void mergeInto(std::vector< Snapshot<S> >& kept) {
+        for (size_t i = 0; i < heap.size(); i++) {
+            kept.push_back(Snapshot<S>());
+            kept.back().key = heap[i].key;
+            kept.back().order = heap[i].order;
+            kept.back().sites.swap(heap[i].sites);
+        }
+        heap.clear();
+        if (kept.size() > k) {
+            std::nth_element(kept.begin(), kept.begin() + k, kept.end());
+            kept.resize(k);
+        }
+    }
+
+    std::vector< Snapshot<S> > heap;
+
+private:
+    size_t k;
+    std::mt19937 gen;
+    std::uniform_real_distribution<> dis;
+    long long skip;         // snapshots to pass over before the next kept one
+};
+
+} // namespace
+
+template <typename L>
+void LatticeReptation<L>::runParallel(int threads, int chains, int maxSnakes, int seed,
+                                      int equilibrate) {
+    if (threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+    if (chains <= 0)
+        chains = defaultChains;
+    chains = max(1, min(chains, n_walks));
+    int items = n_steps * chains;           // one (length, chain) pair each
+    threads = max(1, min(threads, items));
+    unsigned base = seed < 0 ? rd() : unsigned(seed);
+    size_t keep = makePlot ? size_t(max(0, maxSnakes)) : 0;
+
+    struct Sums {           // per thread, summed over its chains
+        vector<double> r2, r4, rg2;
+        vector<long long> success, attempts, accepted;
+        vector< Snapshot<site_type> > kept;     // smallest keys of its chains
+        Sums(int n) : r2(n), r4(n), rg2(n), success(n) { }
+    };
+    vector<Sums> sums(threads, Sums(n_steps));
+
+    // thread t takes the pairs t, t + threads, ...; each pair has its own
+    // streams for the walk and for the snapshot keys, so the results and
+    // the snapshots kept depend only on the seed and the chains
+    auto work = [&](int t) {
+        LatticeReptation walker(n_steps, n_walks, config);
+        std::copy(cumulative, cumulative + MOVES, walker.cumulative);
+        Sums& local = sums[t];
+        for (int item = t; item < items; item += threads) {
+            int steps = item / chains + 1, c = item % chains;
+            int walks = n_walks / chains + (c < n_walks % chains);
+            long long order = (steps - 1) * (long long)n_walks
+                + c * (long long)(n_walks / chains) + min(c, n_walks % chains);
+            std::seed_seq seq{ base, unsigned(steps), unsigned(c) };
+            walker.gen.seed(seq);
+            std::seed_seq keySeq{ base, unsigned(steps), unsigned(c), 1u };
+            Reservoir<site_type> reservoir(keep, keySeq);
+            walker.createSnake(steps, config);
+            // a reptation time is about steps^2 moves; the moves that
+            // relax the chain from config are not counted
+            long long discard = equilibrate >= 0 ? equilibrate
+                : min((long long)walks, (long long)steps * steps);
+            vector<long long> attempts = walker.attempts, accepted = walker.accepted;
+            for (long long i = 0; i < discard; i++)
+                walker.move();
+            walker.attempts = attempts;
+            walker.accepted = accepted;
+            double r2sum = 0, r4sum = 0, rg2sum = 0;
+            long long success = 0;
+            for (int i = 0; i < walks; i++) {
+                if (walker.move())
+                    ++success;
+                double r2 = walker.rSquared();
+                r2sum += r2;
+                r4sum += r2 * r2;
+                rg2sum += walker.rgSquared();
+                double key;
+                if (reservoir.take(key))
+                    reservoir.add(key, order + i, walker.snake);
+            }
+            reservoir.mergeInto(local.kept);
+            local.r2[steps - 1] += r2sum;
+            local.r4[steps - 1] += r4sum;
+            local.rg2[steps - 1] += rg2sum;
+            local.success[steps - 1] += success;
+        }
+        local.attempts = walker.attempts;
+        local.accepted = walker.accepted;
+    };
+    WorkerTeam(threads).run_each(work);
+
+    r2av.assign(n_steps, 0);
+    rg2av.assign(n_steps, 0);
+    stdDev.assign(n_steps, 0);
+    successPercent.assign(n_steps, 0);
+    for (int steps = 0; steps < n_steps; steps++) {
+        double r2sum = 0, r4sum = 0, rg2sum = 0, success = 0;
+        for (int t = 0; t < threads; t++) {
+            r2sum += sums[t].r2[steps];
+            r4sum += sums[t].r4[steps];
+            rg2sum += sums[t].rg2[steps];
+            success += sums[t].success[steps];
+        }
+        r2av[steps] = r2sum / n_walks;
+        rg2av[steps] = rg2sum / n_walks;
+        stdDev[steps] = sqrt(max(0.0, r4sum / n_walks - r2av[steps] * r2av[steps]));
+        successPercent[steps] = success / n_walks;
+    }
+    for (int t = 0; t < threads; t++)
+        for (int k = 0; k < MOVES; k++) {
+            attempts[k] += sums[t].attempts[k];
+            accepted[k] += sums[t].accepted[k];
+        }
+
+    // the smallest keys of all threads, in walk order
+    vector< Snapshot<site_type> > kept;
+    for (int t = 0; t < threads; t++) {
+        kept.insert(kept.end(), std::make_move_iterator(sums[t].kept.begin()),
+                    std::make_move_iterator(sums[t].kept.end()));
+        if (kept.size() > keep) {
+            std::nth_element(kept.begin(), kept.begin() + keep, kept.end());
+            kept.resize(keep);
+        }
+    }
+    std::sort(kept.begin(), kept.end(),
+              [](const Snapshot<site_type>& a, const Snapshot<site_type>& b) {
+                  return a.order < b.order;
+              });
+    snakes.clear();
+    for (size_t i = 0; i < kept.size(); i++)
+        snakes.push_back(std::deque<site_type>(kept[i].sites.begin(), kept[i].sites.end()));
+}
+
+template class LatticeReptation<SquareLattice>;
+template class LatticeReptation<TriangularLattice>;
+template class LatticeReptation<CubicLattice>;
+template class LatticeReptation<FCCLattice>;
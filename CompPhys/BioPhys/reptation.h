@@ -9,39 +9,53 @@
 #include <iomanip>
 #include <iostream>
 #include <fstream>
-#include <set>
 #include <random>
-
-
-struct Site {               // object to represent lattice site
-    int x;                  // x coordinate
-    int y;                  // y coordinate
-
-    // strict weak-ordering comparison operator required by set
-    bool operator< (const Site& s) const {
-        const int maxDiff = 9999;   // must be larger than x or y difference
-        return (x - s.x) + maxDiff * (y - s.y) < 0;
-    }
-};
-
-class Reptation{
+#include <thread>
+
+#include "chain_observables.h"
+#include "lattice.h"
+#include "site_ring.h"
+#include "site_set.h"
+
+
+// Reptation of a chain on lattice L (lattice.h), e.g. SquareLattice for
+// Reptation itself. Directions are the neighbour indices of L, with
+// EAST, NORTH, WEST and SOUTH the first four; reptation.cpp instantiates
+// the four lattices of lattice.h.
+//
+// Besides the slithering-snake move of reptate() there are local moves
+// that relax compact chains from the inside: a kink jump moves one bead
+// to another site next to both its bonded beads, a crankshaft moves two
+// beads whose outer neighbours are adjacent to another pair of sites
+// bonded to those, and an end rotation moves an end bead to another site
+// next to its neighbour. Each proposes among a set of sites that the
+// move back proposes among as well, so all keep the uniform distribution
+// over self-avoiding chains. move() picks one by the probabilities of
+// set_moves(), reptation alone by default, and counts attempts and
+// successes per kind.
+template <typename L>
+class LatticeReptation{
 
 public:
-  enum { EAST = 0, NORTH, WEST, SOUTH, DIRECTIONS};
+  typedef typename L::site_type site_type;
+  enum { EAST = 0, NORTH, WEST, SOUTH, DIRECTIONS = L::coordination };
   enum { STAIR = 0, COIL, LINE };
+  enum { REPTATION = 0, KINK, CRANKSHAFT, END_ROTATION, MOVES };
 
 
   
-  Reptation(int n_steps_in, int n_walks_in, int config_in, bool plot=false) :
+  LatticeReptation(int n_steps_in, int n_walks_in, int config_in, bool plot=false) :
     rd(), gen(rd()), dis(0,1),
-    n_steps(n_steps_in), n_walks(n_walks_in), config(config_in), makePlot(plot)
+    n_steps(n_steps_in), n_walks(n_walks_in), config(config_in), makePlot(plot),
+    attempts(MOVES, 0), accepted(MOVES, 0)
   {
+    set_moves(1, 0, 0, 0);
   }
 
-  bool occupied(Site s);     // return true if s is occupied
+  bool occupied(site_type s);     // return true if s is occupied
   void clear();              // remove all sites
-  void addBack(Site s);      // add s to back of reptile=
-  void addFront(Site s);    // add s to back of reptile
+  void addBack(site_type s);      // add s to back of reptile=
+  void addFront(site_type s);    // add s to back of reptile
   void removeBack();        // remove back end of reptile
   void removeFront();         // remove front end of reptile
 
@@ -51,19 +65,53 @@ public:
 		   int steps,              // this number of segments
 		   int config = LINE);     // and this initial configuration
 
-  Site randomAllowed(         // return a random allowed site
-		     Site head,              // adjacent to this head site
-		     Site neck);             // excluding this neck site;
+  site_type randomAllowed(    // return a random allowed site
+		     site_type head,         // adjacent to this head site
+		     site_type neck);        // excluding this neck site;
   bool reptate() ;
+  bool kinkJump();          // the local moves, true if the chain changed
+  bool crankshaft();
+  bool endRotation();
+  bool move();              // one of the four, by the probabilities of set_moves
+
+  // relative weights of REPTATION, KINK, CRANKSHAFT and END_ROTATION in move()
+  void set_moves(double reptation, double kink, double crank, double end);
+  void clearCounts();       // zero the attempts and successes
   double rSquared();
+  double rgSquared() const { return observables.rg2(); }   // radius of gyration squared, O(1)
+  std::vector<double> centerOfMass() const { return observables.center(); }
+  void sampleStructure(LatticeStructureFactor<L>& sf) const { sf.add(snake); }   // the snake into S(q)
 
   
   void run(); 
+
+  // run() with the walks of each length split into independent chains,
+  // each starting from the initial configuration with its own random
+  // stream and relaxed by discarded moves, spread over threads that keep
+  // their own sums. The chains, and so the walks for a given seed, do
+  // not depend on the threads. Replaces the results; with makePlot
+  // at most maxSnakes snapshots, a uniform sample of the walks drawn with
+  // a key stream per chain, so also independent of the threads, in walk
+  // order.
+  void runParallel(
+		   int threads = 0,        // 0: one per core
+		   int chains = 0,         // chains per length, 0: defaultChains
+		   int maxSnakes = 1000,   // snapshots kept
+		   int seed = -1,          // seeds the streams, -1: random
+		   int equilibrate = -1);  // moves discarded per chain, -1: as many as
+					   // it keeps, at most steps^2
+  enum { defaultChains = 16 };
   std::vector<double> const & get_r2av() const { return r2av; }
+  std::vector<double> const & get_rg2av() const { return rg2av; }
   std::vector<double> const & get_stdDev() const { return stdDev; }
   std::vector<double> const & get_successPercent() const { return successPercent; }
 
-  std::vector< std::deque<Site> > const & get_snakes() const { return snakes; }
+  std::vector< std::deque<site_type> > const & get_snakes() const { return snakes; }
+
+  // moves of each kind tried and made by move(), run() and runParallel()
+  std::vector<long long> const & get_attempts() const { return attempts; }
+  std::vector<long long> const & get_accepted() const { return accepted; }
+  std::vector<double> get_acceptance() const;
   
 protected:
 
@@ -71,19 +119,31 @@ protected:
   std::mt19937 gen;
   std::uniform_real_distribution<> dis;
 
-  std::deque<Site> snake;          // double-headed reptile
-  std::set<Site> occupiedSites;    // set of occupied sites
-  std::vector< std::deque<Site> > snakes; // Here we keep track of the sites for plotting
+  BasicSiteRing<site_type> snake;  // double-headed reptile
+  BasicSiteSet<site_type> occupiedSites;  // hash set of occupied sites
+  LatticeChainObservables<L> observables; // running sums over the sites
+  void moveBead(int i, site_type s);      // bead i to s, the sets kept up to date
+  std::vector< std::deque<site_type> > snakes; // Here we keep track of the sites for plotting
   
   int n_steps, n_walks, config;
   bool makePlot;                   // store a list of the snakes
   int walks;
   int failed_walks;
   std::vector<double> r2av;
+  std::vector<double> rg2av;
   std::vector<double> stdDev;
   std::vector<double> successPercent;
+  double cumulative[MOVES];        // of the move probabilities
+  std::vector<long long> attempts, accepted;
 
 
 };
 
+#ifndef SWIG
+typedef LatticeReptation<SquareLattice> Reptation;
+typedef LatticeReptation<TriangularLattice> TriangularReptation;
+typedef LatticeReptation<CubicLattice> CubicReptation;
+typedef LatticeReptation<FCCLattice> FCCReptation;
+#endif
+
 #endif
@@ -1,7 +1,8 @@
-#include "SAWalk.h"
+#include "sawalk.h"
 
 
-void SAWalk::run() {
+template <typename L>
+void LatticeSAWalk<L>::run() {
 
 
   walks = 0;
@@ -9,40 +10,33 @@ void SAWalk::run() {
   r2av = 0;
   r4av = 0;
   stdDev = 0;
+  rg2av = 0;
 
   // generate walks
   while (walks < n_walks) {
     sites.clear();  // set of occupied lattice sites
-    Site s;
-    s.x = 0;
-    s.y = 0;
-    sites.push_back(s);
+    sites.reserve(n_steps + 1);
+    const site_type origin = site_type();
+    site_type s = origin;
+    sites.insert(s);
+    observables.clear();
+    observables.add(s);
     bool walk_failed = false;
 
     // loop over desired number of steps
     for (int step = 0; step < n_steps; step++) {
 
       // take a random step
-      auto dir = dis(gen);
-      if      (dir == 0)  ++s.x;   // step East
-      else if (dir == 1)  ++s.y;   // step North
-      else if (dir == 2)  --s.x;   // step West
-      else                --s.y;   // step South
+      s = L::neighbour(s, dis(gen));
 
       // check whether the site is occupied
-      bool occupied = false;
-      for (int i = 0; i < sites.size(); i++) {
-	if (s.x == sites[i].x && s.y == sites[i].y) {
-	  occupied = true;
-	  break;
-	}
-      }
-      if (occupied) {
+      if (sites.contains(s)) {
 	walk_failed = true;
 	break;
       }
 
-      sites.push_back(s);
+      sites.insert(s);
+      observables.add(s);
     }
 
     if (walk_failed) {
@@ -50,13 +44,20 @@ void SAWalk::run() {
       continue;
     }
 
-    double r2 = s.x * s.x + s.y * s.y;
+    double r2 = L::distance2(s, origin);
     r2av += r2;
     r4av += r2 * r2;
+    rg2av += observables.rg2();
     ++walks;
   }
 
   r2av /= n_walks;
   r4av /= n_walks;
+  rg2av /= n_walks;
   stdDev = sqrt(r4av - r2av * r2av);
 }
+
+template class LatticeSAWalk<SquareLattice>;
+template class LatticeSAWalk<TriangularLattice>;
+template class LatticeSAWalk<CubicLattice>;
+template class LatticeSAWalk<FCCLattice>;
@@ -8,17 +8,21 @@
 #include <vector>
 #include <random>
 
-struct Site {               // object to represent lattice site
-    int x;                  // x coordinate
-    int y;                  // y coordinate
-};
+#include "chain_observables.h"
+#include "lattice.h"
+#include "site_set.h"
 
-class SAWalk{
+// Self-avoiding walks on lattice L (lattice.h) by simple sampling;
+// sawalk.cpp instantiates the four lattices there.
+template <typename L>
+class LatticeSAWalk{
 
 public: 
-  SAWalk(unsigned int n_steps_in, unsigned int n_walks_in):  
-  rd(), gen(rd()), dis(0,4),
-  n_steps(n_steps_in), n_walks(n_walks_in),walks(0),failed_walks(0),r2av(0.), r4av(0.), stdDev(0.) {
+  typedef typename L::site_type site_type;
+
+  LatticeSAWalk(unsigned int n_steps_in, unsigned int n_walks_in):  
+  rd(), gen(rd()), dis(0, L::coordination - 1),
+  n_steps(n_steps_in), n_walks(n_walks_in),walks(0),failed_walks(0),r2av(0.), r4av(0.), stdDev(0.), rg2av(0.) {
   };
 
   void run();
@@ -30,6 +34,7 @@ public:
   double get_r2av() const {return r2av; }
   double get_r4av() const {return r4av; }
   double get_stdDev() const {return stdDev;}
+  double get_rg2av() const {return rg2av;}
 
 protected:
   std::random_device rd;
@@ -42,8 +47,17 @@ protected:
   double r2av;
   double r4av;
   double stdDev; 
-  std::vector<Site> sites;
+  double rg2av;
+  BasicSiteSet<site_type> sites;  // sites visited by the current walk
+  LatticeChainObservables<L> observables;  // running sums over them
 };
 
+#ifndef SWIG
+typedef LatticeSAWalk<SquareLattice> SAWalk;
+typedef LatticeSAWalk<TriangularLattice> TriangularSAWalk;
+typedef LatticeSAWalk<CubicLattice> CubicSAWalk;
+typedef LatticeSAWalk<FCCLattice> FCCSAWalk;
+#endif
+
 
 #endif
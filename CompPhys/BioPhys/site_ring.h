@@ -0,0 +1,77 @@
+#ifndef site_ring_h
+#define site_ring_h
+
+#include <cstddef>
+#include <vector>
+
+#include "site_set.h"
+
+// Double-ended queue of lattice sites in a circular buffer: a
+// power-of-two array and the index of the front, so both ends push and
+// pop in place with one mask. After reserve(n) nothing allocates while
+// at most n sites are stored; beyond that the buffer doubles.
+template <typename S>
+class BasicSiteRing {
+public:
+
+  BasicSiteRing(std::size_t n = 8) : head_(0), size_(0) { reserve(n); }
+
+  // room for n sites without growing
+  void reserve(std::size_t n) {
+    std::size_t cap = 8;
+    while (cap < n)
+      cap *= 2;
+    if (cap <= sites_.size())
+      return;
+    std::vector<S> old(cap);
+    for (std::size_t i = 0; i < size_; i++)
+      old[i] = (*this)[i];
+    sites_.swap(old);
+    mask_ = cap - 1;
+    head_ = 0;
+  }
+
+  void clear() { head_ = size_ = 0; }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // i-th site from the front
+  S const & operator[](std::size_t i) const { return sites_[(head_ + i) & mask_]; }
+  S & operator[](std::size_t i) { return sites_[(head_ + i) & mask_]; }
+  S const & front() const { return sites_[head_]; }
+  S const & back() const { return (*this)[size_ - 1]; }
+
+  void push_front(S s) {
+    if (size_ == sites_.size())
+      reserve(2 * size_);
+    head_ = (head_ - 1) & mask_;
+    sites_[head_] = s;
+    ++size_;
+  }
+
+  void push_back(S s) {
+    if (size_ == sites_.size())
+      reserve(2 * size_);
+    sites_[(head_ + size_) & mask_] = s;
+    ++size_;
+  }
+
+  void pop_front() {
+    head_ = (head_ + 1) & mask_;
+    --size_;
+  }
+
+  void pop_back() { --size_; }
+
+protected:
+
+  std::vector<S> sites_;      // circular buffer
+  std::size_t mask_;          // buffer size - 1
+  std::size_t head_;          // index of the front site
+  std::size_t size_;          // number of sites stored
+};
+
+typedef BasicSiteRing<Site> SiteRing;
+
+#endif
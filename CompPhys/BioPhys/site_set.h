@@ -0,0 +1,199 @@
+#ifndef site_set_h
+#define site_set_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lattice.h"
+
+
+// Set of lattice sites with open addressing: the coordinates packed
+// into one 64-bit key by site_key(), a power-of-two table kept at most
+// half full, linear probing, and deletion by shifting the rest of the
+// probe run back instead of leaving tombstones, so runs stay short over
+// any number of insert/erase pairs. After reserve(n) nothing allocates
+// while at most n sites are stored. In 2D the site (INT_MIN, INT_MIN)
+// marks empty slots and cannot be stored.
+template <typename S>
+class BasicSiteSet {
+public:
+
+  BasicSiteSet(std::size_t n = 8) : size_(0) { reserve(n); }
+
+  // room for n sites without growing
+  void reserve(std::size_t n) {
+    std::vector<std::uint64_t> old;
+    if (!regrow(n, old))
+      return;
+    for (std::size_t i = 0; i < old.size(); i++)
+      if (old[i] != vacant())
+        insert_key(old[i]);
+  }
+
+  void clear() {
+    std::fill(table_.begin(), table_.end(), vacant());
+    size_ = 0;
+  }
+
+  std::size_t size() const { return size_; }
+
+  bool contains(S s) const {
+    std::uint64_t k = key(s);
+    return table_[find(k)] == k;
+  }
+
+  // false if s was already there
+  bool insert(S s) {
+    if (2 * (size_ + 1) > table_.size())
+      reserve(size_ + 1);
+    return insert_key(key(s));
+  }
+
+  // false if s was not there
+  bool erase(S s) {
+    return erase_key(key(s), [](std::size_t, std::size_t) { });
+  }
+
+protected:
+
+  static std::uint64_t vacant() { return site_key_vacant(); }
+
+  static std::uint64_t key(S s) { return site_key(s); }
+
+  // Fibonacci hashing: the top bits of the key times 2^64 / golden ratio
+  std::size_t slot(std::uint64_t k) const {
+    return std::size_t((k * 0x9E3779B97F4A7C15ull) >> shift_);
+  }
+
+  // slot holding k, or the empty slot where it would go
+  std::size_t find(std::uint64_t k) const {
+    std::size_t i = slot(k);
+    while (table_[i] != k && table_[i] != vacant())
+      i = (i + 1) & mask_;
+    return i;
+  }
+
+  bool insert_key(std::uint64_t k) {
+    std::size_t i = find(k);
+    if (table_[i] == k)
+      return false;
+    table_[i] = k;
+    ++size_;
+    return true;
+  }
+
+  // Moves every later entry of the run whose home slot does not lie
+  // cyclically in (i, j] back into the hole at i, so lookups never stop
+  // early there; move(i, j) is told about each such move.
+  template <typename Move>
+  bool erase_key(std::uint64_t k, Move move) {
+    std::size_t i = find(k);
+    if (table_[i] != k)
+      return false;
+    for (std::size_t j = (i + 1) & mask_; table_[j] != vacant(); j = (j + 1) & mask_) {
+      std::size_t home = slot(table_[j]);
+      bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays) {
+        table_[i] = table_[j];
+        move(i, j);
+        i = j;
+      }
+    }
+    table_[i] = vacant();
+    --size_;
+    return true;
+  }
+
+  // an empty table for n sites, the current one swapped into old, unless
+  // it is big enough already
+  bool regrow(std::size_t n, std::vector<std::uint64_t>& old) {
+    std::size_t cap = 16;
+    int shift = 60;
+    while (cap < 2 * n) {
+      cap *= 2;
+      --shift;
+    }
+    if (cap <= table_.size())
+      return false;
+    old.swap(table_);
+    table_.assign(cap, vacant());
+    mask_ = cap - 1;
+    shift_ = shift;
+    size_ = 0;
+    return true;
+  }
+
+  std::vector<std::uint64_t> table_;   // keys, or vacant()
+  std::size_t mask_;                   // table size - 1
+  int shift_;                          // 64 - log2(table size)
+  std::size_t size_;                   // number of sites stored
+};
+
+
+// Map from lattice sites to ints, e.g. their positions along a walk:
+// a BasicSiteSet with the values in a second array, slot by slot.
+template <typename S>
+class BasicSiteMap : public BasicSiteSet<S> {
+  typedef BasicSiteSet<S> base;
+  using base::table_;
+  using base::size_;
+  using base::vacant;
+  using base::key;
+  using base::find;
+
+public:
+
+  BasicSiteMap(std::size_t n = 8) : base(n), values_(table_.size()) { }
+
+  void reserve(std::size_t n) {
+    std::vector<std::uint64_t> old;
+    if (!this->regrow(n, old))
+      return;
+    std::vector<int> old_values(table_.size());
+    old_values.swap(values_);
+    for (std::size_t i = 0; i < old.size(); i++)
+      if (old[i] != vacant()) {
+        std::size_t j = find(old[i]);
+        table_[j] = old[i];
+        values_[j] = old_values[i];
+        ++size_;
+      }
+  }
+
+  // value stored with s, or missing if s is not there
+  int get(S s, int missing = -1) const {
+    std::uint64_t k = key(s);
+    std::size_t i = find(k);
+    return table_[i] == k ? values_[i] : missing;
+  }
+
+  // sets the value of s, inserting it if need be; false if s was there
+  bool insert(S s, int value) {
+    if (2 * (size_ + 1) > table_.size())
+      reserve(size_ + 1);
+    std::uint64_t k = key(s);
+    std::size_t i = find(k);
+    values_[i] = value;
+    if (table_[i] == k)
+      return false;
+    table_[i] = k;
+    ++size_;
+    return true;
+  }
+
+  bool erase(S s) {
+    return this->erase_key(key(s), [this](std::size_t i, std::size_t j) { values_[i] = values_[j]; });
+  }
+
+protected:
+
+  std::vector<int> values_;            // value of the key in the same slot
+};
+
+
+typedef BasicSiteSet<Site> SiteSet;
+typedef BasicSiteMap<Site> SiteMap;
+
+#endif
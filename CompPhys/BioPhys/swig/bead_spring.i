@@ -0,0 +1,15 @@
+%module bead_spring
+/* First: Include your own code.*/
+%{
+#define SWIG_FILE_WITH_INIT
+#include "bead_spring.h"
+%}
+
+%include "std_vector.i"
+
+%include "lattice.h"
+%include "bead_spring.h"
+
+namespace std {
+   %template(vector_bead) vector<Bead>;
+};
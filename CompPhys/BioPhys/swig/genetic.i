@@ -0,0 +1,39 @@
+%module genetic
+/* First: Include your own code.*/
+%{
+#define SWIG_FILE_WITH_INIT
+#include "hp_model.h"
+%}
+
+%include "stdint.i"
+%include "std_string.i"
+%include "std_vector.i"
+
+%include "lattice.h"
+
+namespace std {
+   %template(vector_double) vector<double>;
+   %template(vector_uint64) vector<uint64_t>;
+   %template(vector_site) vector<Site>;
+   %template(vector_site3) vector<Site3>;
+};
+
+// GeneticAlgorithm keeps its Fitness by reference: the wrapper holds on
+// to the Python object as well, so that a temporary such as
+// GeneticAlgorithm(HPFitness("HPPH")) is not collected under it
+%pythonappend GeneticAlgorithm::GeneticAlgorithm %{
+    self._problem = args[0]
+%}
+
+%include "genetic.h"
+
+namespace std {
+   %template(vector_genome) vector<Genome>;
+};
+
+%include "hp_model.h"
+
+%template(HPFitness) LatticeHPFitness<SquareLattice>;
+%template(TriangularHPFitness) LatticeHPFitness<TriangularLattice>;
+%template(CubicHPFitness) LatticeHPFitness<CubicLattice>;
+%template(FCCHPFitness) LatticeHPFitness<FCCLattice>;
@@ -0,0 +1,15 @@
+%module hh_network
+/* First: Include your own code.*/
+%{
+#define SWIG_FILE_WITH_INIT
+#include "hh_network.h"
+%}
+
+%include "std_vector.i"
+
+namespace std {
+   %template(vector_double) vector<double>;
+   %template(vector_int) vector<int>;
+};
+
+%include "hh_network.h"
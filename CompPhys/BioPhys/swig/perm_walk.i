@@ -0,0 +1,14 @@
+%module perm_walk
+/* First: Include your own code.*/
+%{
+#define SWIG_FILE_WITH_INIT
+#include "perm_walk.h"
+%}
+
+%include "std_vector.i"
+
+namespace std {
+   %template(vector_double) vector<double>;
+};
+
+%include "perm_walk.h"
@@ -0,0 +1,16 @@
+%module pivot_walk
+/* First: Include your own code.*/
+%{
+#define SWIG_FILE_WITH_INIT
+#include "pivot_walk.h"
+%}
+
+%include "std_vector.i"
+
+%include "lattice.h"
+
+namespace std {
+   %template(vector_site) vector<Site>;
+};
+
+%include "pivot_walk.h"
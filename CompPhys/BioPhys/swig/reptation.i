@@ -8,11 +8,33 @@
 %include "std_vector.i"
 %include "std_deque.i"
 
+%include "lattice.h"
+
 namespace std {
    %template(vector_double) vector<double>;
+   %template(vector_longlong) vector<long long>;
+   %template(vector_site) vector<Site>;
+   %template(vector_site3) vector<Site3>;
    %template(deque_site) deque<Site>;
    %template(vector_deque_site) vector<deque<Site>>;
+   %template(deque_site3) deque<Site3>;
+   %template(vector_deque_site3) vector<deque<Site3>>;
 };
 
+%include "chain_observables.h"
 %include "reptation.h"
 
+%template(ChainObservables) LatticeChainObservables<SquareLattice>;
+%template(TriangularChainObservables) LatticeChainObservables<TriangularLattice>;
+%template(CubicChainObservables) LatticeChainObservables<CubicLattice>;
+%template(FCCChainObservables) LatticeChainObservables<FCCLattice>;
+%template(StructureFactor) LatticeStructureFactor<SquareLattice>;
+%template(TriangularStructureFactor) LatticeStructureFactor<TriangularLattice>;
+%template(CubicStructureFactor) LatticeStructureFactor<CubicLattice>;
+%template(FCCStructureFactor) LatticeStructureFactor<FCCLattice>;
+
+%template(Reptation) LatticeReptation<SquareLattice>;
+%template(TriangularReptation) LatticeReptation<TriangularLattice>;
+%template(CubicReptation) LatticeReptation<CubicLattice>;
+%template(FCCReptation) LatticeReptation<FCCLattice>;
+
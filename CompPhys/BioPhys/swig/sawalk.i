@@ -11,5 +11,11 @@ namespace std {
    %template(vector_double) vector<double>;
 };
 
+%include "lattice.h"
 %include "sawalk.h"
 
+%template(SAWalk) LatticeSAWalk<SquareLattice>;
+%template(TriangularSAWalk) LatticeSAWalk<TriangularLattice>;
+%template(CubicSAWalk) LatticeSAWalk<CubicLattice>;
+%template(FCCSAWalk) LatticeSAWalk<FCCLattice>;
+
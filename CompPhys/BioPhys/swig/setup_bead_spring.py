@@ -0,0 +1,21 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG bead_spring
+"""
+
+from distutils.core import setup, Extension
+
+
+bead_spring_module = Extension('_bead_spring',
+                           sources=['swig/bead_spring_wrap.cxx', 'bead_spring.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3"],
+                           )
+
+setup (name = 'bead_spring',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """Off-lattice bead-spring chain""",
+       ext_modules = [bead_spring_module],
+       py_modules = ["bead_spring"],
+       )
@@ -0,0 +1,22 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG genetic
+"""
+
+from distutils.core import setup, Extension
+
+
+genetic_module = Extension('_genetic',
+                           sources=['swig/genetic_wrap.cxx', 'genetic.cpp', 'hp_model.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3", "-pthread"],
+                           extra_link_args=["-pthread"],
+                           )
+
+setup (name = 'genetic',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """Genetic algorithm and HP-model lattice proteins""",
+       ext_modules = [genetic_module],
+       py_modules = ["genetic"],
+       )
@@ -0,0 +1,22 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG hh_network
+"""
+
+from distutils.core import setup, Extension
+
+
+hh_network_module = Extension('_hh_network',
+                           sources=['swig/hh_network_wrap.cxx', 'hh_network.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3", "-pthread"],
+                           extra_link_args=["-pthread"],
+                           )
+
+setup (name = 'hh_network',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """Networks of Hodgkin-Huxley neurons""",
+       ext_modules = [hh_network_module],
+       py_modules = ["hh_network"],
+       )
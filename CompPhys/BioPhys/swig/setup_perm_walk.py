@@ -0,0 +1,22 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG perm_walk
+"""
+
+from distutils.core import setup, Extension
+
+
+perm_walk_module = Extension('_perm_walk',
+                           sources=['swig/perm_walk_wrap.cxx', 'perm_walk.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3", "-pthread"],
+                           extra_link_args=["-pthread"],
+                           )
+
+setup (name = 'perm_walk',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """PERM growth of self-avoiding walks""",
+       ext_modules = [perm_walk_module],
+       py_modules = ["perm_walk"],
+       )
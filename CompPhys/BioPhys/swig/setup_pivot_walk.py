@@ -0,0 +1,21 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG pivot_walk
+"""
+
+from distutils.core import setup, Extension
+
+
+pivot_walk_module = Extension('_pivot_walk',
+                           sources=['swig/pivot_walk_wrap.cxx', 'pivot_walk.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3"],
+                           )
+
+setup (name = 'pivot_walk',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """Pivot algorithm for self-avoiding walks""",
+       ext_modules = [pivot_walk_module],
+       py_modules = ["pivot_walk"],
+       )
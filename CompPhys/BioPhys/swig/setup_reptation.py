@@ -8,8 +8,9 @@ from distutils.core import setup, Extension
 
 
 reptation_module = Extension('_reptation',
-                           sources=['swig/reptation_wrap.cxx', 'reptation.cpp'],
-                           extra_compile_args=["-I./", "-std=c++11", "-O3"],
+                           sources=['swig/reptation_wrap.cxx', 'reptation.cpp', 'chain_observables.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3", "-pthread"],
+                           extra_link_args=["-pthread"],
                            )
 
 setup (name = 'reptation',
@@ -0,0 +1,153 @@
+#ifndef worker_team_h
+#define worker_team_h
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent team of threads shared by the BioPhys modules. parallel_for
+// is for loops over items of unequal cost, such as the fitness
+// evaluations of a population: every thread, the caller included, takes
+// chunks of grain items off a shared counter until none are left.
+// run_each is for work split by thread, such as independent chains with
+// their own sums or neurons stepped in lockstep: f(t) runs once on each
+// thread t, all of them at the same time, so f may wait at a barrier for
+// the others. The threads are started once, so a loop costs a wake-up
+// rather than thread creation.
+//
+// QM/thread_pool.h and PDEs/thread_team.h do the same for their own
+// directories; each directory builds on its own, without headers from
+// the others.
+class WorkerTeam {
+public:
+
+  // n threads in total, the calling thread included; n <= 0 uses every core
+  WorkerTeam(int n = 0) : next(0), generation(0), remaining(0), stop(false)
+  {
+    if (n <= 0)
+      n = std::thread::hardware_concurrency();
+    if (n <= 0)
+      n = 1;
+    n_threads = n;
+    for (int t = 1; t < n_threads; ++t)
+      workers.push_back(std::thread(&WorkerTeam::work, this, t));
+  }
+
+  ~WorkerTeam()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+      ++generation;
+    }
+    cv_start.notify_all();
+    for (unsigned int t = 0; t < workers.size(); ++t)
+      workers[t].join();
+  }
+
+  int size() const { return n_threads; }
+
+  // f(b, e) on chunks covering [begin, end), returning once all are done
+  void parallel_for(int begin, int end, std::function<void(int,int)> const & f, int grain = 1)
+  {
+    if (grain < 1)
+      grain = 1;
+    if (n_threads == 1 || end - begin <= grain) {
+      if (end > begin)
+        f(begin, end);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m);
+      task = &f;
+      next = begin;
+      last = end;
+      chunk = grain;
+      remaining = n_threads - 1;
+      ++generation;
+    }
+    cv_start.notify_all();
+    run_chunks();
+    std::unique_lock<std::mutex> lock(m);
+    cv_done.wait(lock, [this]() { return remaining == 0; });
+    task = 0;
+  }
+
+  // f(t) on every thread t = 0 .. size() - 1 at once, 0 the caller,
+  // returning once all are done
+  void run_each(std::function<void(int)> const & f)
+  {
+    if (n_threads == 1) {
+      f(0);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m);
+      each = &f;
+      remaining = n_threads - 1;
+      ++generation;
+    }
+    cv_start.notify_all();
+    f(0);
+    std::unique_lock<std::mutex> lock(m);
+    cv_done.wait(lock, [this]() { return remaining == 0; });
+    each = 0;
+  }
+
+protected:
+
+  void run_chunks()
+  {
+    for (;;) {
+      int b = next.fetch_add(chunk);
+      if (b >= last)
+        return;
+      (*task)(b, b + chunk < last ? b + chunk : last);
+    }
+  }
+
+  void work(int t)
+  {
+    unsigned long seen = 0;
+    for (;;) {
+      std::function<void(int)> const * f;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv_start.wait(lock, [this, seen]() { return generation != seen; });
+        seen = generation;
+        if (stop)
+          return;
+        f = each;
+      }
+      if (f)
+        (*f)(t);
+      else
+        run_chunks();
+      {
+        std::lock_guard<std::mutex> lock(m);
+        if (--remaining == 0)
+          cv_done.notify_one();
+      }
+    }
+  }
+
+  int n_threads;                                 // team size including the caller
+  std::vector<std::thread> workers;
+
+  std::mutex m;
+  std::condition_variable cv_start;              // new loop published
+  std::condition_variable cv_done;               // all helpers finished
+  std::function<void(int,int)> const * task = 0;  // loop of parallel_for
+  std::function<void(int)> const * each = 0;     // or work of run_each
+  std::atomic<int> next;                         // first item not yet taken
+  int last = 0;                                  // end of the range
+  int chunk = 1;                                 // items taken at a time
+  unsigned long generation;                      // bumped for every loop
+  int remaining;                                 // helpers still running
+  bool stop;
+};
+
+#endif
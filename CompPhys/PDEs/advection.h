@@ -0,0 +1,359 @@
+// Explicit schemes for linear advection and Burgers' equation on periodic grids
+#ifndef advection_h
+#define advection_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+
+
+// flux of linear advection, f(u) = c u
+template< typename T >
+struct linear_flux {
+  T c;
+  T f( T u ) const { return c * u; }
+  T a( T ) const { return c; }                       // f'(u)
+  T godunov( T ul, T ur ) const { return c >= 0 ? c * ul : c * ur; }
+};
+
+// flux of Burgers' equation, f(u) = u^2 / 2
+template< typename T >
+struct burgers_flux {
+  T f( T u ) const { return T(0.5) * u * u; }
+  T a( T u ) const { return u; }
+  // exact Riemann flux, as in burgers.ipynb
+  T godunov( T ul, T ur ) const {
+    T up = std::max( ul, T(0) ), um = std::min( ur, T(0) );
+    return T(0.5) * std::max( up * up, um * um );
+  }
+};
+
+
+// Time stepping of
+//
+//   du/dt + d f(u)/dx [+ d f(u)/dy] = nu laplacian(u)
+//
+// with f(u) = c u (LINEAR, velocity (cx, cy)) or f(u) = u^2 / 2 (BURGERS)
+// on a periodic box, in the conservative form of the advection.ipynb and
+// burgers.ipynb notebooks:
+//
+//   UPWIND        first order, Godunov flux (upwind for LINEAR)
+//   LAX_WENDROFF  second order, Jacobian at the mean of neighbouring cells
+//   MACCORMACK    second order predictor-corrector; the one-sided
+//                 differences swap direction every step
+//
+// The optional viscosity nu is explicit, nu dt / dx^2 <= 1/2 for stability.
+// In 2D the directions are split, and the order of the two sweeps
+// alternates from step to step. A sweep across rows runs over tiles of
+// columns so the three rows of the stencil stay in L1; rows (in 1D tiles
+// of the line) are split across the thread team.
+template< typename T >
+class advection {
+public :
+
+  typedef std::vector<T> vector_type;
+  typedef std::vector< std::vector<T> > matrix_type;
+
+  enum { LINEAR = 0, BURGERS };
+  enum { UPWIND = 0, LAX_WENDROFF, MACCORMACK };
+
+  // 1D: u_in holds one period, u_k at x = k dx
+  advection( vector_type const & u_in, T dx, T dt, int iequation = LINEAR,
+	     int ischeme = LAX_WENDROFF, int in_threads = 1 ) :
+    dim_(1), nx_(1), ny_(u_in.size()), dt_(dt), nu_(0), t_(0), steps_(0),
+    equation_(iequation), scheme_(ischeme), team_(in_threads)
+  {
+    h_[0] = h_[1] = dx;
+    c_[0] = 0;
+    c_[1] = 1;
+    allocate();
+    for (int j = 0; j < ny_; j++)
+      u_(1, j + 1) = u_in[j];
+  }
+
+  // 2D: u_in is nx x ny, u_ij at x = i dx, y = j dy
+  advection( matrix_type const & u_in, T dx, T dy, T dt, int iequation = LINEAR,
+	     int ischeme = LAX_WENDROFF, int in_threads = 1 ) :
+    dim_(2), nx_(u_in.size()), ny_(u_in.empty() ? 0 : u_in[0].size()), dt_(dt), nu_(0),
+    t_(0), steps_(0), equation_(iequation), scheme_(ischeme), team_(in_threads)
+  {
+    h_[0] = dx;
+    h_[1] = dy;
+    c_[0] = 1;
+    c_[1] = 0;
+    allocate();
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++)
+	u_(i + 1, j + 1) = u_in[i][j];
+  }
+
+  void step()
+  {
+    if ( dim_ == 1 )
+      sweep( 1 );
+    else if ( steps_ % 2 == 0 ) {
+      sweep( 0 );
+      sweep( 1 );
+    } else {
+      sweep( 1 );
+      sweep( 0 );
+    }
+    t_ += dt_;
+    ++steps_;
+  }
+
+  void evolve( int n_steps )
+  {
+    for (int s = 0; s < n_steps; s++)
+      step();
+  }
+
+  // largest |f'(u)| dt / dx over the grid and the directions
+  T courant() const
+  {
+    T cfl = 0;
+    for (int d = 2 - dim_; d < 2; d++) {
+      T a = std::fabs( c_[d] );
+      if ( equation_ == BURGERS ) {
+	a = 0;
+	for (int i = 1; i <= nx_; i++)
+	  for (int j = 1; j <= ny_; j++)
+	    a = std::max( a, std::fabs( u_(i, j) ) );
+      }
+      cfl = std::max( cfl, a * dt_ / h_[d] );
+    }
+    return cfl;
+  }
+
+  // integral of u over the box, conserved by all schemes
+  T total() const
+  {
+    T sum = 0;
+    for (int i = 1; i <= nx_; i++)
+      for (int j = 1; j <= ny_; j++)
+	sum += u_(i, j);
+    return sum * ( dim_ == 1 ? h_[1] : h_[0] * h_[1] );
+  }
+
+  // u as nested vectors, one row in 1D
+  matrix_type get_u() const
+  {
+    matrix_type m( nx_, vector_type( ny_ ) );
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++)
+	m[i][j] = u_(i + 1, j + 1);
+    return m;
+  }
+
+  T get_u( int k ) const { return u_(1, k + 1); }
+  T get_u( int i, int j ) const { return u_(i + 1, j + 1); }
+  void set_u( int k, T u ) { u_(1, k + 1) = u; }
+  void set_u( int i, int j, T u ) { u_(i + 1, j + 1) = u; }
+
+  // one period of u as a binary field file (field_io.h), 1D or 2D, with
+  // the current time
+  bool write_u( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
+  {
+    field_header h( dtype );
+    h.time = t_;
+    if ( dim_ == 1 ) {
+      h.spacing[0] = h_[1];
+      return write_field( file, u_.row(1) + 1, ny_, h, FIELD_MMAP, preview );
+    }
+    h.spacing[0] = h_[0];
+    h.spacing[1] = h_[1];
+    return write_field( file, u_, 1, 1, nx_, ny_, h, FIELD_MMAP, preview );
+  }
+
+  // velocity of LINEAR; in 1D only cx is used
+  void set_velocity( T cx, T cy = 0 )
+  {
+    if ( dim_ == 1 )
+      c_[1] = cx;
+    else {
+      c_[0] = cx;
+      c_[1] = cy;
+    }
+  }
+
+  void set_viscosity( T nu ) { nu_ = nu; }
+  void set_dt( T dt ) { dt_ = dt; }
+  void set_scheme( int ischeme ) { scheme_ = ischeme; }
+  void set_equation( int iequation ) { equation_ = iequation; }
+
+  T get_t() const { return t_; }
+  T get_dt() const { return dt_; }
+  int get_steps() const { return steps_; }
+  int get_nx() const { return nx_; }
+  int get_ny() const { return ny_; }
+  int get_n_threads() const { return team_.size(); }
+
+protected :
+
+  void allocate()
+  {
+    u_.resize( nx_ + 2, ny_ + 2 );
+    w_.resize( nx_ + 2, ny_ + 2 );
+    p_.resize( nx_ + 2, ny_ + 2 );
+  }
+
+  // one split step along direction d (0: across rows, x in 2D; 1: along rows)
+  void sweep( int d )
+  {
+    if ( equation_ == BURGERS )
+      sweep( burgers_flux<T>(), d );
+    else {
+      linear_flux<T> fl;
+      fl.c = c_[d];
+      sweep( fl, d );
+    }
+  }
+
+  template< class Flux >
+  void sweep( Flux const & fl, int d )
+  {
+    T lambda = dt_ / h_[d];
+    T nud = nu_ * dt_ / ( h_[d] * h_[d] );
+    fill_ghosts( u_, d );
+    grid2d<T> const & u = u_;
+    grid2d<T> & w = w_;
+
+    if ( scheme_ == MACCORMACK ) {
+      // forward predictor and backward corrector on even steps, the
+      // reverse on odd ones; the sign of the stride does that
+      grid2d<T> & p = p_;
+      int sign = steps_ % 2 == 0 ? 1 : -1;
+      for_lines( d, [&, sign, lambda, nud](int i, int j, int n, std::ptrdiff_t s) {
+	  predictor_line( fl, &u(i, j), &p(i, j), n, sign * s, lambda, nud );
+	} );
+      fill_ghosts( p_, d );
+      for_lines( d, [&, sign, lambda, nud](int i, int j, int n, std::ptrdiff_t s) {
+	  corrector_line( fl, &u(i, j), &p(i, j), &w(i, j), n, sign * s, lambda, nud );
+	} );
+    } else if ( scheme_ == UPWIND ) {
+      for_lines( d, [&, lambda, nud](int i, int j, int n, std::ptrdiff_t s) {
+	  upwind_line( fl, &u(i, j), &w(i, j), n, s, lambda, nud );
+	} );
+    } else {
+      for_lines( d, [&, lambda, nud](int i, int j, int n, std::ptrdiff_t s) {
+	  lax_wendroff_line( fl, &u(i, j), &w(i, j), n, s, lambda, nud );
+	} );
+    }
+    std::swap( u_, w_ );
+  }
+
+  // Call line(i, j, n, s) on pieces of rows covering the interior, with s
+  // the distance between neighbours along direction d. Across rows the
+  // pieces are tiles of columns, walked row by row, so rows i and i + 1
+  // are still in cache for row i + 1.
+  template< class Line >
+  void for_lines( int d, Line const & line )
+  {
+    std::ptrdiff_t s = d == 0 ? u_.stride() : 1;
+    int nx = nx_, ny = ny_, tl = tile;
+    if ( nx == 1 ) {
+      team_.parallel_for( 0, (ny + tl - 1) / tl, [&line, ny, s, tl](int t0, int t1) {
+	  for (int t = t0; t < t1; t++) {
+	    int j = 1 + t * tl;
+	    line( 1, j, std::min( tl, ny + 1 - j ), s );
+	  }
+	}, 2 );
+      return;
+    }
+    team_.parallel_for( 1, nx + 1, [&line, ny, s, tl](int i0, int i1) {
+	for (int j = 1; j <= ny; j += tl)
+	  for (int i = i0; i < i1; i++)
+	    line( i, j, std::min( tl, ny + 1 - j ), s );
+      }, min_rows_per_thread );
+  }
+
+  // periodic images of the first and last row (d = 0) or column (d = 1)
+  void fill_ghosts( grid2d<T> & g, int d )
+  {
+    if ( d == 0 ) {
+      std::copy( g.row(nx_) + 1, g.row(nx_) + ny_ + 1, g.row(0) + 1 );
+      std::copy( g.row(1) + 1, g.row(1) + ny_ + 1, g.row(nx_ + 1) + 1 );
+    } else {
+      for (int i = 1; i <= nx_; i++) {
+	g(i, 0) = g(i, ny_);
+	g(i, ny_ + 1) = g(i, 1);
+      }
+    }
+  }
+
+  // The line kernels update n points out[k] from in[k - s], in[k], in[k + s];
+  // lambda = dt / h and nud = nu dt / h^2.
+
+  template< class Flux >
+  static void upwind_line( Flux const & fl, T const * __restrict in, T * __restrict out,
+			   int n, std::ptrdiff_t s, T lambda, T nud )
+  {
+    for (int k = 0; k < n; k++) {
+      T um = in[k - s], u0 = in[k], up = in[k + s];
+      T fp = fl.godunov( u0, up ), fm = fl.godunov( um, u0 );
+      out[k] = u0 - lambda * (fp - fm) + nud * (um - 2 * u0 + up);
+    }
+  }
+
+  template< class Flux >
+  static void lax_wendroff_line( Flux const & fl, T const * __restrict in, T * __restrict out,
+				 int n, std::ptrdiff_t s, T lambda, T nud )
+  {
+    T l1 = T(0.5) * lambda, l2 = T(0.5) * lambda * lambda;
+    for (int k = 0; k < n; k++) {
+      T um = in[k - s], u0 = in[k], up = in[k + s];
+      T fm = fl.f( um ), f0 = fl.f( u0 ), fp = fl.f( up );
+      T ap = fl.a( T(0.5) * (u0 + up) ), am = fl.a( T(0.5) * (um + u0) );
+      out[k] = u0 - l1 * (fp - fm) + l2 * ( ap * (fp - f0) - am * (f0 - fm) )
+	+ nud * (um - 2 * u0 + up);
+    }
+  }
+
+  template< class Flux >
+  static void predictor_line( Flux const & fl, T const * __restrict in, T * __restrict out,
+			      int n, std::ptrdiff_t s, T lambda, T nud )
+  {
+    // s < 0 makes the difference backward, so the flux difference changes sign
+    T l = s > 0 ? lambda : -lambda;
+    for (int k = 0; k < n; k++) {
+      T um = in[k - s], u0 = in[k], up = in[k + s];
+      out[k] = u0 - l * ( fl.f( up ) - fl.f( u0 ) ) + nud * (um - 2 * u0 + up);
+    }
+  }
+
+  template< class Flux >
+  static void corrector_line( Flux const & fl, T const * __restrict in, T const * __restrict pred,
+			      T * __restrict out, int n, std::ptrdiff_t s, T lambda, T nud )
+  {
+    T l = s > 0 ? lambda : -lambda;
+    for (int k = 0; k < n; k++) {
+      T pm = pred[k - s], p0 = pred[k], pp = pred[k + s];
+      out[k] = T(0.5) * ( in[k] + p0 - l * ( fl.f( p0 ) - fl.f( pm ) )
+			  + nud * (pm - 2 * p0 + pp) );
+    }
+  }
+
+  int dim_;               // 1 or 2; in 1D the line is row 1
+  int nx_, ny_;           // points per period across and along rows
+  T h_[2];                // spacing across rows (x in 2D) and along them
+  T c_[2];                // velocity of LINEAR in the same directions
+  T dt_;                  // time step
+  T nu_;                  // viscosity
+  T t_;                   // time
+  int steps_;             // steps taken
+  int equation_;          // LINEAR or BURGERS
+  int scheme_;            // UPWIND, LAX_WENDROFF or MACCORMACK
+  grid2d<T> u_;           // solution with a layer of periodic images
+  grid2d<T> w_;           // next solution
+  grid2d<T> p_;           // MacCormack predictor
+  thread_team team_;      // threads sharing the rows
+  static const int tile = 512;                 // columns per tile
+  static const int min_rows_per_thread = 16;
+};
+
+#endif
@@ -0,0 +1,125 @@
+// Text output as poisson_mg.cpp used to write it against the binary field
+// files of field_io.h, and a check that they read back exactly. The
+// files go to directory, else to $TMPDIR or /tmp, and are removed at the
+// end; at the default L they take some 800 MB.
+//
+//   usage: bench_field_io [L] [directory]
+#include "poisson_mg.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+using namespace std;
+
+double seconds_since(chrono::steady_clock::time_point t0)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+long long file_size(string const & name)
+{
+  ifstream f(name.c_str(), ios::binary | ios::ate);
+  return f ? (long long)(f.tellg()) : -1;
+}
+
+int main(int argc, char * argv[])
+{
+  int L = argc > 1 ? atoi(argv[1]) : 4095;
+  char const * tmp = getenv("TMPDIR");
+  string dir = string(argc > 2 ? argv[2] : tmp && *tmp ? tmp : "/tmp") + "/";
+
+  // any smooth field will do; no need to solve
+  poisson_mg<double>::matrix_type rho;
+  poisson_mg<double> pmg(rho, 1e-6, L);
+  double h = pmg.get_h();
+  for (int i = 1; i <= L; i++)
+    for (int j = 1; j <= L; j++)
+      pmg.set_psi(i, j, sin(3.1 * i * h) * cos(2.3 * j * h) + i * j * h * h);
+
+  cout << " L = " << L << endl << setw(32) << "output" << setw(12) << "time(s)"
+       << setw(14) << "size(MB)" << endl;
+  auto report = [](char const * what, double t, string const & name) {
+    cout << setw(32) << what << setw(12) << t << setw(14) << file_size(name) / 1e6 << endl;
+  };
+
+  string text = dir + "bench_field_io.data";
+  auto t0 = chrono::steady_clock::now();
+  {
+    ofstream file(text.c_str());
+    for (int i = 0; i < L + 2; i++) {
+      double x = i * h;
+      for (int j = 0; j < L + 2; j++) {
+	double y = j * h;
+	file << x << '\t' << y << '\t' << pmg.get_psi(i, j) << '\n';
+      }
+      file << '\n';
+    }
+  }
+  report("text, ofstream", seconds_since(t0), text);
+
+  string bin = dir + "bench_field_io.field";
+  t0 = chrono::steady_clock::now();
+  bool ok = pmg.write_psi(bin);
+  report("binary, mmap", seconds_since(t0), bin);
+
+  string buffered = dir + "bench_field_io_buffered.field";
+  field_header head;
+  head.spacing[0] = head.spacing[1] = h;
+  poisson_mg<double>::grid_type const & psi = pmg.get_level(0).u;
+  t0 = chrono::steady_clock::now();
+  ok = write_field(buffered, psi, 0, 0, L + 2, L + 2, head, FIELD_BUFFERED) && ok;
+  report("binary, 4 MB chunks", seconds_since(t0), buffered);
+
+  string single = dir + "bench_field_io_float.field";
+  t0 = chrono::steady_clock::now();
+  ok = pmg.write_psi(single, FIELD_FLOAT32, 16) && ok;
+  report("float32 + 16 x 16 preview", seconds_since(t0), single);
+
+  // read back: doubles exactly, floats to single precision, and the
+  // preview as the block averages
+  field_header hr;
+  vector<double> values;
+  t0 = chrono::steady_clock::now();
+  ok = read_field(bin, hr, values) && ok;
+  double t_read = seconds_since(t0);
+  double diff = 0, diff_float = 0, diff_buffered = 0;
+  for (int i = 0; i < L + 2; i++)
+    for (int j = 0; j < L + 2; j++)
+      diff = max(diff, fabs(values[size_t(i) * (L + 2) + j] - pmg.get_psi(i, j)));
+  cout << " read back in " << t_read << " s, max difference " << diff;
+  vector<double> other;
+  ok = read_field(buffered, hr, other, FIELD_BUFFERED) && ok;
+  for (size_t k = 0; k < values.size(); k++)
+    diff_buffered = max(diff_buffered, fabs(other[k] - values[k]));
+  ok = read_field(single, hr, other) && ok;
+  for (size_t k = 0; k < values.size(); k++)
+    diff_float = max(diff_float, fabs(other[k] - values[k]) / max(1.0, fabs(values[k])));
+  cout << ", buffered " << diff_buffered << ", float32 " << diff_float << endl;
+
+  field_header hp;
+  string preview = dir + "bench_field_io_float.preview.field";
+  ok = read_field(preview, hp, other) && ok;
+  double diff_preview = 0;
+  int m = (L + 2) / 16;
+  for (int a = 0; a < m; a++)
+    for (int b = 0; b < m; b++) {
+      double mean = 0;
+      for (int i = 16 * a; i < 16 * (a + 1); i++)
+	for (int j = 16 * b; j < 16 * (b + 1); j++)
+	  mean += pmg.get_psi(i, j) / 256;
+      diff_preview = max(diff_preview, fabs(other[size_t(a) * m + b] - mean));
+    }
+  cout << " preview " << hp.dims[0] << " x " << hp.dims[1] << ", spacing " << hp.spacing[0]
+       << ", origin " << hp.origin[0] << ", max difference " << diff_preview << endl;
+
+  string written[5] = { text, bin, buffered, single, preview };
+  for (int k = 0; k < 5; k++)
+    remove(written[k].c_str());
+
+  if (!ok || diff != 0 || diff_buffered != 0 || diff_float > 1e-6 || diff_preview > 1e-6
+      || hr.dims[0] != size_t(L + 2) || hr.spacing[0] != h) {
+    cout << " field files do not read back" << endl;
+    return EXIT_FAILURE;
+  }
+}
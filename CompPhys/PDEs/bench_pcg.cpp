@@ -0,0 +1,83 @@
+// Iterations and time to tolerance of multigrid cycles against conjugate
+// gradients preconditioned with one V-cycle (set_krylov)
+//
+//   usage: bench_pcg [n] [threads]
+#include "poisson_mg.h"
+#include "poisson_mg_var.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+using namespace std;
+
+const double accuracy = 1e-8;
+
+template< typename Solver >
+void report(char const * problem, char const * method, Solver & pmg)
+{
+  auto t0 = chrono::steady_clock::now();
+  pmg.execute();
+  auto t1 = chrono::steady_clock::now();
+  vector<double> const & r = pmg.get_residuals();
+  cout << setw(26) << problem << setw(10) << method
+       << setw(8) << pmg.get_steps()
+       << setw(11) << chrono::duration<double>(t1 - t0).count()
+       << setw(14) << r.back() / r.front() << endl;
+}
+
+int main(int argc, char * argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 512;
+  int n_threads = argc > 2 ? atoi(argv[2]) : 1;
+  int n_smooth = 2;
+
+  cout << "                   problem    method   steps    time(s)     reduction" << endl;
+
+  // constant coefficients: point charge as in poisson_mg.cpp
+  {
+    int L = n - 1;
+    poisson_mg<double>::matrix_type rho;
+    poisson_mg<double>::init_matrix( rho, L+2, L+2 );
+    rho[L/2 + 1][L/2 + 1] = 1.0 * (L + 1) * (L + 1);
+    for (int krylov = 0; krylov < 2; krylov++) {
+      poisson_mg<double> pmg(rho, accuracy, L, n_smooth, n_threads);
+      pmg.set_verbose(false);
+      pmg.set_fmg(false);
+      pmg.set_krylov(krylov);
+      report("point charge, eps = 1", krylov ? "V-PCG" : "V-cycle", pmg);
+    }
+  }
+
+  // rough coefficients on n x n cells: an unaligned eps = 1000 inclusion,
+  // and eps = exp(2 g) with independent Gaussian g in every cell
+  typedef poisson_mg_var<double> var_type;
+  var_type::matrix_type rho, eps_box, eps_rough;
+  var_type::init_matrix( rho, n+2, n+2 );
+  var_type::init_matrix( eps_box, n+2, n+2 );
+  var_type::init_matrix( eps_rough, n+2, n+2 );
+  mt19937 gen(12345);
+  normal_distribution<double> gauss;
+  double h = 1.0 / n;
+  for (int i = 1; i <= n; i++)
+    for (int j = 1; j <= n; j++) {
+      double x = (i - 0.5) * h, y = (j - 0.5) * h;
+      rho[i][j] = sin(6.28318530718 * x) + y;
+      eps_box[i][j] = fabs(x - 0.5) < 0.2 && fabs(y - 0.5) < 0.13 ? 1000 : 1;
+      eps_rough[i][j] = exp(2 * gauss(gen));
+    }
+
+  char const * names[2] = { "inclusion, eps 1 / 1000", "random eps = exp(2 g)" };
+  var_type::matrix_type const * eps[2] = { &eps_box, &eps_rough };
+  char const * methods[3] = { "V-cycle", "W-cycle", "V-PCG" };
+  for (int c = 0; c < 2; c++)
+    for (int m = 0; m < 3; m++) {
+      var_type pmg(rho, *eps[c], n, n, h, accuracy, n_smooth, n_threads);
+      pmg.set_verbose(false);
+      pmg.set_fmg(false);
+      pmg.set_boundary(var_type::WEST, var_type::PERIODIC);
+      pmg.set_cycle_type(m == 1 ? var_type::W_CYCLE : var_type::V_CYCLE);
+      pmg.set_krylov(m == 2);
+      pmg.set_max_cycles(500);
+      report(names[c], methods[m], pmg);
+    }
+}
@@ -0,0 +1,94 @@
+// poisson_fft against poisson_mg::execute() over grid sizes
+//
+//   usage: bench_poisson_fft [L_max] [threads]
+#include "poisson_fft.h"
+#include "poisson_mg.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+using namespace std;
+
+// largest |-laplacian(psi) - rho| over the interior, rho neutralized if
+// the box is periodic
+double max_residual(poisson_fft<double> const & pf, bool periodic)
+{
+  int nx = pf.get_nx(), ny = pf.get_ny();
+  double h2 = pf.get_h() * pf.get_h(), mean = 0;
+  if (periodic) {
+    for (int i = 1; i <= nx; i++)
+      for (int j = 1; j <= ny; j++)
+	mean += pf.get_rho(i, j);
+    mean /= double(nx) * ny;
+  }
+  double res = 0;
+  for (int i = 1; i <= nx; i++)
+    for (int j = 1; j <= ny; j++) {
+      double lap = (pf.get_psi(i + 1, j) + pf.get_psi(i - 1, j) + pf.get_psi(i, j + 1)
+		    + pf.get_psi(i, j - 1) - 4 * pf.get_psi(i, j)) / h2;
+      res = max(res, fabs(-lap - (pf.get_rho(i, j) - mean)));
+    }
+  return res;
+}
+
+int main(int argc, char * argv[])
+{
+  int L_max = argc > 1 ? atoi(argv[1]) : 2047;
+  int n_threads = argc > 2 ? atoi(argv[2]) : 1;
+
+  // the discrete equations must hold to round-off, also for lengths
+  // that are not powers of two
+  mt19937 gen(1);
+  uniform_real_distribution<double> uniform(-1, 1);
+  int sizes[3][2] = { {64, 64}, {100, 75}, {31, 129} };
+  bool ok = true;
+  for (int bc = 0; bc < 2; bc++)
+    for (int s = 0; s < 3; s++) {
+      int nx = sizes[s][0], ny = sizes[s][1];
+      poisson_fft<double>::matrix_type rho;
+      poisson_fft<double>::init_matrix(rho, nx + 2, ny + 2);
+      for (int i = 1; i <= nx; i++)
+	for (int j = 1; j <= ny; j++)
+	  rho[i][j] = uniform(gen);
+      poisson_fft<double> pf(rho, nx, ny, bc, 0, n_threads);
+      pf.execute();
+      double res = max_residual(pf, bc == poisson_fft<double>::PERIODIC);
+      cout << (bc ? " periodic " : " dirichlet") << setw(5) << nx << " x" << setw(4) << ny
+	   << "  max residual " << res << endl;
+      if (res > 1e-9)
+	ok = false;
+    }
+  if (!ok) {
+    cout << " poisson_fft does not solve the discrete equations" << endl;
+    return EXIT_FAILURE;
+  }
+
+  // point charge as in poisson_mg.cpp; multigrid to a 1e-10 residual
+  // reduction
+  cout << endl << setw(6) << "L" << setw(12) << "fft(s)" << setw(12) << "mg(s)"
+       << setw(11) << "mg cycles" << setw(25) << "max |psi_fft - psi_mg|" << endl;
+  for (int L = 63; L <= L_max; L = 2 * L + 1) {
+    poisson_mg<double>::matrix_type rho;
+    poisson_mg<double>::init_matrix(rho, L + 2, L + 2);
+    rho[L/2 + 1][L/2 + 1] = 1.0 * (L + 1) * (L + 1);
+
+    auto t0 = chrono::steady_clock::now();
+    poisson_fft<double> pf(rho, L, L, poisson_fft<double>::DIRICHLET, 0, n_threads);
+    pf.execute();
+    auto t1 = chrono::steady_clock::now();
+    poisson_mg<double> pmg(rho, 1e-10, L, 3, n_threads);
+    pmg.set_verbose(false);
+    pmg.execute();
+    auto t2 = chrono::steady_clock::now();
+
+    double diff = 0;
+    for (int i = 1; i <= L; i++)
+      for (int j = 1; j <= L; j++)
+	diff = max(diff, fabs(pf.get_psi(i, j) - pmg.get_psi(i, j)));
+    cout << setw(6) << L << setprecision(4)
+	 << setw(12) << chrono::duration<double>(t1 - t0).count()
+	 << setw(12) << chrono::duration<double>(t2 - t1).count()
+	 << setw(11) << pmg.get_steps()
+	 << setw(25) << diff << setprecision(6) << endl;
+  }
+}
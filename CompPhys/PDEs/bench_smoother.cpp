@@ -0,0 +1,42 @@
+#include "poisson_mg.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <thread>
+using namespace std;
+
+// Red-black Gauss-Seidel throughput in grid points per second
+// for a range of grid sizes and thread counts
+int main(int argc, char ** argv)
+{
+  int max_threads = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+  if (max_threads < 1)
+    max_threads = 1;
+
+  cout << " Red-black Gauss-Seidel smoothing throughput\n"
+       << " -------------------------------------------\n"
+       << setw(8) << "L" << setw(10) << "threads" << setw(16) << "points/s" << endl;
+
+  for (int L = 256; L <= 4096; L *= 2) {
+    poisson_mg<double>::matrix_type rho;
+    poisson_mg<double>::init_matrix( rho, L+2, L+2 );
+    rho[L/2][L/2] = 1.0;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+      poisson_mg<double> pmg(rho, 1e-6, L, 1, threads);
+      poisson_mg<double>::level_type & fine = pmg.get_level(0);
+
+      // enough sweeps for about 2e9 point updates in total
+      int sweeps = max(4, static_cast<int>(2e9 / (double(L) * L)));
+      pmg.Gauss_Seidel( fine );
+      auto t0 = chrono::steady_clock::now();
+      for (int s = 0; s < sweeps; s++)
+	pmg.Gauss_Seidel( fine );
+      auto t1 = chrono::steady_clock::now();
+      double seconds = chrono::duration<double>(t1 - t0).count();
+
+      cout << setw(8) << L << setw(10) << threads
+	   << setw(16) << setprecision(4) << double(L) * L * sweeps / seconds << endl;
+    }
+  }
+}
@@ -0,0 +1,334 @@
+// Crank-Nicolson diffusion in 1D and alternating-direction implicit in 2D
+#ifndef crank_nicolson_h
+#define crank_nicolson_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+
+
+// Solves m systems of the n x n tridiagonal matrix with b on the diagonal
+// and a next to it, with the corners (a) filled in if periodic. Element k
+// of system l is x[k * step + l], so the m systems are eliminated
+// together in one vectorizable pass per k. The factorization depends
+// only on a, b and n and is computed once; the periodic matrix goes
+// through the Sherman-Morrison formula with a precomputed correction z.
+template< typename T >
+class tridiagonal {
+public :
+
+  tridiagonal() : n_(0), a_(0), gamma_(0), denom_(1), periodic_(false) {}
+
+  void init( int n, T a, T b, bool periodic )
+  {
+    n_ = n;
+    a_ = a;
+    periodic_ = periodic && n > 2;
+    std::vector<T> diag( n, b );
+    if ( periodic_ ) {
+      gamma_ = -b;
+      diag[0] = b - gamma_;
+      diag[n - 1] = b - a * a / gamma_;
+    }
+    cp_.resize( n );
+    inv_.resize( n );
+    for (int k = 0; k < n; k++) {
+      inv_[k] = T(1) / ( diag[k] - ( k > 0 ? a * cp_[k - 1] : T(0) ) );
+      cp_[k] = a * inv_[k];
+    }
+    if ( periodic_ ) {
+      z_.assign( n, T(0) );
+      z_[0] = gamma_;
+      z_[n - 1] = a;
+      solve_plain( &z_[0], 1, 1 );
+      denom_ = 1 + z_[0] + a * z_[n - 1] / gamma_;
+    }
+  }
+
+  void solve( T * x, std::ptrdiff_t step, int m ) const
+  {
+    solve_plain( x, step, m );
+    if ( !periodic_ )
+      return;
+    // in chunks of lanes, so the factors fit on the stack
+    const int chunk = 64;
+    for (int l0 = 0; l0 < m; l0 += chunk) {
+      int nl = std::min( chunk, m - l0 );
+      T f[chunk];
+      T const * x0 = x + l0;
+      T const * xn = x + (n_ - 1) * step + l0;
+      for (int l = 0; l < nl; l++)
+	f[l] = ( x0[l] + a_ * xn[l] / gamma_ ) / denom_;
+      for (int k = 0; k < n_; k++) {
+	T * __restrict xk = x + k * step + l0;
+	T zk = z_[k];
+	for (int l = 0; l < nl; l++)
+	  xk[l] -= f[l] * zk;
+      }
+    }
+  }
+
+protected :
+
+  // Thomas algorithm without the corners
+  void solve_plain( T * x, std::ptrdiff_t step, int m ) const
+  {
+    T a = a_;
+    for (int l = 0; l < m; l++)
+      x[l] *= inv_[0];
+    for (int k = 1; k < n_; k++) {
+      T * __restrict xk = x + k * step;
+      T const * __restrict xm = x + (k - 1) * step;
+      T ik = inv_[k];
+      for (int l = 0; l < m; l++)
+	xk[l] = ( xk[l] - a * xm[l] ) * ik;
+    }
+    for (int k = n_ - 2; k >= 0; k--) {
+      T * __restrict xk = x + k * step;
+      T const * __restrict xp = x + (k + 1) * step;
+      T ck = cp_[k];
+      for (int l = 0; l < m; l++)
+	xk[l] -= ck * xp[l];
+    }
+  }
+
+  int n_;
+  T a_;                   // off-diagonal element
+  T gamma_;               // Sherman-Morrison shift of the first diagonal element
+  T denom_;               // 1 + v . z
+  bool periodic_;
+  std::vector<T> cp_;     // eliminated super-diagonal
+  std::vector<T> inv_;    // inverse pivots
+  std::vector<T> z_;      // solution for the corner correction
+};
+
+
+// Time stepping of du/dt = D laplacian(u) on n (1D) or nx x ny (2D) points
+// with spacing h. The arrays include a layer of boundary points like the
+// grids of poisson_mg: interior points 1 .. n, and for DIRICHLET the
+// fixed values in the layer (points 0 and n + 1). In a PERIODIC direction
+// points 1 .. n are one period and the layer is ignored.
+//
+// 1D is Crank-Nicolson,
+//
+//   (1 - r/2 d2) u(t + dt) = (1 + r/2 d2) u(t),   r = D dt / h^2,
+//
+// and 2D the Peaceman-Rachford alternating-direction form of it: a half
+// step implicit in x and explicit in y, then the reverse. Both are second
+// order in dt and h and stable for any dt. The implicit directions are
+// solved with tridiagonal; across rows, a block of columns is eliminated
+// together, one vectorized row operation per step of the recurrence.
+template< typename T >
+class crank_nicolson {
+public :
+
+  typedef std::vector<T> vector_type;
+  typedef std::vector< std::vector<T> > matrix_type;
+
+  enum { DIRICHLET = 0, PERIODIC };
+  enum { X = 0, Y };
+
+  // 1D: u_in holds n + 2 values, x_k = k h
+  crank_nicolson( vector_type const & u_in, T ih, T idt, T iD = 1, int ibc = DIRICHLET,
+		  int in_threads = 1 ) :
+    dim_(1), nx_(1), ny_(static_cast<int>(u_in.size()) - 2), h_(ih), dt_(idt), D_(iD),
+    t_(0), steps_(0), factored_(false), team_(in_threads)
+  {
+    bc_[X] = bc_[Y] = ibc;
+    allocate();
+    for (int k = 0; k < ny_ + 2; k++)
+      u_(1, k) = u_in[k];
+    w_ = u_;
+  }
+
+  // 2D: u_in is (nx + 2) x (ny + 2), u_ij at x = i h, y = j h
+  crank_nicolson( matrix_type const & u_in, T ih, T idt, T iD = 1, int ibc = DIRICHLET,
+		  int in_threads = 1 ) :
+    dim_(2), nx_(static_cast<int>(u_in.size()) - 2),
+    ny_(u_in.empty() ? 0 : static_cast<int>(u_in[0].size()) - 2),
+    h_(ih), dt_(idt), D_(iD), t_(0), steps_(0), factored_(false), team_(in_threads)
+  {
+    bc_[X] = bc_[Y] = ibc;
+    allocate();
+    for (int i = 0; i < nx_ + 2; i++)
+      for (int j = 0; j < ny_ + 2; j++)
+	u_(i, j) = u_in[i][j];
+    w_ = u_;
+  }
+
+  void step()
+  {
+    if ( !factored_ )
+      factor();
+    T c = T(0.5) * D_ * dt_ / ( h_ * h_ );
+    if ( dim_ == 1 ) {
+      explicit_part( u_, w_, Y, c );
+      implicit_part( w_, Y, c );
+      std::swap( u_, w_ );
+    } else {
+      explicit_part( u_, w_, Y, c );
+      implicit_part( w_, X, c );
+      explicit_part( w_, u_, X, c );
+      implicit_part( u_, Y, c );
+    }
+    t_ += dt_;
+    ++steps_;
+  }
+
+  void evolve( int n_steps )
+  {
+    for (int s = 0; s < n_steps; s++)
+      step();
+  }
+
+  // u with the boundary layer as nested vectors, one row in 1D
+  matrix_type get_u() const
+  {
+    int i0 = dim_ == 1 ? 1 : 0, i1 = dim_ == 1 ? 2 : nx_ + 2;
+    matrix_type m( i1 - i0, vector_type( ny_ + 2 ) );
+    for (int i = i0; i < i1; i++)
+      for (int j = 0; j < ny_ + 2; j++)
+	m[i - i0][j] = u_(i, j);
+    return m;
+  }
+
+  T get_u( int k ) const { return u_(1, k); }
+  T get_u( int i, int j ) const { return u_(i, j); }
+  void set_u( int k, T u ) { u_(1, k) = w_(1, k) = u; }
+  void set_u( int i, int j, T u ) { u_(i, j) = w_(i, j) = u; }
+
+  // u with the boundary layer as a binary field file (field_io.h), 1D or
+  // 2D, with the current time
+  bool write_u( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
+  {
+    field_header h( dtype );
+    h.time = t_;
+    h.spacing[0] = h.spacing[1] = h_;
+    if ( dim_ == 1 )
+      return write_field( file, u_.row(1), ny_ + 2, h, FIELD_MMAP, preview );
+    return write_field( file, u_, 0, 0, nx_ + 2, ny_ + 2, h, FIELD_MMAP, preview );
+  }
+
+  // boundary condition along direction X or Y; in 1D only Y exists
+  void set_boundary( int dir, int type ) { bc_[dir] = type; factored_ = false; }
+  void set_dt( T dt ) { dt_ = dt; factored_ = false; }
+  void set_D( T D ) { D_ = D; factored_ = false; }
+
+  T get_x( int i ) const { return i * h_; }
+  T get_t() const { return t_; }
+  T get_dt() const { return dt_; }
+  T get_h() const { return h_; }
+  int get_steps() const { return steps_; }
+  int get_nx() const { return dim_ == 1 ? ny_ : nx_; }
+  int get_ny() const { return ny_; }
+  int get_n_threads() const { return team_.size(); }
+
+protected :
+
+  void allocate()
+  {
+    u_.resize( nx_ + 2, ny_ + 2 );
+    w_.resize( nx_ + 2, ny_ + 2 );
+  }
+
+  void factor()
+  {
+    T c = T(0.5) * D_ * dt_ / ( h_ * h_ );
+    solver_[X].init( nx_, -c, 1 + 2 * c, bc_[X] == PERIODIC );
+    solver_[Y].init( ny_, -c, 1 + 2 * c, bc_[Y] == PERIODIC );
+    factored_ = true;
+  }
+
+  // out = (1 + c d2) in on the interior, d2 the second difference along dir
+  void explicit_part( grid2d<T> & in, grid2d<T> & out, int dir, T c )
+  {
+    fill_periodic( in, dir );
+    grid2d<T> const & a = in;
+    std::ptrdiff_t s = dir == X ? a.stride() : 1;
+    int ny = ny_;
+    team_.parallel_for( 1, nx_ + 1, [&a, &out, s, ny, c](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * __restrict ai = a.row(i);
+	  T * __restrict oi = out.row(i);
+	  for (int j = 1; j <= ny; j++)
+	    oi[j] = ai[j] + c * ( ai[j - s] - 2 * ai[j] + ai[j + s] );
+	}
+      }, min_rows_per_thread );
+  }
+
+  // solve (1 - c d2) g = g along dir, with the Dirichlet values of the
+  // boundary layer moved to the right hand side
+  void implicit_part( grid2d<T> & g, int dir, T c )
+  {
+    int nx = nx_, ny = ny_;
+    bool dirichlet = bc_[dir] == DIRICHLET;
+    tridiagonal<T> const & solver = solver_[dir];
+    if ( dir == Y ) {
+      team_.parallel_for( 1, nx + 1, [&g, &solver, dirichlet, ny, c](int i0, int i1) {
+	  for (int i = i0; i < i1; i++) {
+	    T * gi = g.row(i);
+	    if ( dirichlet ) {
+	      gi[1] += c * gi[0];
+	      gi[ny] += c * gi[ny + 1];
+	    }
+	    solver.solve( gi + 1, 1, 1 );
+	  }
+	}, min_rows_per_thread );
+      return;
+    }
+
+    // across rows: blocks of columns eliminated together
+    if ( dirichlet )
+      for (int j = 1; j <= ny; j++) {
+	g(1, j) += c * g(0, j);
+	g(nx, j) += c * g(nx + 1, j);
+      }
+    int tl = tile;
+    std::ptrdiff_t s = g.stride();
+    team_.parallel_for( 0, (ny + tl - 1) / tl, [&g, &solver, ny, s, tl](int t0, int t1) {
+	for (int t = t0; t < t1; t++) {
+	  int j = 1 + t * tl;
+	  solver.solve( &g(1, j), s, std::min( tl, ny + 1 - j ) );
+	}
+      }, 1 );
+  }
+
+  // periodic images in the layer along dir
+  void fill_periodic( grid2d<T> & g, int dir )
+  {
+    if ( bc_[dir] != PERIODIC )
+      return;
+    if ( dir == X ) {
+      std::copy( g.row(nx_) + 1, g.row(nx_) + ny_ + 1, g.row(0) + 1 );
+      std::copy( g.row(1) + 1, g.row(1) + ny_ + 1, g.row(nx_ + 1) + 1 );
+    } else {
+      for (int i = 1; i <= nx_; i++) {
+	g(i, 0) = g(i, ny_);
+	g(i, ny_ + 1) = g(i, 1);
+      }
+    }
+  }
+
+  int dim_;                    // 1 or 2; in 1D the line is row 1 and runs along Y
+  int nx_, ny_;                // interior points across and along rows
+  T h_;                        // spacing
+  T dt_;                       // time step
+  T D_;                        // diffusion constant
+  T t_;                        // time
+  int steps_;                  // steps taken
+  int bc_[2];                  // DIRICHLET or PERIODIC along X and Y
+  bool factored_;              // solver_ matches h, dt and D
+  tridiagonal<T> solver_[2];   // implicit half steps along X and Y
+  grid2d<T> u_;                // solution with the boundary layer
+  grid2d<T> w_;                // after the first half step
+  thread_team team_;           // threads sharing rows or column blocks
+  static const int tile = 64;                  // columns eliminated together
+  static const int min_rows_per_thread = 16;
+};
+
+#endif
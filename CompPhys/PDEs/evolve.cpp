@@ -0,0 +1,312 @@
+// Convergence checks of advection, crank_nicolson and split_operator
+// against exact solutions, and the time per step on an n x n grid
+//
+//   usage: evolve [n] [threads]
+#include "advection.h"
+#include "crank_nicolson.h"
+#include "split_operator.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+using namespace std;
+
+const double pi = 4 * atan(1.0);
+bool ok = true;
+
+// error ratios between successive refinements must reach min_ratio
+void check(char const * name, vector<double> const & err, double min_ratio)
+{
+  cout << setw(34) << left << name << right;
+  for (size_t k = 0; k < err.size(); k++)
+    cout << setw(12) << err[k];
+  double ratio = err[err.size() - 2] / err.back();
+  cout << "   ratio " << setw(5) << setprecision(3) << ratio << setprecision(6) << endl;
+  if (!(ratio >= min_ratio)) {
+    cout << "   expected at least " << min_ratio << endl;
+    ok = false;
+  }
+}
+
+// Burgers' equation with u(x, 0) = sin(2 pi x) before the shock: solve
+// u = sin(2 pi (x - u t)) along the characteristics
+double burgers_exact(double x, double t)
+{
+  double u = sin(2 * pi * x);
+  for (int it = 0; it < 100; it++) {
+    double s = 2 * pi * (x - u * t);
+    double du = (u - sin(s)) / (1 + 2 * pi * t * cos(s));
+    u -= du;
+    if (fabs(du) < 1e-15)
+      break;
+  }
+  return u;
+}
+
+// 1D advection of one period of sin(2 pi x) at c = 1, or Burgers' equation
+// up to t = 0.1, on n points
+double advect_1d(int equation, int scheme, int n, int n_threads)
+{
+  typedef advection<double> adv;
+  double dx = 1.0 / n, t_end = equation == adv::LINEAR ? 1.0 : 0.1;
+  int steps = int(ceil(t_end / (0.4 * dx)));
+  vector<double> u0(n);
+  for (int k = 0; k < n; k++)
+    u0[k] = sin(2 * pi * k * dx);
+  adv a(u0, dx, t_end / steps, equation, scheme, n_threads);
+  a.evolve(steps);
+  double err = 0;
+  for (int k = 0; k < n; k++) {
+    double x = k * dx;
+    double exact = equation == adv::LINEAR ? u0[k] : burgers_exact(x, t_end);
+    err = max(err, fabs(a.get_u(k) - exact));
+  }
+  return err;
+}
+
+// sin(2 pi x) sin(2 pi y) carried once across the unit box at c = (1, 1)
+double advect_2d(int scheme, int n, int n_threads)
+{
+  typedef advection<double> adv;
+  double h = 1.0 / n;
+  int steps = int(ceil(1 / (0.4 * h)));
+  adv::matrix_type u0(n, adv::vector_type(n));
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      u0[i][j] = sin(2 * pi * i * h) * sin(2 * pi * j * h);
+  adv a(u0, h, h, 1.0 / steps, adv::LINEAR, scheme, n_threads);
+  a.set_velocity(1, 1);
+  a.evolve(steps);
+  double err = 0;
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      err = max(err, fabs(a.get_u(i, j) - u0[i][j]));
+  return err;
+}
+
+// Diffusion up to t = 1/8 with dt = h. 1D: sin(pi x) between zero
+// Dirichlet values, or 1 + sin(2 pi x) periodic. 2D: x + sin(pi x) sin(pi y)
+// with u = x on the boundary, or cos(kx x) sin(pi y), periodic in x with
+// period n h. dt and h are halved together, so n + 1 (n if periodic)
+// is a power of two.
+double diffuse(int dim, int bc, int n, int n_threads)
+{
+  typedef crank_nicolson<double> cn;
+  bool periodic = bc == cn::PERIODIC;
+  double h = dim == 1 && periodic ? 1.0 / n : 1.0 / (n + 1), t_end = 0.125;
+  int steps = int(ceil(t_end / h));
+  double err = 0;
+  if (dim == 1) {
+    double k = periodic ? 2 * pi : pi;
+    cn::vector_type u0(n + 2);
+    for (int j = 1; j <= n; j++)
+      u0[j] = (periodic ? 1 : 0) + sin(k * j * h);
+    cn d(u0, h, t_end / steps, 1.0, bc, n_threads);
+    d.evolve(steps);
+    for (int j = 1; j <= n; j++)
+      err = max(err, fabs(d.get_u(j) - (periodic ? 1 : 0) - exp(-k * k * t_end) * sin(k * j * h)));
+    return err;
+  }
+  double kx = periodic ? 2 * pi / (n * h) : pi;
+  auto exact = [=](double x, double y, double t) {
+    return periodic ? exp(-(kx * kx + pi * pi) * t) * cos(kx * x) * sin(pi * y)
+                    : x + exp(-2 * pi * pi * t) * sin(pi * x) * sin(pi * y);
+  };
+  cn::matrix_type u0(n + 2, cn::vector_type(n + 2));
+  for (int i = 0; i <= n + 1; i++)
+    for (int j = 0; j <= n + 1; j++)
+      u0[i][j] = exact(i * h, j * h, 0);
+  cn d(u0, h, t_end / steps, 1.0, cn::DIRICHLET, n_threads);
+  d.set_boundary(cn::X, bc);
+  d.evolve(steps);
+  for (int i = 1; i <= n; i++)
+    for (int j = 1; j <= n; j++)
+      err = max(err, fabs(d.get_u(i, j) - exact(i * h, j * h, t_end)));
+  return err;
+}
+
+// Free Gaussian packet of width sigma, centre x0 and wave number k0 on a
+// periodic box of length L (the tails are below round-off at the edges);
+// returns the largest error of |psi|^2 against the exact spreading packet
+double free_packet(int dim, int n, double dt, int steps, int n_threads, double & norm_error)
+{
+  typedef split_operator<double> so;
+  double L = 100, dx = L / n, sigma = 2.5, x0 = 45, k0 = 1;
+  auto packet = [=](double x, double t) {
+    // |psi|^2 of the 1D packet, m = hbar = 1
+    double s2 = sigma * sigma * (1 + pow(t / (2 * sigma * sigma), 2));
+    double d = x - x0 - k0 * t;
+    return exp(-d * d / (2 * s2)) / sqrt(2 * pi * s2);
+  };
+  auto psi0 = [=](double x) {
+    return exp(-pow(x - x0, 2) / (4 * sigma * sigma)) / pow(2 * pi * sigma * sigma, 0.25)
+      * complex<double>(cos(k0 * x), sin(k0 * x));
+  };
+  double t = dt * steps, err = 0;
+  if (dim == 1) {
+    so s(so::vector_type(n, 0.0), dx, dt, 1.0, n_threads);
+    for (int k = 0; k < n; k++) {
+      complex<double> z = psi0(k * dx);
+      s.set_psi(k, z.real(), z.imag());
+    }
+    s.evolve(steps);
+    for (int k = 0; k < n; k++)
+      err = max(err, fabs(norm(s.get_psi(k)) - packet(k * dx, t)));
+    norm_error = fabs(s.norm() - 1);
+    return err;
+  }
+  so s(so::matrix_type(n, so::vector_type(n, 0.0)), dx, dx, dt, 1.0, n_threads);
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++) {
+      complex<double> z = psi0(i * dx) * psi0(j * dx);
+      s.set_psi(i, j, z.real(), z.imag());
+    }
+  s.evolve(steps);
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      err = max(err, fabs(norm(s.get_psi(i, j)) - packet(i * dx, t) * packet(j * dx, t)));
+  norm_error = fabs(s.norm() - 1);
+  return err;
+}
+
+// The packet of wavepacket.ipynb on the barrier V = 0.5 for 62.5 < x < 87.5
+// of a box of length 100, up to t = 40; returns psi on the grid
+vector< complex<double> > barrier(int n, double dt, double & norm_error)
+{
+  typedef split_operator<double> so;
+  double L = 100, dx = L / n, sigma = L / 10, x0 = L / 4;
+  double k0 = sqrt(2 * 1.0 - 0.5 / (sigma * sigma));
+  so::vector_type V(n);
+  for (int k = 0; k < n; k++)
+    V[k] = fabs(k * dx - 0.75 * L) <= 5 ? 0.5 : 0;
+  so s(V, dx, dt);
+  for (int k = 0; k < n; k++) {
+    double x = k * dx;
+    double a = exp(-pow(x - x0, 2) / (2 * sigma * sigma)) / sqrt(sigma * sqrt(pi));
+    s.set_psi(k, a * cos(k0 * x), a * sin(k0 * x));
+  }
+  double norm0 = s.norm();
+  s.evolve(int(round(40 / dt)));
+  norm_error = fabs(s.norm() / norm0 - 1);
+  vector< complex<double> > psi(n);
+  for (int k = 0; k < n; k++)
+    psi[k] = s.get_psi(k);
+  return psi;
+}
+
+template< typename Stepper >
+double time_steps(Stepper & s, int steps)
+{
+  auto t0 = chrono::steady_clock::now();
+  s.evolve(steps);
+  auto t1 = chrono::steady_clock::now();
+  return chrono::duration<double>(t1 - t0).count() / steps;
+}
+
+int main(int argc, char * argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 1024;
+  int n_threads = argc > 2 ? atoi(argv[2]) : 1;
+  typedef advection<double> adv;
+  typedef crank_nicolson<double> cn;
+  char const * schemes[3] = { "upwind", "Lax-Wendroff", "MacCormack" };
+  double min_ratio[3] = { 1.8, 3.5, 3.5 };
+
+  cout << "max errors at n = 64, 128, 256 (advection), 256, 512, 1024 (Burgers),"
+       << " 32, 64, 128 (diffusion)" << endl;
+  for (int equation = 0; equation < 2; equation++)
+    for (int scheme = 0; scheme < 3; scheme++) {
+      vector<double> err;
+      for (int m = 64; m <= 256; m *= 2)
+	err.push_back(advect_1d(equation, scheme, equation == adv::BURGERS ? 4 * m : m, n_threads));
+      string name = string(equation == adv::LINEAR ? "advection 1D " : "Burgers 1D ") + schemes[scheme];
+      check(name.c_str(), err, min_ratio[scheme]);
+    }
+  for (int scheme = 0; scheme < 3; scheme++) {
+    vector<double> err;
+    for (int m = 64; m <= 256; m *= 2)
+      err.push_back(advect_2d(scheme, m, n_threads));
+    string name = string("advection 2D ") + schemes[scheme];
+    check(name.c_str(), err, min_ratio[scheme]);
+  }
+  for (int dim = 1; dim <= 2; dim++)
+    for (int bc = 0; bc < 2; bc++) {
+      vector<double> err;
+      for (int m = 32; m <= 128; m *= 2)
+	err.push_back(diffuse(dim, bc, dim == 1 && bc == cn::PERIODIC ? m : m - 1, n_threads));
+      string name = string(dim == 1 ? "Crank-Nicolson 1D" : "ADI 2D")
+	+ (bc == cn::PERIODIC ? (dim == 1 ? " periodic" : " periodic in x") : " Dirichlet");
+      check(name.c_str(), err, 3.5);
+    }
+
+  // shock: conservation and, for upwind, no new extrema
+  for (int scheme = 0; scheme < 3; scheme++) {
+    int m = 256;
+    double dx = 1.0 / m;
+    vector<double> u0(m);
+    for (int k = 0; k < m; k++)
+      u0[k] = sin(2 * pi * k * dx);
+    adv a(u0, dx, 0.4 * dx, adv::BURGERS, scheme, n_threads);
+    double total0 = a.total();
+    a.evolve(int(0.5 / a.get_dt()));
+    double u_max = 0;
+    for (int k = 0; k < m; k++)
+      u_max = max(u_max, fabs(a.get_u(k)));
+    cout << "Burgers shock at t = 0.5, " << setw(13) << left << schemes[scheme] << right
+	 << " change of total " << setw(12) << fabs(a.total() - total0)
+	 << "  max |u| " << u_max << endl;
+    if (fabs(a.total() - total0) > 1e-12 || (scheme == adv::UPWIND && u_max > 1 + 1e-12))
+      ok = false;
+  }
+
+  // free packets are exact up to round-off, whatever dt
+  for (int dim = 1; dim <= 2; dim++) {
+    double norm_error;
+    double err = free_packet(dim, dim == 1 ? 1024 : 256, 0.5, 20, n_threads, norm_error);
+    cout << "free packet " << dim << "D, t = 10: max error of |psi|^2 " << err
+	 << ", norm error " << norm_error << endl;
+    if (err > 1e-10 || norm_error > 1e-12)
+      ok = false;
+  }
+
+  // barrier: second order in dt against a run with dt / 8
+  {
+    double norm_error, e;
+    vector< complex<double> > ref = barrier(1024, 0.0125, e);
+    vector<double> err;
+    for (double dt = 0.2; dt >= 0.05; dt /= 2) {
+      vector< complex<double> > psi = barrier(1024, dt, norm_error);
+      double d = 0;
+      for (size_t k = 0; k < psi.size(); k++)
+	d = max(d, abs(psi[k] - ref[k]));
+      err.push_back(d);
+      if (norm_error > 1e-12)
+	ok = false;
+    }
+    check("barrier, dt = 0.2, 0.1, 0.05", err, 3.5);
+  }
+
+  // time per step on n x n points
+  {
+    adv::matrix_type u0(n, adv::vector_type(n));
+    cn::matrix_type c0(n + 2, cn::vector_type(n + 2));
+    for (int i = 0; i < n; i++)
+      for (int j = 0; j < n; j++)
+	c0[i + 1][j + 1] = u0[i][j] = sin(2 * pi * i / n) * sin(2 * pi * j / n);
+    cout << endl << "time per step, " << n << " x " << n << ", " << n_threads << " thread(s)" << endl;
+    for (int scheme = 0; scheme < 3; scheme++) {
+      adv a(u0, 1.0 / n, 1.0 / n, 0.4 / n, adv::BURGERS, scheme, n_threads);
+      cout << setw(26) << left << schemes[scheme] << right << setw(12) << time_steps(a, 20) << " s" << endl;
+    }
+    cn d(c0, 1.0 / (n + 1), 1e-3, 1.0, cn::DIRICHLET, n_threads);
+    cout << setw(26) << left << "ADI" << right << setw(12) << time_steps(d, 20) << " s" << endl;
+    split_operator<double> s(split_operator<double>::matrix_type(n, vector<double>(n, 0.0)),
+			     1.0 / n, 1.0 / n, 1e-3, 1.0, n_threads);
+    cout << setw(26) << left << "split operator" << right << setw(12) << time_steps(s, 10) << " s" << endl;
+  }
+
+  if (!ok) {
+    cout << "some checks failed" << endl;
+    return EXIT_FAILURE;
+  }
+}
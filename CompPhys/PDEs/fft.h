@@ -0,0 +1,188 @@
+// Complex FFT of any length and the sine transform built on it
+#ifndef fft_h
+#define fft_h
+
+#include <cmath>
+#include <algorithm>
+#include <complex>
+#include <memory>
+#include <vector>
+
+
+// Plan for complex transforms of length n,
+//
+//   X[k] = sum_j x[j] exp( -2 pi i sign j k / n ),   sign = +1 or -1
+//
+// unnormalized. Powers of two use an iterative radix-2 transform with
+// precomputed twiddles; other lengths go through Bluestein's chirp-z
+// algorithm on a power of two, so every length costs O(n log n). A plan
+// is read-only after construction and can be shared between threads;
+// each caller passes its own work buffer of work_size() elements.
+template< typename T >
+class fft_plan {
+public :
+
+  typedef std::complex<T> complex_type;
+
+  fft_plan( int n ) : n_(n), m_(1)
+  {
+    while ( m_ < n_ )
+      m_ *= 2;
+    const T pi = 4 * std::atan( T(1) );
+
+    if ( m_ == n_ ) {
+      // twiddles of the stage with butterflies of length len stored
+      // contiguously from index len / 2 - 1
+      twiddle_.resize( std::max( n_ - 1, 1 ) );
+      for (int len = 2; len <= n_; len *= 2)
+	for (int k = 0; k < len / 2; k++)
+	  twiddle_[len / 2 - 1 + k] = std::polar( T(1), -2 * pi * k / len );
+      bitrev_.resize( n_ );
+      int bits = 0;
+      while ( (1 << bits) < n_ )
+	++bits;
+      for (int k = 0; k < n_; k++) {
+	int r = 0;
+	for (int b = 0; b < bits; b++)
+	  r |= ( (k >> b) & 1 ) << (bits - 1 - b);
+	bitrev_[k] = r;
+      }
+      return;
+    }
+
+    // Bluestein: j k = (j^2 + k^2 - (k - j)^2) / 2 turns the transform
+    // into a convolution with the chirp exp(i pi k^2 / n)
+    m_ = 1;
+    while ( m_ < 2 * n_ - 1 )
+      m_ *= 2;
+    inner_.reset( new fft_plan( m_ ) );
+    chirp_.resize( n_ );
+    for (int k = 0; k < n_; k++) {
+      long long k2 = static_cast<long long>(k) * k % (2 * n_);   // keep the phase small
+      chirp_[k] = std::polar( T(1), -pi * k2 / n_ );
+    }
+    chirp_hat_.assign( m_, complex_type(0) );
+    chirp_hat_[0] = std::conj( chirp_[0] );
+    for (int k = 1; k < n_; k++)
+      chirp_hat_[k] = chirp_hat_[m_ - k] = std::conj( chirp_[k] );
+    inner_->transform( &chirp_hat_[0], 1, 0 );
+  }
+
+  int size() const { return n_; }
+  int work_size() const { return inner_ ? m_ : 0; }
+
+  // in-place transform of x[0 .. n-1]
+  void transform( complex_type * x, int sign, complex_type * work ) const
+  {
+    if ( sign < 0 ) {
+      for (int k = 0; k < n_; k++)
+	x[k] = std::conj( x[k] );
+      transform( x, 1, work );
+      for (int k = 0; k < n_; k++)
+	x[k] = std::conj( x[k] );
+      return;
+    }
+    if ( inner_ )
+      bluestein( x, work );
+    else
+      radix2( x );
+  }
+
+protected :
+
+  void radix2( complex_type * x ) const
+  {
+    for (int k = 0; k < n_; k++)
+      if ( k < bitrev_[k] )
+	std::swap( x[k], x[bitrev_[k]] );
+    // the products are written out, since std::complex multiplication
+    // checks for infinities and NaNs and is much slower
+    for (int len = 2; len <= n_; len *= 2) {
+      int half = len / 2;
+      complex_type const * w = &twiddle_[half - 1];
+      for (int s = 0; s < n_; s += len) {
+	complex_type * x0 = x + s;
+	complex_type * x1 = x + s + half;
+	for (int k = 0; k < half; k++) {
+	  T wr = w[k].real(), wi = w[k].imag();
+	  T yr = x1[k].real(), yi = x1[k].imag();
+	  complex_type t( wr * yr - wi * yi, wr * yi + wi * yr );
+	  x1[k] = x0[k] - t;
+	  x0[k] += t;
+	}
+      }
+    }
+  }
+
+  void bluestein( complex_type * x, complex_type * a ) const
+  {
+    for (int k = 0; k < n_; k++)
+      a[k] = x[k] * chirp_[k];
+    for (int k = n_; k < m_; k++)
+      a[k] = 0;
+    inner_->transform( a, 1, 0 );
+    for (int k = 0; k < m_; k++)
+      a[k] *= chirp_hat_[k];
+    inner_->transform( a, -1, 0 );
+    T norm = T(1) / m_;
+    for (int k = 0; k < n_; k++)
+      x[k] = chirp_[k] * a[k] * norm;
+  }
+
+  int n_;                                   // transform length
+  int m_;                                   // power of two used internally
+  std::vector<complex_type> twiddle_;       // exp(-2 pi i k / len) per stage, radix 2
+  std::vector<int> bitrev_;                 // bit reversed indices, radix 2
+  std::unique_ptr<fft_plan> inner_;         // length m plan, Bluestein
+  std::vector<complex_type> chirp_;         // exp(-i pi k^2 / n)
+  std::vector<complex_type> chirp_hat_;     // transform of the conjugate chirp
+};
+
+
+// Type-I discrete sine transform of length N,
+//
+//   S[m] = sum_{k=1..N} x[k] sin( pi k m / (N + 1) ),   m = 1 .. N
+//
+// (stored from index 0), through an FFT of the odd extension of length
+// 2 (N + 1). Applying it twice multiplies by (N + 1) / 2. Two real
+// arrays are transformed at once as the real and imaginary parts of one
+// complex FFT.
+template< typename T >
+class dst1_plan {
+public :
+
+  typedef std::complex<T> complex_type;
+
+  dst1_plan( int N ) : N_(N), fft_( 2 * (N + 1) ) {}
+
+  int size() const { return N_; }
+  // complex elements the caller provides for transform()
+  int work_size() const { return 2 * (N_ + 1) + fft_.work_size(); }
+
+  // in place on a[0 .. N-1] and, if not null, b[0 .. N-1]
+  void transform( T * a, T * b, complex_type * work ) const
+  {
+    int M = 2 * (N_ + 1);
+    complex_type * y = work;
+    y[0] = y[N_ + 1] = 0;
+    for (int k = 1; k <= N_; k++) {
+      y[k] = complex_type( a[k - 1], b ? b[k - 1] : 0 );
+      y[M - k] = -y[k];
+    }
+    fft_.transform( y, 1, work + M );
+    // Y = -2 i S_a + 2 S_b
+    for (int m = 1; m <= N_; m++) {
+      a[m - 1] = -0.5 * y[m].imag();
+      if ( b )
+	b[m - 1] = 0.5 * y[m].real();
+    }
+  }
+
+protected :
+
+  int N_;
+  fft_plan<T> fft_;
+};
+
+
+#endif
@@ -0,0 +1,411 @@
+// Binary field files for the PDE solvers: a small header and raw values
+#ifndef field_io_h
+#define field_io_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mg_grid.h"
+
+
+// File layout, all little-endian:
+//
+//   bytes   0 ..   7   "PDEFIELD"
+//           8 ..  11   version (1)
+//          12 ..  15   dtype: FIELD_FLOAT32 or FIELD_FLOAT64
+//          16 ..  19   ndim, 1 to 3
+//          20 ..  23   header size (128), the offset of the values
+//          24 ..  47   dims[3], uint64, 1 beyond ndim
+//          48 ..  71   spacing[3], double
+//          72 ..  95   origin[3], double: position of the first point
+//          96 .. 103   time, double
+//         104 .. 127   zero
+//
+// followed by dims[0] x .. x dims[ndim-1] values in C order (the last
+// index runs fastest), so numpy reads a file with
+//
+//   np.fromfile(name, dtype='<f8', offset=128).reshape(dims[:ndim])
+//
+// (read_field.py does that from the header). Writes go through a shared
+// mmap of the whole file, or through 4 MB chunks if mapping fails or
+// FIELD_BUFFERED is asked for.
+
+enum { FIELD_FLOAT32 = 0, FIELD_FLOAT64 };
+enum { FIELD_MMAP = 0, FIELD_BUFFERED };
+
+struct field_header {
+  int dtype;              // FIELD_FLOAT32 or FIELD_FLOAT64
+  int ndim;               // number of dimensions
+  std::uint64_t dims[3];  // points along each dimension
+  double spacing[3];      // grid spacing along each dimension
+  double origin[3];       // coordinates of the first point
+  double time;            // e.g. of a time dependent solution
+
+  static const int size = 128;
+
+  field_header( int idtype = FIELD_FLOAT64 ) : dtype(idtype), ndim(0), time(0)
+  {
+    for (int d = 0; d < 3; d++) {
+      dims[d] = 1;
+      spacing[d] = 1;
+      origin[d] = 0;
+    }
+  }
+
+  std::size_t value_size() const { return dtype == FIELD_FLOAT32 ? 4 : 8; }
+  std::uint64_t n_values() const { return dims[0] * dims[1] * dims[2]; }
+  std::uint64_t file_size() const { return size + n_values() * value_size(); }
+
+  void encode( unsigned char * b ) const
+  {
+    std::memset( b, 0, size );
+    std::memcpy( b, "PDEFIELD", 8 );
+    put( b + 8, 1, 4 );
+    put( b + 12, dtype, 4 );
+    put( b + 16, ndim, 4 );
+    put( b + 20, size, 4 );
+    for (int d = 0; d < 3; d++) {
+      put( b + 24 + 8 * d, dims[d], 8 );
+      put( b + 48 + 8 * d, bits( spacing[d] ), 8 );
+      put( b + 72 + 8 * d, bits( origin[d] ), 8 );
+    }
+    put( b + 96, bits( time ), 8 );
+  }
+
+  bool decode( unsigned char const * b )
+  {
+    if ( std::memcmp( b, "PDEFIELD", 8 ) != 0 || get( b + 8, 4 ) != 1 || get( b + 20, 4 ) != size )
+      return false;
+    dtype = get( b + 12, 4 );
+    ndim = get( b + 16, 4 );
+    for (int d = 0; d < 3; d++) {
+      dims[d] = get( b + 24 + 8 * d, 8 );
+      spacing[d] = value( get( b + 48 + 8 * d, 8 ) );
+      origin[d] = value( get( b + 72 + 8 * d, 8 ) );
+    }
+    time = value( get( b + 96, 8 ) );
+    return ( dtype == FIELD_FLOAT32 || dtype == FIELD_FLOAT64 ) && ndim >= 1 && ndim <= 3;
+  }
+
+  // byte order helpers, independent of the host
+  static void put( unsigned char * b, std::uint64_t v, int n )
+  {
+    for (int k = 0; k < n; k++)
+      b[k] = static_cast<unsigned char>( v >> (8 * k) );
+  }
+  static std::uint64_t get( unsigned char const * b, int n )
+  {
+    std::uint64_t v = 0;
+    for (int k = 0; k < n; k++)
+      v |= static_cast<std::uint64_t>( b[k] ) << (8 * k);
+    return v;
+  }
+  static std::uint64_t bits( double x ) { std::uint64_t v; std::memcpy( &v, &x, 8 ); return v; }
+  static double value( std::uint64_t v ) { double x; std::memcpy( &x, &v, 8 ); return x; }
+};
+
+
+namespace field_io_detail {
+
+  inline bool little_endian()
+  {
+    const std::uint16_t one = 1;
+    unsigned char c;
+    std::memcpy( &c, &one, 1 );
+    return c == 1;
+  }
+
+  // n values of row as dtype at out, little-endian
+  template< typename T >
+  void store( unsigned char * out, T const * row, std::size_t n, int dtype )
+  {
+    if ( dtype == FIELD_FLOAT64 ) {
+      if ( sizeof(T) == 8 && little_endian() ) {
+	std::memcpy( out, row, 8 * n );
+	return;
+      }
+      for (std::size_t k = 0; k < n; k++)
+	field_header::put( out + 8 * k, field_header::bits( static_cast<double>( row[k] ) ), 8 );
+      return;
+    }
+    if ( sizeof(T) == 4 && little_endian() ) {
+      std::memcpy( out, row, 4 * n );
+      return;
+    }
+    for (std::size_t k = 0; k < n; k++) {
+      float x = static_cast<float>( row[k] );
+      std::uint32_t v;
+      std::memcpy( &v, &x, 4 );
+      if ( little_endian() )
+	std::memcpy( out + 4 * k, &v, 4 );
+      else
+	field_header::put( out + 4 * k, v, 4 );
+    }
+  }
+
+  // n values at in, stored as dtype, into row
+  template< typename T >
+  void load( T * row, unsigned char const * in, std::size_t n, int dtype )
+  {
+    if ( dtype == FIELD_FLOAT64 ) {
+      if ( sizeof(T) == 8 && little_endian() ) {
+	std::memcpy( row, in, 8 * n );
+	return;
+      }
+      for (std::size_t k = 0; k < n; k++)
+	row[k] = static_cast<T>( field_header::value( field_header::get( in + 8 * k, 8 ) ) );
+      return;
+    }
+    for (std::size_t k = 0; k < n; k++) {
+      std::uint32_t v = static_cast<std::uint32_t>( field_header::get( in + 4 * k, 4 ) );
+      float x;
+      std::memcpy( &x, &v, 4 );
+      row[k] = static_cast<T>( x );
+    }
+  }
+
+  // The values as n_rows rows of dims[ndim-1] values, row(r) pointing to
+  // row r in C order of the outer indices.
+  template< typename T >
+  bool write_rows( std::string const & file, field_header const & h,
+		   std::function<T const * (std::uint64_t)> const & row, int mode )
+  {
+    std::uint64_t len = h.dims[h.ndim - 1];
+    std::uint64_t n_rows = len > 0 ? h.n_values() / len : 0;
+    std::size_t row_bytes = len * h.value_size();
+    unsigned char head[field_header::size];
+    h.encode( head );
+
+    if ( mode == FIELD_MMAP ) {
+      int fd = ::open( file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+      if ( fd < 0 ) {
+	std::cerr << " write_field: cannot open " << file << std::endl;
+	return false;
+      }
+      void * map = MAP_FAILED;
+      if ( ::ftruncate( fd, h.file_size() ) == 0 )
+	map = ::mmap( 0, h.file_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      if ( map != MAP_FAILED ) {
+	::madvise( map, h.file_size(), MADV_SEQUENTIAL );
+	unsigned char * out = static_cast<unsigned char *>( map );
+	std::memcpy( out, head, field_header::size );
+	out += field_header::size;
+	for (std::uint64_t r = 0; r < n_rows; r++, out += row_bytes)
+	  store( out, row( r ), len, h.dtype );
+	bool ok = ::munmap( map, h.file_size() ) == 0;
+	ok = ::close( fd ) == 0 && ok;
+	if ( !ok )
+	  std::cerr << " write_field: error writing " << file << std::endl;
+	return ok;
+      }
+      ::close( fd );
+      // fall through to buffered writes, e.g. on file systems without mmap
+    }
+
+    std::FILE * f = std::fopen( file.c_str(), "wb" );
+    if ( !f ) {
+      std::cerr << " write_field: cannot open " << file << std::endl;
+      return false;
+    }
+    const std::size_t chunk = std::size_t(1) << 22;
+    std::vector<unsigned char> buffer( std::max( chunk, row_bytes ) );
+    std::memcpy( &buffer[0], head, field_header::size );
+    std::size_t used = field_header::size;
+    bool ok = true;
+    for (std::uint64_t r = 0; r < n_rows && ok; r++) {
+      if ( used + row_bytes > buffer.size() ) {
+	ok = std::fwrite( &buffer[0], 1, used, f ) == used;
+	used = 0;
+      }
+      store( &buffer[used], row( r ), len, h.dtype );
+      used += row_bytes;
+    }
+    ok = ok && std::fwrite( &buffer[0], 1, used, f ) == used;
+    ok = std::fclose( f ) == 0 && ok;
+    if ( !ok )
+      std::cerr << " write_field: error writing " << file << std::endl;
+    return ok;
+  }
+
+  // f x f (x f) block averages of the rows; h describes the full field and
+  // is turned into the header of the preview
+  template< typename T >
+  std::vector<T> preview_rows( field_header & h, std::function<T const * (std::uint64_t)> const & row,
+			       int f )
+  {
+    // outer dimensions n0 x n1 (1 if absent) of rows of length len
+    int nd = h.ndim;
+    std::uint64_t n0 = nd == 3 ? h.dims[0] : 1, n1 = nd >= 2 ? h.dims[nd - 2] : 1;
+    std::uint64_t len = h.dims[nd - 1];
+    std::uint64_t f0 = nd == 3 ? f : 1, f1 = nd >= 2 ? f : 1;
+    std::uint64_t m0 = n0 / f0, m1 = n1 / f1, mlen = len / f;
+    std::vector<T> out( m0 * m1 * mlen, T(0) );
+    T norm = T(1) / ( T(f0) * f1 * f );
+    for (std::uint64_t a = 0; a < m0; a++)
+      for (std::uint64_t b = 0; b < m1; b++) {
+	T * o = &out[ (a * m1 + b) * mlen ];
+	for (std::uint64_t i = a * f0; i < (a + 1) * f0; i++)
+	  for (std::uint64_t j = b * f1; j < (b + 1) * f1; j++) {
+	    T const * in = row( i * n1 + j );
+	    for (std::uint64_t k = 0; k < mlen; k++)
+	      for (int s = 0; s < f; s++)
+		o[k] += in[k * f + s];
+	  }
+	for (std::uint64_t k = 0; k < mlen; k++)
+	  o[k] *= norm;
+      }
+    for (int d = 0; d < nd; d++) {
+      h.origin[d] += 0.5 * (f - 1) * h.spacing[d];
+      h.spacing[d] *= f;
+      h.dims[d] /= f;
+    }
+    return out;
+  }
+
+  template< typename T >
+  bool write( std::string const & file, field_header const & h,
+	      std::function<T const * (std::uint64_t)> const & row, int mode, int preview )
+  {
+    if ( !write_rows( file, h, row, mode ) )
+      return false;
+    // no larger than the smallest dimension, so that every block is whole
+    for (int d = 0; d < h.ndim; d++)
+      if ( h.dims[d] < std::uint64_t(preview) )
+	preview = static_cast<int>( h.dims[d] );
+    if ( preview <= 1 )
+      return true;
+    field_header hp = h;
+    std::vector<T> small = preview_rows( hp, row, preview );
+    std::uint64_t len = hp.dims[hp.ndim - 1];
+    std::string name = file;
+    std::size_t dot = name.rfind( '.' );
+    name.insert( dot == std::string::npos || name.find( '/', dot ) != std::string::npos ?
+		 name.size() : dot, ".preview" );
+    return write_rows<T>( name, hp, [&small, len](std::uint64_t r) { return &small[r * len]; },
+			  FIELD_BUFFERED );
+  }
+}
+
+
+// Write the block of nx x ny points of g starting at (i0, j0). h gives
+// dtype, spacing, origin and time; the dims are set here. preview > 1
+// also writes averages over preview x preview blocks to the same name
+// with ".preview" before the extension (poisson_mg.field ->
+// poisson_mg.preview.field); a factor larger than the smallest dimension
+// is reduced to it.
+template< typename T >
+bool write_field( std::string const & file, grid2d<T> const & g, int i0, int j0, int nx, int ny,
+		  field_header h, int mode = FIELD_MMAP, int preview = 0 )
+{
+  h.ndim = 2;
+  h.dims[0] = nx;
+  h.dims[1] = ny;
+  h.dims[2] = 1;
+  return field_io_detail::write<T>( file, h, [&g, i0, j0](std::uint64_t r) {
+      return g.row( i0 + static_cast<int>( r ) ) + j0; }, mode, preview );
+}
+
+// the same for a block of nx x ny x nz points of a 3D grid
+template< typename T >
+bool write_field( std::string const & file, grid3d<T> const & g, int i0, int j0, int k0,
+		  int nx, int ny, int nz, field_header h, int mode = FIELD_MMAP, int preview = 0 )
+{
+  h.ndim = 3;
+  h.dims[0] = nx;
+  h.dims[1] = ny;
+  h.dims[2] = nz;
+  return field_io_detail::write<T>( file, h, [&g, i0, j0, k0, ny](std::uint64_t r) {
+      return g.row( i0 + static_cast<int>( r / ny ), j0 + static_cast<int>( r % ny ) ) + k0; },
+    mode, preview );
+}
+
+// and for n values in a row
+template< typename T >
+bool write_field( std::string const & file, T const * values, int n, field_header h,
+		  int mode = FIELD_MMAP, int preview = 0 )
+{
+  h.ndim = 1;
+  h.dims[0] = n;
+  h.dims[1] = h.dims[2] = 1;
+  return field_io_detail::write<T>( file, h, [values](std::uint64_t) { return values; },
+				    mode, preview );
+}
+
+
+// Read the header of a field file
+inline bool read_field_header( std::string const & file, field_header & h )
+{
+  unsigned char head[field_header::size];
+  std::FILE * f = std::fopen( file.c_str(), "rb" );
+  bool ok = f && std::fread( head, 1, field_header::size, f ) == field_header::size && h.decode( head );
+  if ( f )
+    std::fclose( f );
+  if ( !ok )
+    std::cerr << " read_field: " << file << " is not a field file" << std::endl;
+  return ok;
+}
+
+// Read header and values, converted to T, in C order; the file is mapped
+// read-only, or read in 4 MB chunks with FIELD_BUFFERED
+template< typename T >
+bool read_field( std::string const & file, field_header & h, std::vector<T> & values,
+		 int mode = FIELD_MMAP )
+{
+  if ( !read_field_header( file, h ) )
+    return false;
+  values.resize( h.n_values() );
+  std::size_t vs = h.value_size();
+
+  if ( mode == FIELD_MMAP ) {
+    int fd = ::open( file.c_str(), O_RDONLY );
+    struct stat st;
+    if ( fd >= 0 && ::fstat( fd, &st ) == 0 && static_cast<std::uint64_t>( st.st_size ) >= h.file_size() ) {
+      void * map = ::mmap( 0, h.file_size(), PROT_READ, MAP_PRIVATE, fd, 0 );
+      if ( map != MAP_FAILED ) {
+	::madvise( map, h.file_size(), MADV_SEQUENTIAL );
+	field_io_detail::load( values.empty() ? 0 : &values[0],
+			       static_cast<unsigned char const *>( map ) + field_header::size,
+			       values.size(), h.dtype );
+	::munmap( map, h.file_size() );
+	::close( fd );
+	return true;
+      }
+    }
+    if ( fd >= 0 )
+      ::close( fd );
+  }
+
+  std::FILE * f = std::fopen( file.c_str(), "rb" );
+  if ( !f || std::fseek( f, field_header::size, SEEK_SET ) != 0 ) {
+    if ( f )
+      std::fclose( f );
+    std::cerr << " read_field: cannot read " << file << std::endl;
+    return false;
+  }
+  const std::size_t chunk = ( std::size_t(1) << 22 ) / vs;
+  std::vector<unsigned char> buffer( chunk * vs );
+  bool ok = true;
+  for (std::size_t k = 0; k < values.size() && ok; k += chunk) {
+    std::size_t n = std::min( chunk, values.size() - k );
+    ok = std::fread( &buffer[0], vs, n, f ) == n;
+    if ( ok )
+      field_io_detail::load( &values[k], &buffer[0], n, h.dtype );
+  }
+  std::fclose( f );
+  if ( !ok )
+    std::cerr << " read_field: " << file << " is truncated" << std::endl;
+  return ok;
+}
+
+#endif
@@ -0,0 +1,136 @@
+// Flat, aligned and padded grid storage for the PDE solvers
+#ifndef mg_grid_h
+#define mg_grid_h
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "thread_team.h"
+
+
+// allocator returning memory aligned to Align bytes, so that every grid
+// row starts on a cache line / SIMD register boundary
+template< typename T, std::size_t Align = 64 >
+struct aligned_allocator {
+  typedef T value_type;
+
+  template< typename U > struct rebind { typedef aligned_allocator<U, Align> other; };
+
+  aligned_allocator() {}
+  template< typename U > aligned_allocator( aligned_allocator<U, Align> const & ) {}
+
+  T * allocate( std::size_t n ) {
+    void * p = 0;
+    if ( posix_memalign( &p, Align, n * sizeof(T) ) != 0 )
+      throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+  void deallocate( T * p, std::size_t ) { std::free(p); }
+
+  template< typename U > bool operator==( aligned_allocator<U, Align> const & ) const { return true; }
+  template< typename U > bool operator!=( aligned_allocator<U, Align> const & ) const { return false; }
+};
+
+
+// nx x ny grid stored row by row; each row is padded to a multiple of
+// 64 bytes so rows stay aligned
+template< typename T >
+class grid2d {
+public :
+
+  typedef T value_type;
+  typedef std::vector< T, aligned_allocator<T> > storage_type;
+
+  grid2d() : nx_(0), ny_(0), stride_(0) {}
+  grid2d( int nx, int ny ) { resize(nx, ny); }
+
+  void resize( int nx, int ny ) {
+    const int per_line = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+    nx_ = nx;
+    ny_ = ny;
+    stride_ = ( (ny + per_line - 1) / per_line ) * per_line;
+    data_.assign( static_cast<std::size_t>(nx_) * stride_, T(0) );
+  }
+
+  void fill( T v ) { std::fill( data_.begin(), data_.end(), v ); }
+
+  T       & operator()( int i, int j )       { return data_[ static_cast<std::size_t>(i) * stride_ + j ]; }
+  T const & operator()( int i, int j ) const { return data_[ static_cast<std::size_t>(i) * stride_ + j ]; }
+
+  T       * row( int i )       { return &data_[ static_cast<std::size_t>(i) * stride_ ]; }
+  T const * row( int i ) const { return &data_[ static_cast<std::size_t>(i) * stride_ ]; }
+
+  int nx() const { return nx_; }
+  int ny() const { return ny_; }
+  int stride() const { return stride_; }
+
+protected :
+
+  int nx_, ny_;            // number of rows and columns
+  int stride_;             // distance between rows in elements
+  storage_type data_;      // row-major storage
+};
+
+
+// nx x ny x nz grid stored as nx planes of ny rows; each row along z is
+// padded like in grid2d, so row(i, j) is aligned
+template< typename T >
+class grid3d {
+public :
+
+  typedef T value_type;
+  typedef std::vector< T, aligned_allocator<T> > storage_type;
+
+  grid3d() : nx_(0), ny_(0), nz_(0), stride_(0) {}
+  grid3d( int nx, int ny, int nz ) { resize(nx, ny, nz); }
+
+  void resize( int nx, int ny, int nz ) {
+    const int per_line = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+    nx_ = nx;
+    ny_ = ny;
+    nz_ = nz;
+    stride_ = ( (nz + per_line - 1) / per_line ) * per_line;
+    data_.assign( static_cast<std::size_t>(nx_) * ny_ * stride_, T(0) );
+  }
+
+  void fill( T v ) { std::fill( data_.begin(), data_.end(), v ); }
+
+  T       & operator()( int i, int j, int k )       { return row(i, j)[k]; }
+  T const & operator()( int i, int j, int k ) const { return row(i, j)[k]; }
+
+  T       * row( int i, int j )       { return &data_[ ( static_cast<std::size_t>(i) * ny_ + j ) * stride_ ]; }
+  T const * row( int i, int j ) const { return &data_[ ( static_cast<std::size_t>(i) * ny_ + j ) * stride_ ]; }
+
+  int nx() const { return nx_; }
+  int ny() const { return ny_; }
+  int nz() const { return nz_; }
+  int stride() const { return stride_; }
+
+protected :
+
+  int nx_, ny_, nz_;       // number of planes, rows and columns
+  int stride_;             // distance between rows in elements
+  storage_type data_;      // plane-major, then row-major storage
+};
+
+
+// b(j, i) = a(i, j) for the n x m block at the origin, in tiles that stay
+// in cache; tile rows are split across the team
+template< typename U >
+void transpose( thread_team & team, grid2d<U> const & a, grid2d<U> & b, int n, int m )
+{
+  const int tile = 32;
+  team.parallel_for( 0, (n + tile - 1) / tile, [&a, &b, n, m, tile](int t0, int t1) {
+      for (int i0 = t0 * tile; i0 < std::min( n, t1 * tile ); i0 += tile)
+	for (int j0 = 0; j0 < m; j0 += tile)
+	  for (int i = i0; i < std::min( n, i0 + tile ); i++)
+	    for (int j = j0; j < std::min( m, j0 + tile ); j++)
+	      b(j, i) = a(i, j);
+    }, 1 );
+}
+
+
+#endif
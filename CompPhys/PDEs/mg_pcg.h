@@ -0,0 +1,210 @@
+// Conjugate gradients preconditioned with one multigrid V-cycle
+#ifndef mg_pcg_h
+#define mg_pcg_h
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "thread_team.h"
+
+
+// Works with any 2D multigrid solver that provides
+//
+//   grid_type, get_level(0), get_team()
+//   compute_residual(0)            r = f - A u on level 0
+//   apply_operator(x, y)           y = A x, matrix free, x = 0 on the boundary
+//   precondition(r, z)             z = one V-cycle for A z = r from z = 0
+//
+// where A is the symmetric positive (semi-)definite operator of the
+// solver. The level 0 solution is updated in place. The V-cycle is not
+// exactly symmetric (red-black ordering, non-adjoint transfers), so the
+// Polak-Ribiere form of beta is used, which tolerates that.
+template< typename Solver >
+class mg_pcg {
+public :
+
+  typedef typename Solver::grid_type grid_type;
+  typedef typename grid_type::value_type T;
+
+  mg_pcg( Solver & solver ) :
+    solver_(solver), team_(solver.get_team())
+  {
+    grid_type const & u = solver_.get_level(0).u;
+    nx_ = u.nx() - 2;
+    ny_ = u.ny() - 2;
+    r_.resize( u.nx(), u.ny() );
+    z_.resize( u.nx(), u.ny() );
+    p_.resize( u.nx(), u.ny() );
+    q_.resize( u.nx(), u.ny() );
+  }
+
+  // Iterate until the RMS residual drops below accuracy times its initial
+  // value or max_iter iterations have been done. residuals gets the RMS
+  // residual before the first and after every iteration, factors the
+  // reduction per iteration. Returns the number of iterations.
+  unsigned int solve( T accuracy, unsigned int max_iter, std::vector<T> & residuals,
+		      std::vector<T> & factors, bool verbose = false )
+  {
+    grid_type & x = solver_.get_level(0).u;
+    T n = T(nx_) * ny_;
+
+    solver_.compute_residual( 0 );
+    copy( solver_.get_level(0).r, r_ );
+    T rr = dot( r_, r_ );
+    T r0 = std::sqrt( rr / n );
+    residuals.assign( 1, r0 );
+    factors.clear();
+    if ( r0 == 0 )
+      return 0;
+
+    solver_.precondition( r_, z_ );
+    copy( z_, p_ );
+    T rz = dot( r_, z_ );
+
+    unsigned int k = 0;
+    while ( k < max_iter ) {
+      solver_.apply_operator( p_, q_ );
+      T alpha = rz / dot( p_, q_ );
+      rr = update( alpha, x, r_ );
+      ++k;
+
+      residuals.push_back( std::sqrt( rr / n ) );
+      factors.push_back( residuals.back() / residuals[k - 1] );
+      if ( verbose )
+	std::cout << "iteration " << k << "  residual " << residuals.back()
+		  << "  factor " << factors.back() << std::endl;
+      if ( residuals.back() <= accuracy * r0 )
+	break;
+
+      solver_.precondition( r_, z_ );
+      T qz;
+      T rz_new = dot2( r_, q_, z_, qz );
+      T beta = -alpha * qz / rz;     // (r_new - r_old) . z / rz, r_new - r_old = -alpha q
+      rz = rz_new;
+      xpay( z_, beta, p_ );
+    }
+    return k;
+  }
+
+protected :
+
+  // sum of a b over the interior; every row is summed on its own, so the
+  // result does not depend on the number of threads
+  T dot( grid_type const & a, grid_type const & b )
+  {
+    std::vector<T> row_sum( nx_ + 1, 0 );
+    int ny = ny_;
+    team_.parallel_for( 1, nx_ + 1, [&a, &b, &row_sum, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++)
+	  row_sum[i] = dot_row( a.row(i), b.row(i), ny );
+      }, min_rows_per_thread );
+    T sum = 0;
+    for (int i = 1; i <= nx_; i++)
+      sum += row_sum[i];
+    return sum;
+  }
+
+  // r . z and q . z in one pass over z
+  T dot2( grid_type const & r, grid_type const & q, grid_type const & z, T & qz )
+  {
+    std::vector<T> row_rz( nx_ + 1, 0 ), row_qz( nx_ + 1, 0 );
+    int ny = ny_;
+    team_.parallel_for( 1, nx_ + 1, [&, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  row_rz[i] = dot_row( r.row(i), z.row(i), ny );
+	  row_qz[i] = dot_row( q.row(i), z.row(i), ny );
+	}
+      }, min_rows_per_thread );
+    T rz = 0;
+    qz = 0;
+    for (int i = 1; i <= nx_; i++) {
+      rz += row_rz[i];
+      qz += row_qz[i];
+    }
+    return rz;
+  }
+
+  // four independent partial sums, so the loop is not bound by the
+  // latency of one chain of additions and can use SIMD registers
+  static T dot_row( T const * __restrict a, T const * __restrict b, int ny )
+  {
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int j = 1;
+    for ( ; j + 3 <= ny; j += 4) {
+      s0 += a[j] * b[j];
+      s1 += a[j + 1] * b[j + 1];
+      s2 += a[j + 2] * b[j + 2];
+      s3 += a[j + 3] * b[j + 3];
+    }
+    for ( ; j <= ny; j++)
+      s0 += a[j] * b[j];
+    return (s0 + s1) + (s2 + s3);
+  }
+
+  // x += alpha p and r -= alpha q in one pass; returns r . r
+  T update( T alpha, grid_type & x, grid_type & r )
+  {
+    std::vector<T> row_sum( nx_ + 1, 0 );
+    grid_type const & p = p_;
+    grid_type const & q = q_;
+    int ny = ny_;
+    team_.parallel_for( 1, nx_ + 1, [&, alpha, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T * __restrict xi = x.row(i);
+	  T * __restrict ri = r.row(i);
+	  T const * __restrict pj = p.row(i);
+	  T const * __restrict qi = q.row(i);
+	  for (int j = 1; j <= ny; j++) {
+	    xi[j] += alpha * pj[j];
+	    ri[j] -= alpha * qi[j];
+	  }
+	  row_sum[i] = dot_row( ri, ri, ny );
+	}
+      }, min_rows_per_thread );
+    T sum = 0;
+    for (int i = 1; i <= nx_; i++)
+      sum += row_sum[i];
+    return sum;
+  }
+
+  // p = z + beta p
+  void xpay( grid_type const & z, T beta, grid_type & p )
+  {
+    int ny = ny_;
+    team_.parallel_for( 1, nx_ + 1, [&z, &p, beta, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * __restrict zi = z.row(i);
+	  T * __restrict pj = p.row(i);
+	  for (int j = 1; j <= ny; j++)
+	    pj[j] = zi[j] + beta * pj[j];
+	}
+      }, min_rows_per_thread );
+  }
+
+  // copy the interior of a into b
+  void copy( grid_type const & a, grid_type & b )
+  {
+    int ny = ny_;
+    team_.parallel_for( 1, nx_ + 1, [&a, &b, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * __restrict ai = a.row(i);
+	  T * __restrict bi = b.row(i);
+	  for (int j = 1; j <= ny; j++)
+	    bi[j] = ai[j];
+	}
+      }, min_rows_per_thread );
+  }
+
+  Solver & solver_;
+  thread_team & team_;      // the solver's threads
+  int nx_, ny_;             // interior size of level 0
+  grid_type r_;             // residual
+  grid_type z_;             // preconditioned residual
+  grid_type p_;             // search direction
+  grid_type q_;             // A p
+  static const int min_rows_per_thread = 32;
+};
+
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef poisson_fft_h
+#define poisson_fft_h
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "fft.h"
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+
+// Direct solver for the 5-point discretization of -laplacian(psi) = rho
+// on a box of nx x ny points with spacing h, in O(N log N).
+//
+// DIRICHLET uses the grid of poisson_mg: interior points 1 .. nx and
+// 1 .. ny, psi = 0 on the boundary rows 0 and nx+1 (columns 0 and ny+1),
+// default h = 1 / (nx + 1). The sine transform diagonalizes the stencil,
+// so psi is the exact solution of the discrete equations poisson_mg
+// iterates on.
+//
+// PERIODIC treats points 1 .. nx, 1 .. ny as one period (the ghost rows
+// and columns get the periodic images). rho is made neutral by removing
+// its mean and psi has zero mean. Rows are transformed two at a time as
+// one complex FFT.
+//
+// Transforms run along rows; the second direction goes through a blocked
+// transpose. Rows are split across the thread team.
+template< typename T>
+class poisson_fft {
+public :
+
+  typedef std::vector< std::vector<T> > matrix_type;
+  typedef std::complex<T> complex_type;
+
+  enum { DIRICHLET = 0, PERIODIC };
+
+  // rho_in is (nx+2) x (ny+2) like in poisson_mg and may be smaller; ny = 0
+  // means ny = nx and h = 0 the unit box (1 / (nx + 1), or 1 / nx if periodic)
+  poisson_fft( matrix_type const & rho_in, int inx = 63, int iny = 0, int ibc = DIRICHLET,
+	       T ih = 0, int in_threads = 1 ) :
+    nx_(inx), ny_(iny > 0 ? iny : inx), bc_(ibc), team_(in_threads)
+  {
+    h_ = ih > 0 ? ih : 1. / static_cast<T>( bc_ == PERIODIC ? nx_ : nx_ + 1 );
+    psi_.resize( nx_+2, ny_+2 );
+    rho_.resize( nx_+2, ny_+2 );
+    for ( unsigned int i = 0; i < rho_in.size() && i < static_cast<unsigned int>(nx_+2); ++i )
+      for ( unsigned int j = 0; j < rho_in[i].size() && j < static_cast<unsigned int>(ny_+2); ++j )
+	rho_(i, j) = rho_in[i][j];
+  }
+
+  static void init_matrix( matrix_type & matrix, unsigned int N, unsigned int M) {
+    matrix.resize( N );
+    for ( auto i = matrix.begin(); i != matrix.end(); ++i ) {
+      i->resize(M);
+    }
+  }
+
+  void execute()
+  {
+    if ( bc_ == PERIODIC )
+      solve_periodic();
+    else
+      solve_dirichlet();
+  }
+
+  // copies of the grids as nested vectors, e.g. for numpy through SWIG
+  matrix_type get_psi() const { return to_matrix( psi_ ); }
+  matrix_type get_rho() const { return to_matrix( rho_ ); }
+
+  T get_psi    ( int i, int j) const { return psi_(i, j); }
+
+  // psi with the boundary / ghost layer as a binary field file, like in
+  // poisson_mg
+  bool write_psi( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
+  {
+    field_header h( dtype );
+    h.spacing[0] = h.spacing[1] = h_;
+    return write_field( file, psi_, 0, 0, nx_+2, ny_+2, h, FIELD_MMAP, preview );
+  }
+  T get_rho    ( int i, int j) const { return rho_(i, j); }
+  void set_rho    ( int i, int j, T f) { rho_(i, j) = f; }
+
+  T get_h () const { return h_;}
+  int get_nx () const { return nx_;}
+  int get_ny () const { return ny_;}
+  int get_n_threads() const { return team_.size(); }
+
+protected :
+
+  // DST along y, transpose, DST along x, divide by the eigenvalues, and
+  // the same way back
+  void solve_dirichlet()
+  {
+    int nx = nx_, ny = ny_;
+    grid2d<T> a( nx, ny ), b( ny, nx );
+    for (int i = 0; i < nx; i++)
+      for (int j = 0; j < ny; j++)
+	a(i, j) = rho_(i + 1, j + 1);
+
+    dst1_plan<T> dst_y( ny ), dst_x( nx );
+    dst_rows( dst_y, a, nx );
+    transpose( team_, a, b, nx, ny );
+    dst_rows( dst_x, b, ny );
+
+    // eigenvalues of the 5-point stencil and the normalization of the
+    // two inverse transforms, 2 / (n + 1) each
+    const T pi = 4 * std::atan( T(1) );
+    std::vector<T> lx( nx ), ly( ny );
+    for (int m = 0; m < nx; m++) {
+      T s = std::sin( pi * (m + 1) / (2 * (nx + 1)) );
+      lx[m] = 4 * s * s / (h_ * h_);
+    }
+    for (int n = 0; n < ny; n++) {
+      T s = std::sin( pi * (n + 1) / (2 * (ny + 1)) );
+      ly[n] = 4 * s * s / (h_ * h_);
+    }
+    T norm = T(4) / ( T(nx + 1) * (ny + 1) );
+    team_.parallel_for( 0, ny, [&b, &lx, &ly, norm, nx](int n0, int n1) {
+	for (int n = n0; n < n1; n++) {
+	  T * bn = b.row(n);
+	  for (int m = 0; m < nx; m++)
+	    bn[m] *= norm / (lx[m] + ly[n]);
+	}
+      }, min_rows_per_thread );
+
+    dst_rows( dst_x, b, ny );
+    transpose( team_, b, a, ny, nx );
+    dst_rows( dst_y, a, nx );
+
+    psi_.fill( 0 );
+    for (int i = 0; i < nx; i++)
+      for (int j = 0; j < ny; j++)
+	psi_(i + 1, j + 1) = a(i, j);
+  }
+
+  // real FFT along y (two rows per complex FFT, half spectrum kept),
+  // transpose, complex FFT along x, divide, and back
+  void solve_periodic()
+  {
+    int nx = nx_, ny = ny_, nk = ny / 2 + 1;
+
+    // neutralize
+    T mean = 0;
+    for (int i = 1; i <= nx; i++)
+      for (int j = 1; j <= ny; j++)
+	mean += rho_(i, j);
+    mean /= T(nx) * ny;
+
+    grid2d<complex_type> a( nx, nk ), b( nk, nx );
+    fft_plan<T> fft_y( ny ), fft_x( nx );
+
+    // forward along y
+    team_.parallel_for( 0, (nx + 1) / 2, [&, mean, nx, ny, nk](int p0, int p1) {
+	std::vector<complex_type> z( ny ), work( fft_y.work_size() + 1 );
+	for (int p = p0; p < p1; p++) {
+	  int i0 = 2 * p, i1 = 2 * p + 1;
+	  for (int j = 0; j < ny; j++)
+	    z[j] = complex_type( rho_(i0 + 1, j + 1) - mean,
+				 i1 < nx ? rho_(i1 + 1, j + 1) - mean : 0 );
+	  fft_y.transform( &z[0], 1, &work[0] );
+	  for (int k = 0; k < nk; k++) {
+	    complex_type zc = std::conj( z[(ny - k) % ny] );
+	    a(i0, k) = T(0.5) * ( z[k] + zc );
+	    if ( i1 < nx )
+	      a(i1, k) = complex_type(0, -0.5) * ( z[k] - zc );
+	  }
+	}
+      }, min_rows_per_thread / 2 );
+
+    transpose( team_, a, b, nx, nk );
+
+    // along x, divide by the eigenvalues, back along x
+    const T pi = 4 * std::atan( T(1) );
+    team_.parallel_for( 0, nk, [&, pi, nx, ny](int k0, int k1) {
+	std::vector<complex_type> work( fft_x.work_size() + 1 );
+	T norm = T(1) / ( T(nx) * ny );
+	for (int k = k0; k < k1; k++) {
+	  complex_type * bk = b.row(k);
+	  fft_x.transform( bk, 1, &work[0] );
+	  T sy = std::sin( pi * k / ny );
+	  for (int m = 0; m < nx; m++) {
+	    T sx = std::sin( pi * m / nx );
+	    T lambda = 4 * (sx * sx + sy * sy) / (h_ * h_);
+	    bk[m] = lambda > 0 ? bk[m] * (norm / lambda) : complex_type(0);
+	  }
+	  fft_x.transform( bk, -1, &work[0] );
+	}
+      }, min_rows_per_thread );
+
+    transpose( team_, b, a, nk, nx );
+
+    // back along y: rebuild the full spectrum of z = a_i0 + i a_i1
+    team_.parallel_for( 0, (nx + 1) / 2, [&, nx, ny, nk](int p0, int p1) {
+	std::vector<complex_type> z( ny ), work( fft_y.work_size() + 1 );
+	const complex_type I(0, 1);
+	for (int p = p0; p < p1; p++) {
+	  int i0 = 2 * p, i1 = 2 * p + 1;
+	  for (int k = 0; k < nk; k++) {
+	    complex_type A = a(i0, k), B = i1 < nx ? a(i1, k) : complex_type(0);
+	    z[k] = A + I * B;
+	    if ( k > 0 && ny - k >= nk )
+	      z[ny - k] = std::conj( A ) + I * std::conj( B );
+	  }
+	  fft_y.transform( &z[0], -1, &work[0] );
+	  for (int j = 0; j < ny; j++) {
+	    psi_(i0 + 1, j + 1) = z[j].real();
+	    if ( i1 < nx )
+	      psi_(i1 + 1, j + 1) = z[j].imag();
+	  }
+	}
+      }, min_rows_per_thread / 2 );
+
+    // periodic images in the ghost layer
+    for (int j = 1; j <= ny; j++) {
+      psi_(0, j) = psi_(nx, j);
+      psi_(nx + 1, j) = psi_(1, j);
+    }
+    for (int i = 0; i <= nx + 1; i++) {
+      psi_(i, 0) = psi_(i, ny);
+      psi_(i, ny + 1) = psi_(i, 1);
+    }
+  }
+
+  // sine transform of rows 0 .. n-1 of g, two at a time
+  void dst_rows( dst1_plan<T> const & dst, grid2d<T> & g, int n )
+  {
+    team_.parallel_for( 0, (n + 1) / 2, [&dst, &g, n](int p0, int p1) {
+	std::vector<complex_type> work( dst.work_size() );
+	for (int p = p0; p < p1; p++)
+	  dst.transform( g.row(2 * p), 2 * p + 1 < n ? g.row(2 * p + 1) : 0, &work[0] );
+      }, min_rows_per_thread / 2 );
+  }
+
+  static matrix_type to_matrix( grid2d<T> const & g ) {
+    matrix_type m;
+    init_matrix( m, g.nx(), g.ny() );
+    for ( int i = 0; i < g.nx(); ++i )
+      for ( int j = 0; j < g.ny(); ++j )
+	m[i][j] = g(i, j);
+    return m;
+  }
+
+  int nx_, ny_;       // number of interior points (one period) in x and y
+  int bc_;            // DIRICHLET or PERIODIC
+  T h_;               // step size
+  grid2d<T> psi_;     // solution, with the boundary / ghost layer
+  grid2d<T> rho_;     // source
+  thread_team team_;  // threads sharing the rows of each transform
+  static const int min_rows_per_thread = 16;
+};
+
+#endif
@@ -1,33 +1,60 @@
 #include "poisson_mg.h"
-#include <fstream>
+#include <cstdlib>
+#include <iomanip>
 using namespace std;
 
 
 int main()
 {
-  int L = 6, n_smooth=3;
+  int L = 63, n_smooth=3;
   double accuracy = 1e-6;
 
+  // point charge in the middle of the square
   poisson_mg<double>::matrix_type rho;
   poisson_mg<double>::init_matrix( rho, L+2, L+2);
+  rho[L/2 + 1][L/2 + 1] = 1.0 * (L + 1) * (L + 1);
 
   poisson_mg<double> pmg(rho, accuracy, L, n_smooth);
+  pmg.set_cycle_type( poisson_mg<double>::W_CYCLE );
   clock_t t0 = clock();
   pmg.execute();
   clock_t t1 = clock();
   cout << " CPU time = " << double(t1 - t0) / CLOCKS_PER_SEC
        << " sec" << endl;
+  cout << " Cycles = " << pmg.get_steps()
+       << ", residual reduced by " << pmg.get_residuals().back() / pmg.get_residuals().front()
+       << endl;
 
-  // write potential to file
-  ofstream file("poisson_mg.data");
-  for (int i = 0; i < L + 2; i++) {
-    double x = i * pmg.get_h();
-    for (int j = 0; j < L + 2; j++) {
-      double y = j * pmg.get_h();
-      file << x << '\t' << y << '\t' << pmg.get_psi()[i][j] << '\n';
-    }
-    file << '\n';
+  // write potential as a binary field file (read it with read_field.py),
+  // and 4 x 4 block averages for a quick look
+  if ( pmg.write_psi("poisson_mg.field", FIELD_FLOAT64, 4) )
+    cout << " Potential in file poisson_mg.field, preview in poisson_mg.preview.field" << endl;
+
+  // V-cycle convergence with full weighting should not depend on whether
+  // L is 2^k - 1, where the coarse grids nest exactly, or not
+  bool ok = true;
+  cout << "\n     L  levels  cycles  median factor" << endl;
+  int sizes[] = { 63, 64, 100, 255, 256 };
+  for ( int n : sizes ) {
+    poisson_mg<double>::matrix_type rho_n;
+    poisson_mg<double>::init_matrix( rho_n, n+2, n+2 );
+    for ( int i = 1; i <= n; i++ )
+      for ( int j = 1; j <= n; j++ )
+	rho_n[i][j] = sin(3.0 * i) + cos(0.1 * j);
+    poisson_mg<double> p(rho_n, 1e-10, n, n_smooth);
+    p.set_verbose( false );
+    p.set_fmg( false );
+    p.execute();
+    vector<double> const & q = p.get_convergence_factors();
+    double factor = q[q.size() / 2];
+    cout << setw(6) << n << setw(8) << p.get_n_levels() << setw(8) << p.get_steps()
+	 << setw(15) << factor << endl;
+    if ( factor > 0.1 )
+      ok = false;
+  }
+  if ( !ok ) {
+    cout << " FAILED: a V-cycle reduced the residual by less than 10x per cycle" << endl;
+    return EXIT_FAILURE;
   }
-  file.close();
-  cout << " Potential in file poisson_mg.data" << endl;
+  cout << " PASSED" << endl;
 }
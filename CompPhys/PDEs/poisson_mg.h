@@ -1,30 +1,86 @@
+#ifndef poisson_mg_h
+#define poisson_mg_h
+
 #include <iostream>
 #include <vector>
 #include <cmath>
 
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+#include "mg_pcg.h"
+
 template< typename T>
 class poisson_mg {
 public :
-  
+
   typedef std::vector< std::vector<T> > matrix_type;
-  
-  poisson_mg( matrix_type const & rho_in, T iaccuracy = 0.001, int iL = 64, int in_smooth = 5) :
-    accuracy_(iaccuracy), L_(iL), n_smooth_(in_smooth), rho_(rho_in)
+  typedef grid2d<T> grid_type;
+
+  // one level of the multigrid hierarchy, all allocated up front
+  struct level_type {
+    int L;                // number of interior points in each dimension
+    T h;                  // step size
+    grid_type u;          // solution (level 0) or correction (coarser levels)
+    grid_type f;          // source (level 0) or restricted residual
+    grid_type r;          // residual
+    T gap;                // distance from point L to the boundary, in units of h
+  };
+
+  // grid transfer operators between levels
+  enum { AVERAGE_INJECTION = 0,   // 2x2 average / piecewise constant, coarse L = L/2
+	 FULL_WEIGHTING };        // 9-point full weighting / bilinear, coarse L = L/2
+
+  poisson_mg( matrix_type const & rho_in, T iaccuracy = 0.001, int iL = 64, int in_smooth = 5,
+	      int in_threads = 1, int itransfer = FULL_WEIGHTING) :
+    accuracy_(iaccuracy), L_(iL), n_smooth_(in_smooth), team_(in_threads)
   {
-    init_matrix(psi_, L_+2, L_+2);
-    init_matrix(psi_new_, L_+2, L_+2);
-    init_matrix(rho_, L_+2, L_+2);
-
     h_ = 1. / static_cast<T>(L_ + 1);      // assume physical size in x and y = 1
 
+    levels_.push_back( level_type() );
+    levels_[0].L = L_;
+    levels_[0].h = h_;
+    levels_[0].gap = 1;
+    levels_[0].u.resize( L_+2, L_+2 );
+    levels_[0].f.resize( L_+2, L_+2 );
+    levels_[0].r.resize( L_+2, L_+2 );
+    set_transfer( itransfer );
+
+    // rho_in may be smaller than the (L+2) x (L+2) grid; missing entries are zero
+    for ( unsigned int i = 0; i < rho_in.size() && i < static_cast<unsigned int>(L_+2); ++i )
+      for ( unsigned int j = 0; j < rho_in[i].size() && j < static_cast<unsigned int>(L_+2); ++j )
+	levels_[0].f(i, j) = rho_in[i][j];
+
     steps_ = 0;
   }
 
-  void reset_psi(){
-    for( unsigned int i = 0; i < psi_.size(); ++i )
-      for ( unsigned int j = 0; j < psi_[i].size(); ++j ){
-        psi_new_[i][j] = psi_[i][j]; 
-      }
+  // Choose the transfer operators and rebuild the coarse levels to match.
+  // Coarse point I sits on fine point 2I - 1 (AVERAGE_INJECTION) or 2I
+  // (FULL_WEIGHTING). With full weighting and L = 2^k - 1 every coarse
+  // boundary lands on the fine one. For other L the last coarse point is
+  // closer to the boundary than h, by gap h with 1/2 <= gap < 1 or less
+  // further down, and the points next to that boundary use the
+  // Shortley-Weller difference for the uneven spacing, so the coarse
+  // levels still cover the whole square.
+  void set_transfer( int transfer ) {
+    transfer_ = transfer;
+    levels_.resize( 1 );
+    int L = L_;
+    T h = h_, gap = 1;
+    while ( L > 1 ) {
+      if ( transfer_ == FULL_WEIGHTING )
+	gap = L % 2 ? (1 + gap) / 2 : gap / 2;
+      L = L / 2;
+      h *= 2;
+      levels_.push_back( level_type() );
+      level_type & lev = levels_.back();
+      lev.L = L;
+      lev.h = h;
+      lev.gap = gap;
+      lev.u.resize( L+2, L+2 );
+      lev.f.resize( L+2, L+2 );
+      lev.r.resize( L+2, L+2 );
+    }
   }
 
   static void init_matrix( matrix_type & matrix, unsigned int N, unsigned int M) {
@@ -35,149 +91,433 @@ public :
   }
 
 
-  void Gauss_Seidel(T h, matrix_type& u, const matrix_type& f)
+  // Red-black Gauss-Seidel sweep. Each colour visits only its own points
+  // with a stride-2 inner loop; rows of one colour are independent, so
+  // they are split across the thread team. reverse does black first.
+  void Gauss_Seidel( level_type & lev, bool reverse = false )
   {
-    int L = u.size() - 2;
+    int L = lev.L;
+    T h2 = lev.h * lev.h;
+    grid_type & u = lev.u;
+    grid_type const & f = lev.f;
+
+    for (int c = 0; c < 2; c++) {
+      int color = reverse ? 1 - c : c;
+      team_.parallel_for( 1, L + 1, [&u, &f, h2, L, color](int i0, int i1) {
+	  for (int i = i0; i < i1; i++)
+	    Gauss_Seidel_row( u.row(i), u.row(i - 1), u.row(i + 1), f.row(i),
+			      h2, 2 - (i + color) % 2, L );
+	}, min_rows_per_thread );
+      // redo this colour's points of the last row and column with the
+      // uneven spacing; their neighbours have the other colour
+      if ( lev.gap < 1 )
+	for (int k = 1; k <= L; k++) {
+	  if ( (L + k + color) % 2 == 0 )
+	    u(L, k) = last_sum( lev, L, k, h2 );
+	  if ( k < L && (k + L + color) % 2 == 0 )
+	    u(k, L) = last_sum( lev, k, L, h2 );
+	}
+    }
+  }
+
+  // Shortley-Weller weights of the inner and the boundary neighbour of a
+  // point gap h from the boundary, relative to 1 for even spacing
+  static T inner_weight( T gap ) { return 2 / (1 + gap); }
+  static T outer_weight( T gap ) { return 2 / (gap * (1 + gap)); }
 
-    // use checkerboard updating
-    for (int color = 0; color < 2; color++)
-      for (int i = 1; i <= L; i++)
-	for (int j = 1; j <= L; j++)
-	  if ((i + j) % 2 == color)
-	    u[i][j] = 0.25 * (u[i - 1][j] + u[i + 1][j] +
-			      u[i][j - 1] + u[i][j + 1] +
-			      h * h * f[i][j]);
+  // Gauss-Seidel value at point (i, j) of the last row or column of a
+  // level with gap < 1; given diag, the weighted sum of the neighbours
+  // instead, with the sum of the weights in *diag
+  static T last_sum( level_type const & lev, int i, int j, T h2, T * diag = 0 )
+  {
+    int L = lev.L;
+    grid_type const & u = lev.u;
+    T wi = inner_weight( lev.gap ), wo = outer_weight( lev.gap );
+    T xm = i == L ? wi : 1, xp = i == L ? wo : 1;
+    T ym = j == L ? wi : 1, yp = j == L ? wo : 1;
+    T sum = xm * u(i - 1, j) + xp * u(i + 1, j) + ym * u(i, j - 1) + yp * u(i, j + 1);
+    T d = xm + xp + ym + yp;
+    if ( diag ) {
+      *diag = d;
+      return sum;
+    }
+    return ( sum + h2 * lev.f(i, j) ) / d;
+  }
+
+  // update points j0, j0 + 2, ... <= L of one row
+  static void Gauss_Seidel_row( T * __restrict ui, T const * __restrict um, T const * __restrict up,
+				T const * __restrict fi, T h2, int j0, int L )
+  {
+    for (int j = j0; j <= L; j += 2)
+      ui[j] = 0.25 * (um[j] + up[j] +
+		      ui[j - 1] + ui[j + 1] +
+		      h2 * fi[j]);
   }
 
-  
+
+  enum { V_CYCLE = 0, W_CYCLE, F_CYCLE };
+
+  // Solve until the RMS residual drops below accuracy times its initial
+  // value, stops decreasing, or max_cycles cycles have been done. With FMG on, the first
+  // guess comes from full multigrid: nested iteration up from the
+  // coarsest level, one cycle per level.
   void execute(){
-    T error = 1e30;
-    unsigned int nmax = 10;
-    while ( error > accuracy_ && steps_ < nmax ){
-      std::cout << "step " << steps_ << std::endl;
-      two_grid(get_h(), get_psi(), get_rho());
-      inc_steps();
-      error = relative_error();
+    if ( krylov_ ) {
+      mg_pcg< poisson_mg<T> > pcg( *this );
+      steps_ += pcg.solve( accuracy_, max_cycles_, residuals_, factors_, verbose_ );
+      return;
+    }
+
+    T r0 = residual_norm( 0 );
+    residuals_.assign( 1, r0 );
+    factors_.clear();
+    if ( r0 == 0 )
+      return;
+
+    if ( fmg_ && levels_.size() > 1 ) {
+      full_multigrid();
+      record_cycle();
+    }
+    while ( residuals_.back() > accuracy_ * r0 && steps_ < max_cycles_ ){
+      cycle( 0, cycle_type_ );
+      record_cycle();
+      // stop at the round-off floor, where cycles no longer reduce r
+      if ( factors_.size() > 1 && factors_.back() >= 1 )
+	break;
     }
   }
 
-  void two_grid(T h, matrix_type& u, matrix_type& f)
+  // one V-cycle starting at level l, reusing the preallocated grids
+  void two_grid( unsigned int l ) { cycle( l, V_CYCLE ); }
+
+  // One multigrid cycle at level l. The coarse-grid correction is one
+  // V-cycle, two W-cycles, or an F-cycle followed by a V-cycle.
+  void cycle( unsigned int l, int type )
   {
-    std::cout << "make u" << std::endl;
+    level_type & lev = levels_[l];
+    int L = lev.L;
+
     // solve exactly if there is only one interior point
-    int L = u.size() - 2;
     if ( L == 0 )
       return;
     if (L == 1) {
-      u[1][1] = 0.25 * (u[0][1] + u[2][1] + u[1][0] + u[1][2] +
-			h * h * f[1][1]);
+      lev.u(1, 1) = last_sum( lev, 1, 1, lev.h * lev.h );
+      return;
+    }
+
+    // a coarsest level with a few points left is solved by relaxation
+    if ( l + 1 == levels_.size() ) {
+      for (int i = 0; i < coarsest_sweeps; i++)
+	Gauss_Seidel( lev, symmetric_ && 2 * i >= coarsest_sweeps );
       return;
     }
 
     // do a few pre-smoothing Gauss-Seidel steps
     for (int i = 0; i < n_smooth_; i++)
-      Gauss_Seidel(h, u, f);
-
-    // find the residual
-    matrix_type r;
-    init_matrix(r, L+2, L+2);
-    for (int i = 1; i <= L; i++)
-      for (int j = 1; j <= L; j++)
-	r[i][j] = f[i][j] +
-	  ( u[i + 1][j] + u[i - 1][j] +
-	    u[i][j + 1] + u[i][j - 1] - 4 * u[i][j]) / (h * h);
-
-    // restrict residual to coarser grid
-    int L2 = L / 2;
-    matrix_type R;
-    init_matrix(R, L2 + 2, L2 + 2);
+      Gauss_Seidel( lev );
+
+    // restrict the residual to the coarser grid and solve for the
+    // correction there, starting from zero
+    compute_residual( l );
+    restrict_to_coarse( l, lev.r );
+    levels_[l + 1].u.fill( 0 );
+    switch ( type ) {
+    case W_CYCLE :
+      cycle( l + 1, W_CYCLE );
+      cycle( l + 1, W_CYCLE );
+      break;
+    case F_CYCLE :
+      cycle( l + 1, F_CYCLE );
+      cycle( l + 1, V_CYCLE );
+      break;
+    default :
+      cycle( l + 1, V_CYCLE );
+    }
+    prolongate_add( l );
+
+    // do a few post-smoothing Gauss-Seidel steps
+    for (int i = 0; i < n_smooth_; i++)
+      Gauss_Seidel( lev, symmetric_ );
+  }
+
+  // Full multigrid for the correction to psi: the fine residual is
+  // restricted all the way down, solved on the coarsest level, and each
+  // finer level starts from the interpolated coarse solution and gets one
+  // cycle. The result is added to psi.
+  void full_multigrid()
+  {
+    compute_residual( 0 );
+    restrict_to_coarse( 0, levels_[0].r );
+    for ( unsigned int l = 1; l + 1 < levels_.size(); ++l )
+      restrict_to_coarse( l, levels_[l].f );
+
+    unsigned int coarsest = levels_.size() - 1;
+    levels_[coarsest].u.fill( 0 );
+    cycle( coarsest, V_CYCLE );
+    for ( unsigned int l = coarsest - 1; l >= 1; --l ) {
+      levels_[l].u.fill( 0 );
+      prolongate_add( l );
+      cycle( l, cycle_type_ );
+    }
+    prolongate_add( 0 );
+  }
+
+  // r = f + laplacian(u) on level l
+  void compute_residual( unsigned int l )
+  {
+    level_type & lev = levels_[l];
+    grid_type const & u = lev.u;
+    grid_type const & f = lev.f;
+    grid_type & r = lev.r;
+    int L = lev.L;
+    T inv_h2 = 1 / (lev.h * lev.h);
+    team_.parallel_for( 1, L + 1, [&u, &f, &r, inv_h2, L](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * ui = u.row(i);
+	  T const * um = u.row(i - 1);
+	  T const * up = u.row(i + 1);
+	  T const * fi = f.row(i);
+	  T * ri = r.row(i);
+	  for (int j = 1; j <= L; j++)
+	    ri[j] = fi[j] +
+	      ( up[j] + um[j] + ui[j + 1] + ui[j - 1] - 4 * ui[j]) * inv_h2;
+	}
+      }, min_rows_per_thread );
+    if ( lev.gap < 1 )
+      for (int k = 1; k <= L; k++) {
+	T d;
+	r(L, k) = f(L, k) + ( last_sum( lev, L, k, 0, &d ) - d * u(L, k) ) * inv_h2;
+	r(k, L) = f(k, L) + ( last_sum( lev, k, L, 0, &d ) - d * u(k, L) ) * inv_h2;
+      }
+  }
+
+  // y = -laplacian(x) on level 0, with x = 0 on the boundary
+  void apply_operator( grid_type & x, grid_type & y )
+  {
+    int L = L_;
+    T inv_h2 = 1 / (h_ * h_);
+    team_.parallel_for( 1, L + 1, [&x, &y, inv_h2, L](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * __restrict xi = x.row(i);
+	  T const * __restrict xm = x.row(i - 1);
+	  T const * __restrict xp = x.row(i + 1);
+	  T * __restrict yi = y.row(i);
+	  for (int j = 1; j <= L; j++)
+	    yi[j] = ( 4 * xi[j] - xp[j] - xm[j] - xi[j + 1] - xi[j - 1] ) * inv_h2;
+	}
+      }, min_rows_per_thread );
+  }
+
+  // z = one V-cycle for -laplacian(z) = r from z = 0, run on the level 0
+  // grids with psi and rho swapped out
+  void precondition( grid_type & r, grid_type & z )
+  {
+    z.fill( 0 );
+    std::swap( levels_[0].u, z );
+    std::swap( levels_[0].f, r );
+    symmetric_ = true;
+    cycle( 0, V_CYCLE );
+    symmetric_ = false;
+    std::swap( levels_[0].u, z );
+    std::swap( levels_[0].f, r );
+  }
+
+  // RMS of the residual over the interior of level l
+  T residual_norm( unsigned int l )
+  {
+    compute_residual( l );
+    level_type const & lev = levels_[l];
+    T sum = 0;
+    for (int i = 1; i <= lev.L; i++) {
+      T const * ri = lev.r.row(i);
+      for (int j = 1; j <= lev.L; j++)
+	sum += ri[j] * ri[j];
+    }
+    return lev.L > 0 ? std::sqrt( sum / (T(lev.L) * lev.L) ) : 0;
+  }
+
+  // restrict fine values r into the source of level l + 1
+  void restrict_to_coarse( unsigned int l, grid_type const & r )
+  {
+    level_type & coarse = levels_[l + 1];
+    int L2 = coarse.L;
+    grid_type & R = coarse.f;
+    if ( transfer_ == FULL_WEIGHTING ) {
+      // weights 1/16 * [1 2 1; 2 4 2; 1 2 1] around fine point (2I, 2J)
+      team_.parallel_for( 1, L2 + 1, [&r, &R, L2](int I0, int I1) {
+	  for (int I = I0; I < I1; I++) {
+	    T const * rm = r.row(2 * I - 1);
+	    T const * r0 = r.row(2 * I);
+	    T const * rp = r.row(2 * I + 1);
+	    T * RI = R.row(I);
+	    for (int J = 1; J <= L2; J++) {
+	      int j = 2 * J;
+	      RI[J] = 0.0625 * ( 4 * r0[j]
+				 + 2 * ( r0[j - 1] + r0[j + 1] + rm[j] + rp[j] )
+				 + rm[j - 1] + rm[j + 1] + rp[j - 1] + rp[j + 1] );
+	    }
+	  }
+	}, min_rows_per_thread );
+      // for even fine L the last coarse row and column sit next to the
+      // boundary, which has weight 4/16 and no residual: average over the
+      // 12/16 inside
+      if ( levels_[l].L % 2 == 0 )
+	for (int K = 1; K <= L2; K++) {
+	  R(L2, K) *= T(4) / 3;
+	  R(K, L2) *= T(4) / 3;
+	}
+      return;
+    }
+
+    // average 2x2 blocks
     for (int I = 1; I <= L2; I++) {
       int i = 2 * I - 1;
+      T const * r0 = r.row(i);
+      T const * r1 = r.row(i + 1);
+      T * RI = R.row(I);
       for (int J = 1; J <= L2; J++) {
 	int j = 2 * J - 1;
-	R[I][J] = 0.25 * ( r[i][j] + r[i + 1][j] + r[i][j + 1] +
-			   r[i + 1][j + 1]);
+	RI[J] = 0.25 * ( r0[j] + r1[j] + r0[j + 1] + r1[j + 1] );
       }
     }
+  }
 
-    
-    // initialize correction V on coarse grid to zero
-    matrix_type V;
-    init_matrix(V, L2 + 2, L2 + 2);
-
-    // call twoGrid recursively
-    T H = 2 * h;
-    two_grid(H, V, R);
+  // add u of level l + 1, interpolated, to u of level l
+  void prolongate_add( unsigned int l )
+  {
+    grid_type & u = levels_[l].u;
+    grid_type const & V = levels_[l + 1].u;
+    int L = levels_[l].L;
+    int L2 = levels_[l + 1].L;
+    if ( transfer_ == FULL_WEIGHTING ) {
+      // bilinear: even fine rows lie on coarse row i/2, odd ones halfway
+      // between (i-1)/2 and (i+1)/2; the same in j. The coarse boundary
+      // values are zero. For odd L fine point L lies between coarse point
+      // L2 and a boundary gap H away, so it gets 1 - 1/(2 gap) of V there
+      // instead of 1/2.
+      T s = L % 2 ? 2 - 1 / levels_[l + 1].gap : 1;
+      team_.parallel_for( 1, L + 1, [&u, &V, L, s](int i0, int i1) {
+	  for (int i = i0; i < i1; i++) {
+	    T * ui = u.row(i);
+	    T const * Va = V.row(i / 2);
+	    T const * Vb = V.row((i + 1) / 2);
+	    T si = i == L ? s : 1;
+	    for (int j = 1; j < L; j++)
+	      ui[j] += 0.25 * si * ( Va[j / 2] + Va[(j + 1) / 2] + Vb[j / 2] + Vb[(j + 1) / 2] );
+	    ui[L] += 0.25 * si * s * ( Va[L / 2] + Va[(L + 1) / 2] + Vb[L / 2] + Vb[(L + 1) / 2] );
+	  }
+	}, min_rows_per_thread );
+      return;
+    }
 
-    // prolongate V to fine grid using simple injection
-    matrix_type v;
-    init_matrix(v, L + 2, L + 2);
+    // simple injection onto 2x2 blocks
     for (int I = 1; I <= L2; I++) {
       int i = 2 * I - 1;
+      T * u0 = u.row(i);
+      T * u1 = u.row(i + 1);
+      T const * VI = V.row(I);
       for (int J = 1; J <= L2; J++) {
 	int j = 2 * J - 1;
-	v[i][j] = v[i + 1][j] = v[i][j + 1] = v[i + 1][j + 1] = V[I][J];
+	u0[j] += VI[J];
+	u0[j + 1] += VI[J];
+	u1[j] += VI[J];
+	u1[j + 1] += VI[J];
       }
     }
-
-    // correct u
-    for (int i = 1; i <= L; i++)
-      for (int j = 1; j <= L; j++)
-	u[i][j] += v[i][j];
-
-    // do a few post-smoothing Gauss-Seidel steps
-    for (int i = 0; i < n_smooth_; i++)
-      Gauss_Seidel(h, u, f);
   }
 
-  T relative_error()
+  int get_transfer() const { return transfer_; }
+  // Krylov mode: execute() runs conjugate gradients with one V-cycle
+  // as the preconditioner, which copes better with rough problems
+  void set_krylov( bool krylov ) { krylov_ = krylov; }
+  void set_cycle_type( int type ) { cycle_type_ = type; }
+  void set_fmg( bool fmg ) { fmg_ = fmg; }
+  void set_max_cycles( unsigned int n ) { max_cycles_ = n; }
+  void set_verbose( bool v ) { verbose_ = v; }
+
+  // RMS residual before the first and after every cycle, and the
+  // convergence factor of each cycle
+  std::vector<T> const & get_residuals() const { return residuals_; }
+  std::vector<T> const & get_convergence_factors() const { return factors_; }
+
+  // copies of the grids as nested vectors, e.g. for numpy through SWIG
+  matrix_type get_psi() const { return to_matrix( psi() ); }
+  matrix_type get_rho() const { return to_matrix( rho() ); }
+
+  T get_psi    ( int i, int j) const { return psi()(i, j); }
+  T get_rho    ( int i, int j) const { return rho()(i, j); }
+
+  // psi with the boundary, point (i, j) at (i h, j h), as a binary field
+  // file (field_io.h); preview > 1 also writes preview x preview averages
+  bool write_psi( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
   {
-    T error = 0;           // average relative error per lattice point
-    int n = 0;                  // number of non-zero differences
-
-    for (int i = 1; i <= L_; i++)
-      for (int j = 1; j <= L_; j++) {
-	if (psi_new_[i][j] != 0.0)
-	  if (psi_new_[i][j] != psi_[i][j]) {
-	    error += std::fabs(1 - psi_[i][j] / psi_new_[i][j]);
-	    ++n;
-	  }
-      }
-    if (n != 0)
-      error /= n;
-
-    return error;
+    field_header h( dtype );
+    h.spacing[0] = h.spacing[1] = h_;
+    return write_field( file, psi(), 0, 0, L_+2, L_+2, h, FIELD_MMAP, preview );
   }
 
-  matrix_type const & get_psi() const { return psi_; }
-  matrix_type const & get_psi_new() const { return psi_new_; }
-  matrix_type const & get_rho() const { return rho_; }
-
-
-  matrix_type  & get_psi()  { return psi_; }
-  matrix_type  & get_psi_new()  { return psi_new_; }
-  matrix_type  & get_rho()  { return rho_; }
-
-  void set_psi    ( int i, int j, T f) { psi_[i][j] = f; }
-  void set_psi_new( int i, int j, T f) { psi_new_[i][j] = f; }
-  void set_rho    ( int i, int j, T f) { rho_[i][j] = f; }
+  void set_psi    ( int i, int j, T f) { psi()(i, j) = f; }
+  void set_rho    ( int i, int j, T f) { rho()(i, j) = f; }
 
   T get_h () const { return h_;}
+  int get_L () const { return L_;}
   unsigned int    get_steps() const { return steps_; }
+  unsigned int    get_n_levels() const { return levels_.size(); }
+  int get_n_threads() const { return team_.size(); }
+  thread_team & get_team() { return team_; }
+  level_type & get_level( unsigned int l ) { return levels_[l]; }
 
   void inc_steps() { ++steps_;}
-protected : 
+protected :
+
+  void record_cycle() {
+    inc_steps();
+    residuals_.push_back( residual_norm( 0 ) );
+    factors_.push_back( residuals_[residuals_.size() - 2] > 0 ?
+			residuals_.back() / residuals_[residuals_.size() - 2] : 0 );
+    if ( verbose_ )
+      std::cout << "cycle " << steps_ << "  residual " << residuals_.back()
+		<< "  factor " << factors_.back() << std::endl;
+  }
+
+  static matrix_type to_matrix( grid_type const & g ) {
+    matrix_type m;
+    init_matrix( m, g.nx(), g.ny() );
+    for ( int i = 0; i < g.nx(); ++i )
+      for ( int j = 0; j < g.ny(); ++j )
+	m[i][j] = g(i, j);
+    return m;
+  }
+
+  grid_type       & psi()       { return levels_[0].u; }
+  grid_type const & psi() const { return levels_[0].u; }
+  grid_type       & rho()       { return levels_[0].f; }
+  grid_type const & rho() const { return levels_[0].f; }
 
-  T accuracy_;        // desired relative accuracy in solution
+  T accuracy_;        // residual reduction at which execute() stops
   int L_;             // number of interior points in each dimension
   int n_smooth_;      // number of pre and post smoothing iterations
 
-  matrix_type psi_,   // solution to be found
-    psi_new_,         // approximate solution after 1 iteration
-    rho_;             // given source function
+  std::vector<level_type> levels_;  // level 0 holds psi and rho
 
   T h_;               // step size
   unsigned int steps_;// number of iteration steps
 
+  thread_team team_;  // threads sharing the rows of each sweep
+
+  int transfer_;                    // restriction / prolongation pair
+  int cycle_type_ = V_CYCLE;        // V, W or F cycles
+  bool fmg_ = true;                 // start from full multigrid
+  bool krylov_ = false;             // preconditioned CG instead of cycles
+  bool symmetric_ = false;          // post-smooth in reverse colour order
+  unsigned int max_cycles_ = 100;   // give up after this many cycles
+  bool verbose_ = true;             // print the residual after each cycle
+  std::vector<T> residuals_;        // RMS residual history
+  std::vector<T> factors_;          // convergence factor per cycle
+  static const int min_rows_per_thread = 32;  // coarse levels run serially
+  static const int coarsest_sweeps = 20;      // relaxation on a coarsest level with L > 1
+
 
 };
+
+#endif
@@ -0,0 +1,61 @@
+#include "poisson_mg3d.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+using namespace std;
+
+// Check poisson_mg3d against psi = sin(pi x) sin(pi y) sin(pi z), the
+// solution for rho = 3 pi^2 psi. The 7-point stencil turns this into
+// the same mode scaled by 3 pi^2 / lambda_h, which gives the expected
+// discretization error exactly.
+//
+//   usage: poisson_mg3d [L] [threads]
+int main(int argc, char * argv[])
+{
+  int L_max = argc > 1 ? atoi(argv[1]) : 127;
+  int n_threads = argc > 2 ? atoi(argv[2]) : 0;
+  int n_smooth = 3;
+  double accuracy = 1e-8;
+  const double pi = 4 * atan(1.0);
+
+  bool ok = true;
+  cout << "     L   cycles    time(s)     max error    expected" << endl;
+  for (int L = 15; L <= L_max; L = 2 * L + 1) {
+    poisson_mg3d<double>::cube_type rho;
+    poisson_mg3d<double> pmg(rho, accuracy, L, n_smooth, n_threads);
+    pmg.set_verbose(false);
+    double h = pmg.get_h();
+    for (int i = 1; i <= L; i++)
+      for (int j = 1; j <= L; j++)
+	for (int k = 1; k <= L; k++)
+	  pmg.set_rho(i, j, k, 3 * pi * pi *
+		      sin(pi * i * h) * sin(pi * j * h) * sin(pi * k * h));
+
+    auto t0 = chrono::steady_clock::now();
+    pmg.execute();
+    auto t1 = chrono::steady_clock::now();
+
+    double err = 0;
+    for (int i = 1; i <= L; i++)
+      for (int j = 1; j <= L; j++)
+	for (int k = 1; k <= L; k++) {
+	  double exact = sin(pi * i * h) * sin(pi * j * h) * sin(pi * k * h);
+	  err = max(err, fabs(pmg.get_psi(i, j, k) - exact));
+	}
+    double s = sin(pi * h / 2);
+    double lambda_h = 3 * 4 * s * s / (h * h);
+    double expected = fabs(3 * pi * pi / lambda_h - 1);
+
+    cout << setw(6) << L << setw(9) << pmg.get_steps()
+	 << setw(11) << chrono::duration<double>(t1 - t0).count()
+	 << setw(14) << err << setw(12) << expected << endl;
+    if (fabs(err - expected) > 0.01 * expected)
+      ok = false;
+  }
+
+  if (!ok) {
+    cout << " error differs from the discretization error" << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " errors match the discretization error" << endl;
+}
@@ -0,0 +1,383 @@
+#ifndef poisson_mg3d_h
+#define poisson_mg3d_h
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+
+// Multigrid solver for -laplacian(psi) = rho on the unit cube with
+// psi = 0 on the boundary, using the 7-point stencil. It follows
+// poisson_mg: red-black Gauss-Seidel, full-weighting restriction and
+// trilinear prolongation, V/W/F cycles and an FMG start. Planes of the
+// grid are split across the thread team.
+template< typename T>
+class poisson_mg3d {
+public :
+
+  typedef std::vector< std::vector< std::vector<T> > > cube_type;
+  typedef grid3d<T> grid_type;
+
+  // one level of the multigrid hierarchy, all allocated up front
+  struct level_type {
+    int L;                // number of interior points in each dimension
+    T h;                  // step size
+    grid_type u;          // solution (level 0) or correction (coarser levels)
+    grid_type f;          // source (level 0) or restricted residual
+    grid_type r;          // residual
+  };
+
+  // rho_in may be smaller than the (L+2)^3 grid; missing entries are zero.
+  // At 512^3 and above it is cheaper to pass an empty rho_in and fill the
+  // source with set_rho().
+  poisson_mg3d( cube_type const & rho_in, T iaccuracy = 0.001, int iL = 64, int in_smooth = 3,
+		int in_threads = 1 ) :
+    accuracy_(iaccuracy), L_(iL), n_smooth_(in_smooth), team_(in_threads)
+  {
+    h_ = 1. / static_cast<T>(L_ + 1);      // assume physical size in x, y and z = 1
+
+    int L = L_;
+    T h = h_;
+    while ( L >= 1 ) {
+      levels_.push_back( level_type() );
+      level_type & lev = levels_.back();
+      lev.L = L;
+      lev.h = h;
+      lev.u.resize( L+2, L+2, L+2 );
+      lev.f.resize( L+2, L+2, L+2 );
+      lev.r.resize( L+2, L+2, L+2 );
+      // coarse point I sits on fine point 2I
+      L = (L - 1) / 2;
+      h *= 2;
+    }
+
+    unsigned int n = L_ + 2;
+    for ( unsigned int i = 0; i < rho_in.size() && i < n; ++i )
+      for ( unsigned int j = 0; j < rho_in[i].size() && j < n; ++j )
+	for ( unsigned int k = 0; k < rho_in[i][j].size() && k < n; ++k )
+	  levels_[0].f(i, j, k) = rho_in[i][j][k];
+
+    steps_ = 0;
+  }
+
+  static void init_cube( cube_type & cube, unsigned int N, unsigned int M, unsigned int K ) {
+    cube.resize( N );
+    for ( auto i = cube.begin(); i != cube.end(); ++i ) {
+      i->resize( M );
+      for ( auto j = i->begin(); j != i->end(); ++j )
+	j->resize( K );
+    }
+  }
+
+
+  // Red-black Gauss-Seidel sweep; point (i, j, k) is red if i + j + k is
+  // even. Planes of one colour pass are independent, so they are split
+  // across the thread team, and each row is a stride-2 loop.
+  void Gauss_Seidel( level_type & lev )
+  {
+    int L = lev.L;
+    T h2 = lev.h * lev.h;
+    grid_type & u = lev.u;
+    grid_type const & f = lev.f;
+
+    for (int color = 0; color < 2; color++)
+      team_.parallel_for( 1, L + 1, [&u, &f, h2, L, color](int i0, int i1) {
+	  for (int i = i0; i < i1; i++)
+	    for (int j = 1; j <= L; j++)
+	      Gauss_Seidel_row( u.row(i, j), u.row(i - 1, j), u.row(i + 1, j),
+				u.row(i, j - 1), u.row(i, j + 1), f.row(i, j),
+				h2, 2 - (i + j + color) % 2, L );
+	}, min_planes_per_thread );
+  }
+
+  // update points k0, k0 + 2, ... <= L of one row
+  static void Gauss_Seidel_row( T * __restrict ui, T const * __restrict uxm, T const * __restrict uxp,
+				T const * __restrict uym, T const * __restrict uyp,
+				T const * __restrict fi, T h2, int k0, int L )
+  {
+    const T sixth = T(1) / 6;
+    for (int k = k0; k <= L; k += 2)
+      ui[k] = sixth * (uxm[k] + uxp[k] + uym[k] + uyp[k] +
+		       ui[k - 1] + ui[k + 1] +
+		       h2 * fi[k]);
+  }
+
+
+  enum { V_CYCLE = 0, W_CYCLE, F_CYCLE };
+
+  // Solve until the RMS residual drops below accuracy times its initial
+  // value, stops decreasing, or max_cycles cycles have been done.
+  void execute(){
+    T r0 = residual_norm( 0 );
+    residuals_.assign( 1, r0 );
+    factors_.clear();
+    if ( r0 == 0 )
+      return;
+
+    if ( fmg_ && levels_.size() > 1 ) {
+      full_multigrid();
+      record_cycle();
+    }
+    while ( residuals_.back() > accuracy_ * r0 && steps_ < max_cycles_ ){
+      cycle( 0, cycle_type_ );
+      record_cycle();
+      if ( factors_.size() > 1 && factors_.back() >= 1 )
+	break;
+    }
+  }
+
+  // One multigrid cycle at level l, as in poisson_mg::cycle
+  void cycle( unsigned int l, int type )
+  {
+    level_type & lev = levels_[l];
+    int L = lev.L;
+
+    if (L == 1) {
+      grid_type & u = lev.u;
+      u(1, 1, 1) = (u(0, 1, 1) + u(2, 1, 1) + u(1, 0, 1) + u(1, 2, 1) +
+		    u(1, 1, 0) + u(1, 1, 2) + lev.h * lev.h * lev.f(1, 1, 1)) / 6;
+      return;
+    }
+
+    // a coarsest level with a few points left is solved by relaxation
+    if ( l + 1 == levels_.size() ) {
+      for (int i = 0; i < coarsest_sweeps; i++)
+	Gauss_Seidel( lev );
+      return;
+    }
+
+    for (int i = 0; i < n_smooth_; i++)
+      Gauss_Seidel( lev );
+
+    compute_residual( l );
+    restrict_to_coarse( l, lev.r );
+    levels_[l + 1].u.fill( 0 );
+    switch ( type ) {
+    case W_CYCLE :
+      cycle( l + 1, W_CYCLE );
+      cycle( l + 1, W_CYCLE );
+      break;
+    case F_CYCLE :
+      cycle( l + 1, F_CYCLE );
+      cycle( l + 1, V_CYCLE );
+      break;
+    default :
+      cycle( l + 1, V_CYCLE );
+    }
+    prolongate_add( l );
+
+    for (int i = 0; i < n_smooth_; i++)
+      Gauss_Seidel( lev );
+  }
+
+  // full multigrid for the correction to psi, as in poisson_mg
+  void full_multigrid()
+  {
+    compute_residual( 0 );
+    restrict_to_coarse( 0, levels_[0].r );
+    for ( unsigned int l = 1; l + 1 < levels_.size(); ++l )
+      restrict_to_coarse( l, levels_[l].f );
+
+    unsigned int coarsest = levels_.size() - 1;
+    levels_[coarsest].u.fill( 0 );
+    cycle( coarsest, V_CYCLE );
+    for ( unsigned int l = coarsest - 1; l >= 1; --l ) {
+      levels_[l].u.fill( 0 );
+      prolongate_add( l );
+      cycle( l, cycle_type_ );
+    }
+    prolongate_add( 0 );
+  }
+
+  // r = f + laplacian(u) on level l
+  void compute_residual( unsigned int l )
+  {
+    level_type & lev = levels_[l];
+    grid_type const & u = lev.u;
+    grid_type const & f = lev.f;
+    grid_type & r = lev.r;
+    int L = lev.L;
+    T inv_h2 = 1 / (lev.h * lev.h);
+    team_.parallel_for( 1, L + 1, [&u, &f, &r, inv_h2, L](int i0, int i1) {
+	for (int i = i0; i < i1; i++)
+	  for (int j = 1; j <= L; j++) {
+	    T const * ui = u.row(i, j);
+	    T const * uxm = u.row(i - 1, j);
+	    T const * uxp = u.row(i + 1, j);
+	    T const * uym = u.row(i, j - 1);
+	    T const * uyp = u.row(i, j + 1);
+	    T const * fi = f.row(i, j);
+	    T * ri = r.row(i, j);
+	    for (int k = 1; k <= L; k++)
+	      ri[k] = fi[k] +
+		( uxm[k] + uxp[k] + uym[k] + uyp[k] + ui[k - 1] + ui[k + 1]
+		  - 6 * ui[k] ) * inv_h2;
+	  }
+      }, min_planes_per_thread );
+  }
+
+  // RMS of the residual over the interior of level l; every plane is
+  // summed on its own so the result does not depend on the thread count
+  T residual_norm( unsigned int l )
+  {
+    compute_residual( l );
+    level_type const & lev = levels_[l];
+    int L = lev.L;
+    grid_type const & r = lev.r;
+    std::vector<T> plane_sum( L + 1, 0 );
+    team_.parallel_for( 1, L + 1, [&r, &plane_sum, L](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T sum = 0;
+	  for (int j = 1; j <= L; j++) {
+	    T const * ri = r.row(i, j);
+	    for (int k = 1; k <= L; k++)
+	      sum += ri[k] * ri[k];
+	  }
+	  plane_sum[i] = sum;
+	}
+      }, min_planes_per_thread );
+    T sum = 0;
+    for (int i = 1; i <= L; i++)
+      sum += plane_sum[i];
+    return L > 0 ? std::sqrt( sum / (T(L) * L * L) ) : 0;
+  }
+
+  // Restrict fine values r into the source of level l + 1 with 27-point
+  // full weighting, the product of (1/4, 1/2, 1/4) in each direction
+  // around fine point (2I, 2J, 2K).
+  void restrict_to_coarse( unsigned int l, grid_type const & r )
+  {
+    level_type & coarse = levels_[l + 1];
+    int L2 = coarse.L;
+    grid_type & R = coarse.f;
+    team_.parallel_for( 1, L2 + 1, [&r, &R, L2](int I0, int I1) {
+	const T w[3] = { 0.25, 0.5, 0.25 };
+	for (int I = I0; I < I1; I++)
+	  for (int J = 1; J <= L2; J++) {
+	    T * RI = R.row(I, J);
+	    for (int K = 1; K <= L2; K++)
+	      RI[K] = 0;
+	    for (int a = 0; a < 3; a++)
+	      for (int b = 0; b < 3; b++) {
+		T const * rr = r.row(2 * I + a - 1, 2 * J + b - 1);
+		T wab = w[a] * w[b];
+		for (int K = 1; K <= L2; K++) {
+		  int k = 2 * K;
+		  RI[K] += wab * ( 0.25 * (rr[k - 1] + rr[k + 1]) + 0.5 * rr[k] );
+		}
+	      }
+	  }
+      }, min_planes_per_thread );
+  }
+
+  // Add u of level l + 1, trilinearly interpolated, to u of level l. Even
+  // fine indices lie on coarse index i/2, odd ones halfway between (i-1)/2
+  // and (i+1)/2; the coarse boundary values are zero.
+  void prolongate_add( unsigned int l )
+  {
+    grid_type & u = levels_[l].u;
+    grid_type const & V = levels_[l + 1].u;
+    int L = levels_[l].L;
+    team_.parallel_for( 1, L + 1, [&u, &V, L](int i0, int i1) {
+	for (int i = i0; i < i1; i++)
+	  for (int j = 1; j <= L; j++) {
+	    T * ui = u.row(i, j);
+	    T const * Vaa = V.row(i / 2, j / 2);
+	    T const * Vab = V.row(i / 2, (j + 1) / 2);
+	    T const * Vba = V.row((i + 1) / 2, j / 2);
+	    T const * Vbb = V.row((i + 1) / 2, (j + 1) / 2);
+	    for (int k = 1; k <= L; k++) {
+	      int ka = k / 2, kb = (k + 1) / 2;
+	      ui[k] += 0.125 * ( Vaa[ka] + Vaa[kb] + Vab[ka] + Vab[kb] +
+				 Vba[ka] + Vba[kb] + Vbb[ka] + Vbb[kb] );
+	    }
+	  }
+      }, min_planes_per_thread );
+  }
+
+  void set_cycle_type( int type ) { cycle_type_ = type; }
+  void set_fmg( bool fmg ) { fmg_ = fmg; }
+  void set_max_cycles( unsigned int n ) { max_cycles_ = n; }
+  void set_verbose( bool v ) { verbose_ = v; }
+
+  std::vector<T> const & get_residuals() const { return residuals_; }
+  std::vector<T> const & get_convergence_factors() const { return factors_; }
+
+  // copies of the grids as nested vectors, e.g. for numpy through SWIG
+  cube_type get_psi() const { return to_cube( psi() ); }
+  cube_type get_rho() const { return to_cube( rho() ); }
+
+  T get_psi    ( int i, int j, int k) const { return psi()(i, j, k); }
+
+  // psi with the boundary as a binary field file, like in poisson_mg
+  bool write_psi( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
+  {
+    field_header h( dtype );
+    h.spacing[0] = h.spacing[1] = h.spacing[2] = h_;
+    return write_field( file, psi(), 0, 0, 0, L_+2, L_+2, L_+2, h, FIELD_MMAP, preview );
+  }
+  T get_rho    ( int i, int j, int k) const { return rho()(i, j, k); }
+
+  void set_psi    ( int i, int j, int k, T f) { psi()(i, j, k) = f; }
+  void set_rho    ( int i, int j, int k, T f) { rho()(i, j, k) = f; }
+
+  T get_h () const { return h_;}
+  int get_L () const { return L_;}
+  unsigned int    get_steps() const { return steps_; }
+  unsigned int    get_n_levels() const { return levels_.size(); }
+  int get_n_threads() const { return team_.size(); }
+  level_type & get_level( unsigned int l ) { return levels_[l]; }
+
+  void inc_steps() { ++steps_;}
+protected :
+
+  void record_cycle() {
+    inc_steps();
+    residuals_.push_back( residual_norm( 0 ) );
+    factors_.push_back( residuals_[residuals_.size() - 2] > 0 ?
+			residuals_.back() / residuals_[residuals_.size() - 2] : 0 );
+    if ( verbose_ )
+      std::cout << "cycle " << steps_ << "  residual " << residuals_.back()
+		<< "  factor " << factors_.back() << std::endl;
+  }
+
+  static cube_type to_cube( grid_type const & g ) {
+    cube_type c;
+    init_cube( c, g.nx(), g.ny(), g.nz() );
+    for ( int i = 0; i < g.nx(); ++i )
+      for ( int j = 0; j < g.ny(); ++j )
+	for ( int k = 0; k < g.nz(); ++k )
+	  c[i][j][k] = g(i, j, k);
+    return c;
+  }
+
+  grid_type       & psi()       { return levels_[0].u; }
+  grid_type const & psi() const { return levels_[0].u; }
+  grid_type       & rho()       { return levels_[0].f; }
+  grid_type const & rho() const { return levels_[0].f; }
+
+  T accuracy_;        // residual reduction at which execute() stops
+  int L_;             // number of interior points in each dimension
+  int n_smooth_;      // number of pre and post smoothing iterations
+
+  std::vector<level_type> levels_;  // level 0 holds psi and rho
+
+  T h_;               // step size
+  unsigned int steps_;// number of iteration steps
+
+  thread_team team_;  // threads sharing the planes of each sweep
+
+  int cycle_type_ = V_CYCLE;        // V, W or F cycles
+  bool fmg_ = true;                 // start from full multigrid
+  unsigned int max_cycles_ = 100;   // give up after this many cycles
+  bool verbose_ = true;             // print the residual after each cycle
+  std::vector<T> residuals_;        // RMS residual history
+  std::vector<T> factors_;          // convergence factor per cycle
+  static const int min_planes_per_thread = 4; // coarse levels run serially
+  static const int coarsest_sweeps = 20;      // relaxation on a coarsest level with L > 1
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "poisson_mg_var.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+using namespace std;
+
+typedef poisson_mg_var<double> solver_type;
+const double pi = 4 * atan(1.0);
+
+// Solve on nx x ny cells of a 1 x ny/nx rectangle and return the largest
+// deviation from psi_exact. A zero rho and eps mean 1; the Dirichlet
+// ghost values are taken from psi_exact on the boundary faces.
+template< typename Rho, typename Eps, typename Psi >
+double solve(int nx, int ny, int bc_x, int bc_y, Rho rho, Eps eps, Psi psi_exact,
+	     int cycle_type, int n_threads, unsigned int & cycles, double & factor)
+{
+  solver_type::matrix_type none;
+  double h = 1.0 / nx;
+  solver_type pmg(none, none, nx, ny, h, 1e-10, 2, n_threads);
+  pmg.set_verbose(false);
+  pmg.set_cycle_type(cycle_type);
+  pmg.set_boundary(solver_type::WEST, bc_x);
+  pmg.set_boundary(solver_type::EAST, bc_x);
+  pmg.set_boundary(solver_type::SOUTH, bc_y);
+  pmg.set_boundary(solver_type::NORTH, bc_y);
+  for (int i = 1; i <= nx; i++)
+    for (int j = 1; j <= ny; j++) {
+      pmg.set_rho(i, j, rho(pmg.get_x(i), pmg.get_x(j)));
+      pmg.set_eps(i, j, eps(pmg.get_x(i), pmg.get_x(j)));
+    }
+  if (bc_x == solver_type::DIRICHLET)
+    for (int j = 1; j <= ny; j++) {
+      pmg.set_psi(0, j, psi_exact(0, pmg.get_x(j)));
+      pmg.set_psi(nx + 1, j, psi_exact(nx * h, pmg.get_x(j)));
+    }
+  if (bc_y == solver_type::DIRICHLET)
+    for (int i = 1; i <= nx; i++) {
+      pmg.set_psi(i, 0, psi_exact(pmg.get_x(i), 0));
+      pmg.set_psi(i, ny + 1, psi_exact(pmg.get_x(i), ny * h));
+    }
+
+  pmg.execute();
+
+  double err = 0;
+  for (int i = 1; i <= nx; i++)
+    for (int j = 1; j <= ny; j++)
+      err = max(err, fabs(pmg.get_psi(i, j) - psi_exact(pmg.get_x(i), pmg.get_x(j))));
+  cycles = pmg.get_steps();
+  vector<double> const & q = pmg.get_convergence_factors();
+  factor = q.size() > 1 ? q[q.size() / 2] : 0;
+  return err;
+}
+
+// Run one case at two resolutions and check that the error drops by the
+// ratio expected (4 for smooth solutions, anything for exact ones) and
+// that the V-cycles converge like multigrid, by 0.3 or better per cycle
+template< typename Rho, typename Eps, typename Psi >
+bool check(char const * name, int nx, int ny, int bc_x, int bc_y, Rho rho, Eps eps,
+	   Psi psi_exact, double max_error, int n_threads)
+{
+  bool ok = true;
+  double err_prev = 0;
+  for (int k = 0; k < 2; k++) {
+    unsigned int cycles;
+    double factor;
+    auto t0 = chrono::steady_clock::now();
+    double err = solve(nx << k, ny << k, bc_x, bc_y, rho, eps, psi_exact,
+		       solver_type::V_CYCLE, n_threads, cycles, factor);
+    auto t1 = chrono::steady_clock::now();
+    cout << setw(22) << name << setw(6) << (nx << k) << " x" << setw(5) << (ny << k)
+	 << setw(8) << cycles << setw(12) << factor
+	 << setw(11) << chrono::duration<double>(t1 - t0).count()
+	 << setw(14) << err << endl;
+    if (err > max_error / (1 << 2 * k) || factor > 0.3)
+      ok = false;
+    if (k > 0 && max_error > 1e-8 && err_prev / err < 3.5)
+      ok = false;
+    err_prev = err;
+  }
+  return ok;
+}
+
+//   usage: poisson_mg_var [nx] [threads]
+int main(int argc, char * argv[])
+{
+  int nx = argc > 1 ? atoi(argv[1]) : 256;
+  int n_threads = argc > 2 ? atoi(argv[2]) : 1;
+  int ny = nx / 2;
+  double Ly = 0.5;
+  auto one = [](double, double) { return 1.0; };
+  bool ok = true;
+
+  cout << "                  case    nx x   ny  cycles      factor    time(s)     max error" << endl;
+
+  // Dirichlet on all sides, rectangle
+  auto psi_dd = [Ly](double x, double y) { return sin(pi * x) * sin(pi * y / Ly); };
+  auto rho_dd = [Ly, psi_dd](double x, double y) {
+    return pi * pi * (1 + 1 / (Ly * Ly)) * psi_dd(x, y); };
+  ok &= check("dirichlet", nx, ny, solver_type::DIRICHLET, solver_type::DIRICHLET,
+	      rho_dd, one, psi_dd, 4.0 / (nx * nx), n_threads);
+
+  // odd sizes: 125 cells coarsen to 63 with a narrow last cell, and so
+  // on down to 2 x 1 cells
+  ok &= check("dirichlet, odd", 250, 125, solver_type::DIRICHLET, solver_type::DIRICHLET,
+	      rho_dd, one, psi_dd, 4.0 / (250 * 250), n_threads);
+
+  // Neumann in x, Dirichlet in y
+  auto psi_nd = [Ly](double x, double y) { return cos(pi * x) * sin(pi * y / Ly); };
+  auto rho_nd = [Ly, psi_nd](double x, double y) {
+    return pi * pi * (1 + 1 / (Ly * Ly)) * psi_nd(x, y); };
+  ok &= check("neumann/dirichlet", nx, ny, solver_type::NEUMANN, solver_type::DIRICHLET,
+	      rho_nd, one, psi_nd, 4.0 / (nx * nx), n_threads);
+
+  // periodic in both directions, defined up to a constant
+  auto psi_pp = [Ly](double x, double y) { return sin(2 * pi * x) * cos(2 * pi * y / Ly); };
+  auto rho_pp = [Ly, psi_pp](double x, double y) {
+    return 4 * pi * pi * (1 + 1 / (Ly * Ly)) * psi_pp(x, y); };
+  ok &= check("periodic", nx, ny, solver_type::PERIODIC, solver_type::PERIODIC,
+	      rho_pp, one, psi_pp, 16.0 / (nx * nx), n_threads);
+
+  // dielectric slab: eps jumps by 20 at x = 1/2, psi = 0 and 1 on the
+  // left and right sides; psi is linear in each half and the discrete
+  // solution is exact
+  double e1 = 1, e2 = 20, a = 0.5;
+  double D = 1 / (a / e1 + (1 - a) / e2);
+  auto eps_slab = [e1, e2, a](double x, double) { return x < a ? e1 : e2; };
+  auto psi_slab = [e1, e2, a, D](double x, double) {
+    return x < a ? D * x / e1 : D * (a / e1 + (x - a) / e2); };
+  auto zero = [](double, double) { return 0.0; };
+  ok &= check("dielectric slab", nx, ny, solver_type::DIRICHLET, solver_type::NEUMANN,
+	      zero, eps_slab, psi_slab, 1e-8, n_threads);
+
+  // periodic in x, Dirichlet in y, eps jumps by 1000 across an inclusion
+  // that is not aligned with the coarse grids; only the convergence is
+  // checked. The averaged coarse coefficients leave V-cycles several times
+  // slower than W-cycles (about 0.5 against 0.03 per cycle), so each type
+  // has its own bound.
+  auto eps_box = [Ly](double x, double y) {
+    return fabs(x - 0.5) < 0.2 && fabs(y - 0.5 * Ly) < 0.1 ? 1000.0 : 1.0; };
+  auto rho_box = [Ly](double x, double y) { return sin(2 * pi * x) + y / Ly; };
+  char const * names[2] = { "inclusion V-cycle", "inclusion W-cycle" };
+  double max_factor[2] = { 0.6, 0.1 };
+  for (int type = solver_type::V_CYCLE; type <= solver_type::W_CYCLE; type++) {
+    unsigned int cycles;
+    double factor;
+    auto t0 = chrono::steady_clock::now();
+    solve(nx, ny, solver_type::PERIODIC, solver_type::DIRICHLET, rho_box, eps_box,
+	  zero, type, n_threads, cycles, factor);
+    auto t1 = chrono::steady_clock::now();
+    cout << setw(22) << names[type] << setw(6) << nx << " x" << setw(5) << ny
+	 << setw(8) << cycles << setw(12) << factor
+	 << setw(11) << chrono::duration<double>(t1 - t0).count() << endl;
+    if (factor > max_factor[type])
+      ok = false;
+  }
+
+  if (!ok) {
+    cout << " poisson_mg_var failed" << endl;
+    return EXIT_FAILURE;
+  }
+  cout << " all cases converged to the expected accuracy and rate" << endl;
+}
@@ -0,0 +1,717 @@
+#ifndef poisson_mg_var_h
+#define poisson_mg_var_h
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+#include "mg_pcg.h"
+
+// Multigrid solver for div(eps grad psi) = -rho on a rectangle of
+// nx x ny square cells of size h, with Dirichlet, Neumann or periodic
+// boundaries on each side.
+//
+// Unlike poisson_mg the grid is cell centred: psi, rho and eps live at
+// cell centres (i, j), 1 <= i <= nx, 1 <= j <= ny, and the boundaries
+// run along the faces between the ghost layer and the first cells. The
+// coefficient on a face between two cells is the harmonic mean of their
+// eps; boundary conditions are folded into the boundary face
+// coefficients (2 eps for Dirichlet, 0 for Neumann). Coarse levels have
+// (nx+1)/2 x (ny+1)/2 cells of size 2h, and a coarse face gets the
+// average of the two fine face coefficients it covers. An odd number of
+// cells along a Dirichlet or Neumann axis still coarsens: the last coarse
+// cell then covers a single fine cell and is narrower than the others, so
+// the coarse domain keeps the fine one's size. The coarse equations are
+// integrated over the cells (sources summed, not averaged, and face
+// coefficients scaled by face length over centre distance), which keeps
+// them symmetric. A periodic axis with an odd number of cells cannot be
+// coarsened this way, so coarsening stops there (e.g. 255 periodic cells
+// give a single level), as it does when an axis is down to one cell.
+// Transfers are 2x2 cell averaging and bilinear interpolation. The
+// coarsest level is solved by conjugate gradients with a Jacobi
+// preconditioner, O(m^3) for m x m cells rather than the O(m^4) of
+// relaxing it to convergence.
+//
+// Dirichlet values are taken from the ghost cells of psi (zero unless
+// set with set_psi), Neumann boundaries have zero normal derivative.
+// Without any Dirichlet side psi is only fixed up to a constant: the
+// mean of rho is removed and psi is kept at zero mean.
+template< typename T>
+class poisson_mg_var {
+public :
+
+  typedef std::vector< std::vector<T> > matrix_type;
+  typedef grid2d<T> grid_type;
+
+  enum { WEST = 0, EAST, SOUTH, NORTH };          // sides x = 0, x = nx h, y = 0, y = ny h
+  enum { DIRICHLET = 0, NEUMANN, PERIODIC };      // boundary conditions
+
+  // one level of the multigrid hierarchy, allocated before solving
+  struct level_type {
+    int nx, ny;           // number of cells in x and y
+    T h;                  // cell size
+    grid_type u;          // solution (level 0) or correction (coarser levels)
+    grid_type f;          // source (level 0) or restricted residual
+    grid_type r;          // residual
+    grid_type ax;         // coefficient on the face between cells (i-1, j) and (i, j)
+    grid_type ay;         // coefficient on the face between cells (i, j-1) and (i, j)
+    grid_type d;          // inverse of the diagonal of the operator
+    T wx, wy;             // width of the last cell in x and y, in units of h
+  };
+
+  // rho_in and eps_in are (nx+2) x (ny+2) like psi and may be smaller or
+  // empty; missing rho is zero and missing eps is one
+  poisson_mg_var( matrix_type const & rho_in, matrix_type const & eps_in,
+		  int inx = 64, int iny = 64, T ih = 1. / 64, T iaccuracy = 0.001,
+		  int in_smooth = 3, int in_threads = 1 ) :
+    accuracy_(iaccuracy), nx_(inx), ny_(iny), h_(ih), n_smooth_(in_smooth), team_(in_threads)
+  {
+    for (int s = 0; s < 4; s++)
+      bc_[s] = DIRICHLET;
+
+    add_level( nx_, ny_, h_, 1, 1 );
+    build_levels();
+
+    eps_.resize( nx_+2, ny_+2 );
+    eps_.fill( 1 );
+    for ( unsigned int i = 0; i < rho_in.size() && i < static_cast<unsigned int>(nx_+2); ++i )
+      for ( unsigned int j = 0; j < rho_in[i].size() && j < static_cast<unsigned int>(ny_+2); ++j )
+	levels_[0].f(i, j) = rho_in[i][j];
+    for ( unsigned int i = 0; i < eps_in.size() && i < static_cast<unsigned int>(nx_+2); ++i )
+      for ( unsigned int j = 0; j < eps_in[i].size() && j < static_cast<unsigned int>(ny_+2); ++j )
+	eps_(i, j) = eps_in[i][j];
+
+    coefficients_ready_ = false;
+    steps_ = 0;
+  }
+
+  static void init_matrix( matrix_type & matrix, unsigned int N, unsigned int M) {
+    matrix.resize( N );
+    for ( auto i = matrix.begin(); i != matrix.end(); ++i ) {
+      i->resize(M);
+    }
+  }
+
+  // Set the condition on one side; PERIODIC always applies to both sides
+  // of its axis, and leaving PERIODIC resets the opposite side too.
+  void set_boundary( int side, int type ) {
+    int other = side ^ 1;
+    if ( type == PERIODIC || bc_[other] == PERIODIC )
+      bc_[other] = type;
+    bc_[side] = type;
+    coefficients_ready_ = false;
+  }
+  int get_boundary( int side ) const { return bc_[side]; }
+
+  // true if psi is only determined up to a constant
+  bool is_singular() const {
+    for (int s = 0; s < 4; s++)
+      if ( bc_[s] == DIRICHLET )
+	return false;
+    return true;
+  }
+
+  // Face coefficients of all levels from eps and the boundary conditions;
+  // a coarse face covers two fine faces and gets their average. The fine
+  // coefficients are divided by their inverse centre distance and the
+  // coarse ones multiplied by theirs, which matters only next to a narrow
+  // last cell; a fine face beyond the last fine cell counts as zero.
+  void setup_coefficients()
+  {
+    build_levels();
+    set_faces( levels_[0], eps_ );
+    set_diagonal( levels_[0] );
+    for ( unsigned int l = 1; l < levels_.size(); ++l ) {
+      level_type const & fine = levels_[l - 1];
+      level_type & coarse = levels_[l];
+      bool px = bc_[WEST] == PERIODIC, py = bc_[SOUTH] == PERIODIC;
+      for (int I = 1; I <= coarse.nx + 1; I++) {
+	int i = std::min( 2 * I - 1, fine.nx + 1 );
+	T g = face_factor( I, coarse.nx, coarse.wx, px ) / face_factor( i, fine.nx, fine.wx, px );
+	for (int J = 1; J <= coarse.ny; J++) {
+	  T a = fine.ax(i, 2 * J - 1) + ( 2 * J <= fine.ny ? fine.ax(i, 2 * J) : 0 );
+	  coarse.ax(I, J) = 0.5 * g * a;
+	}
+      }
+      for (int J = 1; J <= coarse.ny + 1; J++) {
+	int j = std::min( 2 * J - 1, fine.ny + 1 );
+	T g = face_factor( J, coarse.ny, coarse.wy, py ) / face_factor( j, fine.ny, fine.wy, py );
+	for (int I = 1; I <= coarse.nx; I++) {
+	  T a = fine.ay(2 * I - 1, j) + ( 2 * I <= fine.nx ? fine.ay(2 * I, j) : 0 );
+	  coarse.ay(I, J) = 0.5 * g * a;
+	}
+      }
+      set_diagonal( coarse );
+    }
+    coefficients_ready_ = true;
+  }
+
+
+  // Red-black Gauss-Seidel sweep; rows of one colour are split across the
+  // thread team. Periodic ghost cells are refreshed before each colour;
+  // reverse does black first.
+  void Gauss_Seidel( level_type & lev, bool reverse = false )
+  {
+    int nx = lev.nx, ny = lev.ny;
+    T h2 = lev.h * lev.h;
+    grid_type & u = lev.u;
+    grid_type const & f = lev.f;
+    grid_type const & ax = lev.ax;
+    grid_type const & ay = lev.ay;
+    grid_type const & d = lev.d;
+
+    for (int c = 0; c < 2; c++) {
+      int color = reverse ? 1 - c : c;
+      fill_periodic( lev );
+      team_.parallel_for( 1, nx + 1, [&, h2, ny, color](int i0, int i1) {
+	  for (int i = i0; i < i1; i++)
+	    Gauss_Seidel_row( u.row(i), u.row(i - 1), u.row(i + 1), f.row(i),
+			      ax.row(i), ax.row(i + 1), ay.row(i), d.row(i),
+			      h2, 2 - (i + color) % 2, ny );
+	}, min_rows_per_thread );
+    }
+  }
+
+  // update points j0, j0 + 2, ... <= ny of one row
+  static void Gauss_Seidel_row( T * __restrict ui, T const * __restrict um, T const * __restrict up,
+				T const * __restrict fi, T const * __restrict axm,
+				T const * __restrict axp, T const * __restrict ayi,
+				T const * __restrict di, T h2, int j0, int ny )
+  {
+    for (int j = j0; j <= ny; j += 2)
+      ui[j] = di[j] * ( axm[j] * um[j] + axp[j] * up[j] +
+			ayi[j] * ui[j - 1] + ayi[j + 1] * ui[j + 1] +
+			h2 * fi[j] );
+  }
+
+
+  enum { V_CYCLE = 0, W_CYCLE, F_CYCLE };
+
+  // Solve until the RMS residual drops below accuracy times its initial
+  // value, stops decreasing, or max_cycles cycles have been done.
+  void execute(){
+    if ( !coefficients_ready_ )
+      setup_coefficients();
+    if ( is_singular() )
+      remove_mean( levels_[0], levels_[0].f );
+
+    if ( krylov_ ) {
+      mg_pcg< poisson_mg_var<T> > pcg( *this );
+      steps_ += pcg.solve( accuracy_, max_cycles_, residuals_, factors_, verbose_ );
+      if ( is_singular() )
+	remove_mean( levels_[0], psi() );
+      return;
+    }
+
+    T r0 = residual_norm( 0 );
+    residuals_.assign( 1, r0 );
+    factors_.clear();
+    if ( r0 == 0 )
+      return;
+
+    if ( fmg_ && levels_.size() > 1 ) {
+      full_multigrid();
+      record_cycle();
+    }
+    while ( residuals_.back() > accuracy_ * r0 && steps_ < max_cycles_ ){
+      cycle( 0, cycle_type_ );
+      record_cycle();
+      if ( factors_.size() > 1 && factors_.back() >= 1 )
+	break;
+    }
+  }
+
+  // One multigrid cycle at level l, as in poisson_mg::cycle
+  void cycle( unsigned int l, int type )
+  {
+    level_type & lev = levels_[l];
+
+    if ( l + 1 == levels_.size() ) {
+      coarsest_solve( l );
+      return;
+    }
+
+    for (int i = 0; i < n_smooth_; i++)
+      Gauss_Seidel( lev );
+
+    compute_residual( l );
+    restrict_to_coarse( l, lev.r );
+    levels_[l + 1].u.fill( 0 );
+    switch ( type ) {
+    case W_CYCLE :
+      cycle( l + 1, W_CYCLE );
+      cycle( l + 1, W_CYCLE );
+      break;
+    case F_CYCLE :
+      cycle( l + 1, F_CYCLE );
+      cycle( l + 1, V_CYCLE );
+      break;
+    default :
+      cycle( l + 1, V_CYCLE );
+    }
+    prolongate_add( l );
+
+    for (int i = 0; i < n_smooth_; i++)
+      Gauss_Seidel( lev, symmetric_ );
+  }
+
+  // full multigrid for the correction to psi, as in poisson_mg
+  void full_multigrid()
+  {
+    compute_residual( 0 );
+    restrict_to_coarse( 0, levels_[0].r );
+    for ( unsigned int l = 1; l + 1 < levels_.size(); ++l )
+      restrict_to_coarse( l, levels_[l].f );
+
+    unsigned int coarsest = levels_.size() - 1;
+    levels_[coarsest].u.fill( 0 );
+    cycle( coarsest, V_CYCLE );
+    for ( unsigned int l = coarsest - 1; l >= 1; --l ) {
+      levels_[l].u.fill( 0 );
+      prolongate_add( l );
+      cycle( l, cycle_type_ );
+    }
+    prolongate_add( 0 );
+  }
+
+  // r = f + div(eps grad u) on level l
+  void compute_residual( unsigned int l )
+  {
+    level_type & lev = levels_[l];
+    fill_periodic( lev );
+    grid_type const & u = lev.u;
+    grid_type const & f = lev.f;
+    grid_type const & ax = lev.ax;
+    grid_type const & ay = lev.ay;
+    grid_type & r = lev.r;
+    int ny = lev.ny;
+    T inv_h2 = 1 / (lev.h * lev.h);
+    team_.parallel_for( 1, lev.nx + 1, [&, inv_h2, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * ui = u.row(i);
+	  T const * um = u.row(i - 1);
+	  T const * up = u.row(i + 1);
+	  T const * fi = f.row(i);
+	  T const * axm = ax.row(i);
+	  T const * axp = ax.row(i + 1);
+	  T const * ayi = ay.row(i);
+	  T * ri = r.row(i);
+	  for (int j = 1; j <= ny; j++)
+	    ri[j] = fi[j] +
+	      ( axp[j] * (up[j] - ui[j]) + axm[j] * (um[j] - ui[j]) +
+		ayi[j + 1] * (ui[j + 1] - ui[j]) + ayi[j] * (ui[j - 1] - ui[j]) ) * inv_h2;
+	}
+      }, min_rows_per_thread );
+  }
+
+  // Solve the coarsest level l by Jacobi-preconditioned conjugate
+  // gradients for the correction to u, until the residual has dropped by
+  // coarsest_reduction; a tight reduction keeps the V-cycle nearly linear
+  // for mg_pcg. Scratch grids are allocated on first use.
+  void coarsest_solve( unsigned int l )
+  {
+    level_type & lev = levels_[l];
+    bool singular = is_singular();
+    if ( singular )
+      remove_mean( lev, lev.f );
+    if ( cg_p_.nx() != lev.nx + 2 || cg_p_.ny() != lev.ny + 2 ) {
+      cg_p_.resize( lev.nx + 2, lev.ny + 2 );
+      cg_q_.resize( lev.nx + 2, lev.ny + 2 );
+      cg_z_.resize( lev.nx + 2, lev.ny + 2 );
+    }
+    compute_residual( l );
+    grid_type & r = lev.r;
+    if ( singular )
+      remove_mean( lev, r );
+    T h2 = lev.h * lev.h;
+    auto jacobi = [&]() {
+      for (int i = 1; i <= lev.nx; i++)
+	for (int j = 1; j <= lev.ny; j++)
+	  cg_z_(i, j) = lev.d(i, j) * h2 * r(i, j);
+    };
+    auto dot = [&]( grid_type const & a, grid_type const & b ) {
+      T sum = 0;
+      for (int i = 1; i <= lev.nx; i++)
+	for (int j = 1; j <= lev.ny; j++)
+	  sum += a(i, j) * b(i, j);
+      return sum;
+    };
+
+    jacobi();
+    cg_p_.fill( 0 );
+    for (int i = 1; i <= lev.nx; i++)
+      for (int j = 1; j <= lev.ny; j++)
+	cg_p_(i, j) = cg_z_(i, j);
+    T rz = dot( r, cg_z_ );
+    T r0 = std::sqrt( dot( r, r ) );
+    int max_iterations = 2 * lev.nx * lev.ny + 10;
+    for (int k = 0; k < max_iterations && r0 > 0; k++) {
+      apply_operator( cg_p_, cg_q_, l );
+      T pq = dot( cg_p_, cg_q_ );
+      if ( pq <= 0 )
+	break;
+      T alpha = rz / pq;
+      for (int i = 1; i <= lev.nx; i++)
+	for (int j = 1; j <= lev.ny; j++) {
+	  lev.u(i, j) += alpha * cg_p_(i, j);
+	  r(i, j) -= alpha * cg_q_(i, j);
+	}
+      if ( std::sqrt( dot( r, r ) ) <= coarsest_reduction * r0 )
+	break;
+      jacobi();
+      T rz_new = dot( r, cg_z_ );
+      T beta = rz_new / rz;
+      rz = rz_new;
+      for (int i = 1; i <= lev.nx; i++)
+	for (int j = 1; j <= lev.ny; j++)
+	  cg_p_(i, j) = cg_z_(i, j) + beta * cg_p_(i, j);
+    }
+    if ( singular )
+      remove_mean( lev, lev.u );
+  }
+
+  // y = -div(eps grad x) on level l, with homogeneous boundary conditions
+  void apply_operator( grid_type & x, grid_type & y, unsigned int l = 0 )
+  {
+    level_type const & lev = levels_[l];
+    fill_periodic( x, lev.nx, lev.ny );
+    grid_type const & ax = lev.ax;
+    grid_type const & ay = lev.ay;
+    int ny = lev.ny;
+    T inv_h2 = 1 / (lev.h * lev.h);
+    team_.parallel_for( 1, lev.nx + 1, [&, inv_h2, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++) {
+	  T const * __restrict xi = x.row(i);
+	  T const * __restrict xm = x.row(i - 1);
+	  T const * __restrict xp = x.row(i + 1);
+	  T const * __restrict axm = ax.row(i);
+	  T const * __restrict axp = ax.row(i + 1);
+	  T const * __restrict ayi = ay.row(i);
+	  T * __restrict yi = y.row(i);
+	  for (int j = 1; j <= ny; j++)
+	    yi[j] = ( axp[j] * (xi[j] - xp[j]) + axm[j] * (xi[j] - xm[j]) +
+		      ayi[j + 1] * (xi[j] - xi[j + 1]) + ayi[j] * (xi[j] - xi[j - 1]) ) * inv_h2;
+	}
+      }, min_rows_per_thread );
+  }
+
+  // z = one V-cycle for -div(eps grad z) = r from z = 0, run on the level
+  // 0 grids with psi and rho swapped out
+  void precondition( grid_type & r, grid_type & z )
+  {
+    z.fill( 0 );
+    std::swap( levels_[0].u, z );
+    std::swap( levels_[0].f, r );
+    symmetric_ = true;
+    cycle( 0, V_CYCLE );
+    symmetric_ = false;
+    std::swap( levels_[0].u, z );
+    std::swap( levels_[0].f, r );
+    if ( is_singular() )
+      remove_mean( levels_[0], z );
+  }
+
+  // RMS of the residual over the cells of level l
+  T residual_norm( unsigned int l )
+  {
+    compute_residual( l );
+    level_type const & lev = levels_[l];
+    T sum = 0;
+    for (int i = 1; i <= lev.nx; i++) {
+      T const * ri = lev.r.row(i);
+      for (int j = 1; j <= lev.ny; j++)
+	sum += ri[j] * ri[j];
+    }
+    return std::sqrt( sum / (T(lev.nx) * lev.ny) );
+  }
+
+  // average fine values r over the four cells of each coarse cell; a
+  // narrow last coarse cell has only one or two fine cells, and the
+  // missing ones count as zero
+  void restrict_to_coarse( unsigned int l, grid_type const & r )
+  {
+    level_type & coarse = levels_[l + 1];
+    int nx = levels_[l].nx, ny = levels_[l].ny, ny2 = coarse.ny;
+    grid_type & R = coarse.f;
+    team_.parallel_for( 1, coarse.nx + 1, [&r, &R, nx, ny, ny2](int I0, int I1) {
+	for (int I = I0; I < I1; I++) {
+	  T const * r0 = r.row(2 * I - 1);
+	  T const * r1 = r.row(2 * I);
+	  T s1 = 2 * I <= nx ? 1 : 0;
+	  T * RI = R.row(I);
+	  for (int J = 1; J <= ny2; J++) {
+	    int j = 2 * J - 1;
+	    T sj = j < ny ? 1 : 0;
+	    RI[J] = 0.25 * ( r0[j] + sj * r0[j + 1] + s1 * ( r1[j] + sj * r1[j + 1] ) );
+	  }
+	}
+      }, min_rows_per_thread );
+  }
+
+  // Add u of level l + 1, bilinearly interpolated, to u of level l. A fine
+  // cell takes 3/4 of its parent and 1/4 of the next coarse cell in each
+  // direction; past the boundary that cell is the mirror image (Neumann),
+  // the negative mirror image (Dirichlet) or the periodic image.
+  void prolongate_add( unsigned int l )
+  {
+    grid_type & u = levels_[l].u;
+    grid_type const & V = levels_[l + 1].u;
+    int nx2 = levels_[l + 1].nx;
+    int ny = levels_[l].ny, ny2 = levels_[l + 1].ny;
+    int const * bc = bc_;
+    team_.parallel_for( 1, levels_[l].nx + 1, [&u, &V, nx2, ny, ny2, bc](int i0, int i1) {
+	std::vector<T> t( ny2 + 2 );
+	for (int i = i0; i < i1; i++) {
+	  int I = (i + 1) / 2;
+	  int I2 = i % 2 ? I - 1 : I + 1;
+	  T const * VI = V.row(I);
+	  T const * VI2 = V.row(I2);
+	  T s = 1;
+	  if ( I2 < 1 || I2 > nx2 ) {
+	    int type = bc[ I2 < 1 ? WEST : EAST ];
+	    if ( type == PERIODIC )
+	      VI2 = V.row( I2 < 1 ? nx2 : 1 );
+	    else {
+	      VI2 = VI;
+	      s = type == DIRICHLET ? -1 : 1;
+	    }
+	  }
+	  for (int J = 1; J <= ny2; J++)
+	    t[J] = 0.75 * VI[J] + 0.25 * s * VI2[J];
+	  t[0] = bc[SOUTH] == PERIODIC ? t[ny2] : bc[SOUTH] == NEUMANN ? t[1] : -t[1];
+	  t[ny2 + 1] = bc[NORTH] == PERIODIC ? t[1] : bc[NORTH] == NEUMANN ? t[ny2] : -t[ny2];
+
+	  T * ui = u.row(i);
+	  for (int j = 1; j <= ny; j++) {
+	    int J = (j + 1) / 2;
+	    int J2 = j % 2 ? J - 1 : J + 1;
+	    ui[j] += 0.75 * t[J] + 0.25 * t[J2];
+	  }
+	}
+      }, min_rows_per_thread );
+  }
+
+  // Krylov mode: execute() runs conjugate gradients with one V-cycle
+  // as the preconditioner, which copes better with rough problems
+  void set_krylov( bool krylov ) { krylov_ = krylov; }
+  void set_cycle_type( int type ) { cycle_type_ = type; }
+  void set_fmg( bool fmg ) { fmg_ = fmg; }
+  void set_max_cycles( unsigned int n ) { max_cycles_ = n; }
+  void set_verbose( bool v ) { verbose_ = v; }
+
+  std::vector<T> const & get_residuals() const { return residuals_; }
+  std::vector<T> const & get_convergence_factors() const { return factors_; }
+
+  // copies of the grids as nested vectors, e.g. for numpy through SWIG
+  matrix_type get_psi() const { return to_matrix( psi() ); }
+  matrix_type get_rho() const { return to_matrix( rho() ); }
+  matrix_type get_eps() const { return to_matrix( eps_ ); }
+
+  T get_psi    ( int i, int j) const { return psi()(i, j); }
+
+  // psi in the nx x ny cells, the first centre at (h/2, h/2), as a binary
+  // field file (field_io.h)
+  bool write_psi( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
+  {
+    field_header h( dtype );
+    h.spacing[0] = h.spacing[1] = h_;
+    h.origin[0] = h.origin[1] = 0.5 * h_;
+    return write_field( file, psi(), 1, 1, nx_, ny_, h, FIELD_MMAP, preview );
+  }
+  T get_rho    ( int i, int j) const { return rho()(i, j); }
+  T get_eps    ( int i, int j) const { return eps_(i, j); }
+
+  void set_psi    ( int i, int j, T f) { psi()(i, j) = f; }
+  void set_rho    ( int i, int j, T f) { rho()(i, j) = f; }
+  void set_eps    ( int i, int j, T f) { eps_(i, j) = f; coefficients_ready_ = false; }
+
+  // position of the centre of cell i (or j)
+  T get_x ( int i ) const { return (i - 0.5) * h_; }
+
+  T get_h () const { return h_;}
+  int get_nx () const { return nx_;}
+  int get_ny () const { return ny_;}
+  unsigned int    get_steps() const { return steps_; }
+  unsigned int    get_n_levels() const { return levels_.size(); }
+  int get_n_threads() const { return team_.size(); }
+  thread_team & get_team() { return team_; }
+  level_type & get_level( unsigned int l ) { return levels_[l]; }
+
+  void inc_steps() { ++steps_;}
+protected :
+
+  static T harmonic( T a, T b ) { return a + b > 0 ? 2 * a * b / (a + b) : 0; }
+
+  // 1 over the distance between the centres on either side of face i of
+  // an axis of n cells whose last cell has width w, in cells; a boundary
+  // face is half a cell from its centre
+  static T face_factor( int i, int n, T w, bool periodic ) {
+    if ( periodic )
+      return 1;
+    T left = i > 1 ? ( i - 1 == n ? w : 1 ) : 0;
+    T right = i <= n ? ( i == n ? w : 1 ) : 0;
+    return 2 / ( left + right );
+  }
+
+  void add_level( int nx, int ny, T h, T wx, T wy ) {
+    levels_.push_back( level_type() );
+    level_type & lev = levels_.back();
+    lev.nx = nx;
+    lev.ny = ny;
+    lev.h = h;
+    lev.wx = wx;
+    lev.wy = wy;
+    lev.u.resize( nx+2, ny+2 );
+    lev.f.resize( nx+2, ny+2 );
+    lev.r.resize( nx+2, ny+2 );
+    lev.ax.resize( nx+2, ny+2 );
+    lev.ay.resize( nx+2, ny+2 );
+    lev.d.resize( nx+2, ny+2 );
+  }
+
+  // an axis of n cells can be halved if n is even, or odd, at least 3 and
+  // not periodic
+  bool coarsens( int n, int side ) const {
+    return n % 2 == 0 || ( n > 1 && bc_[side] != PERIODIC );
+  }
+
+  // Allocate the coarse levels below level 0; which odd sizes coarsen
+  // depends on the boundary conditions, so this is redone with them.
+  void build_levels() {
+    levels_.resize( 1 );
+    int nx = nx_, ny = ny_;
+    T h = h_, wx = 1, wy = 1;
+    while ( coarsens( nx, WEST ) && coarsens( ny, SOUTH ) ) {
+      wx = nx % 2 ? wx / 2 : (1 + wx) / 2;
+      wy = ny % 2 ? wy / 2 : (1 + wy) / 2;
+      nx = (nx + 1) / 2;
+      ny = (ny + 1) / 2;
+      h *= 2;
+      add_level( nx, ny, h, wx, wy );
+    }
+  }
+
+  // Coefficients on the faces between neighbouring cells of lev from the
+  // cell values e, and on the boundary faces from the boundary conditions
+  void set_faces( level_type & lev, grid_type const & e ) {
+    int nx = lev.nx, ny = lev.ny;
+    for (int i = 1; i <= nx + 1; i++)
+      for (int j = 1; j <= ny; j++) {
+	T a;
+	if ( i == 1 || i == nx + 1 ) {
+	  int side = i == 1 ? WEST : EAST;
+	  T inner = e(i == 1 ? 1 : nx, j);
+	  a = bc_[side] == DIRICHLET ? 2 * inner :
+	    bc_[side] == NEUMANN ? 0 : harmonic( e(nx, j), e(1, j) );
+	} else
+	  a = harmonic( e(i - 1, j), e(i, j) );
+	lev.ax(i, j) = a;
+      }
+    for (int i = 1; i <= nx; i++)
+      for (int j = 1; j <= ny + 1; j++) {
+	T a;
+	if ( j == 1 || j == ny + 1 ) {
+	  int side = j == 1 ? SOUTH : NORTH;
+	  T inner = e(i, j == 1 ? 1 : ny);
+	  a = bc_[side] == DIRICHLET ? 2 * inner :
+	    bc_[side] == NEUMANN ? 0 : harmonic( e(i, ny), e(i, 1) );
+	} else
+	  a = harmonic( e(i, j - 1), e(i, j) );
+	lev.ay(i, j) = a;
+      }
+  }
+
+  static void set_diagonal( level_type & lev ) {
+    for (int i = 1; i <= lev.nx; i++)
+      for (int j = 1; j <= lev.ny; j++) {
+	T sum = lev.ax(i, j) + lev.ax(i + 1, j) + lev.ay(i, j) + lev.ay(i, j + 1);
+	lev.d(i, j) = sum > 0 ? 1 / sum : 0;
+      }
+  }
+
+  void fill_periodic( level_type & lev ) { fill_periodic( lev.u, lev.nx, lev.ny ); }
+
+  // copy periodic images into the ghost cells of u
+  void fill_periodic( grid_type & u, int nx, int ny ) {
+    if ( bc_[WEST] == PERIODIC )
+      for (int j = 1; j <= ny; j++) {
+	u(0, j) = u(nx, j);
+	u(nx + 1, j) = u(1, j);
+      }
+    if ( bc_[SOUTH] == PERIODIC )
+      for (int i = 1; i <= nx; i++) {
+	u(i, 0) = u(i, ny);
+	u(i, ny + 1) = u(i, 1);
+      }
+  }
+
+  // subtract the mean over the cells of lev from g
+  static void remove_mean( level_type const & lev, grid_type & g ) {
+    T sum = 0;
+    for (int i = 1; i <= lev.nx; i++)
+      for (int j = 1; j <= lev.ny; j++)
+	sum += g(i, j);
+    T mean = sum / (T(lev.nx) * lev.ny);
+    for (int i = 1; i <= lev.nx; i++)
+      for (int j = 1; j <= lev.ny; j++)
+	g(i, j) -= mean;
+  }
+
+  void record_cycle() {
+    inc_steps();
+    if ( is_singular() )
+      remove_mean( levels_[0], psi() );
+    residuals_.push_back( residual_norm( 0 ) );
+    factors_.push_back( residuals_[residuals_.size() - 2] > 0 ?
+			residuals_.back() / residuals_[residuals_.size() - 2] : 0 );
+    if ( verbose_ )
+      std::cout << "cycle " << steps_ << "  residual " << residuals_.back()
+		<< "  factor " << factors_.back() << std::endl;
+  }
+
+  static matrix_type to_matrix( grid_type const & g ) {
+    matrix_type m;
+    init_matrix( m, g.nx(), g.ny() );
+    for ( int i = 0; i < g.nx(); ++i )
+      for ( int j = 0; j < g.ny(); ++j )
+	m[i][j] = g(i, j);
+    return m;
+  }
+
+  grid_type       & psi()       { return levels_[0].u; }
+  grid_type const & psi() const { return levels_[0].u; }
+  grid_type       & rho()       { return levels_[0].f; }
+  grid_type const & rho() const { return levels_[0].f; }
+
+  T accuracy_;        // residual reduction at which execute() stops
+  int nx_, ny_;       // number of cells in x and y
+  T h_;               // cell size
+  int n_smooth_;      // number of pre and post smoothing iterations
+
+  std::vector<level_type> levels_;  // level 0 holds psi and rho
+  grid_type eps_;                   // permittivity at the cell centres
+  int bc_[4];                       // boundary condition of each side
+  bool coefficients_ready_;         // face coefficients match eps_ and bc_
+
+  unsigned int steps_;// number of iteration steps
+
+  thread_team team_;  // threads sharing the rows of each sweep
+
+  int cycle_type_ = V_CYCLE;        // V, W or F cycles
+  bool fmg_ = true;                 // start from full multigrid
+  bool krylov_ = false;             // preconditioned CG instead of cycles
+  bool symmetric_ = false;          // post-smooth in reverse colour order
+  unsigned int max_cycles_ = 100;   // give up after this many cycles
+  bool verbose_ = true;             // print the residual after each cycle
+  std::vector<T> residuals_;        // RMS residual history
+  std::vector<T> factors_;          // convergence factor per cycle
+  grid_type cg_p_, cg_q_, cg_z_;    // conjugate gradient scratch on the coarsest level
+  static const int min_rows_per_thread = 32;  // coarse levels run serially
+  static constexpr double coarsest_reduction = 1e-10;   // of the coarsest level residual
+};
+
+#endif
@@ -0,0 +1,51 @@
+import sys
+import struct
+import numpy as np
+
+# Reader for the binary field files of field_io.h: a 128 byte
+# little-endian header followed by the raw values in C order.
+
+class FieldHeader :
+    def __init__(self, dtype, dims, spacing, origin, t) :
+        self.dtype = dtype          # numpy dtype of the values
+        self.dims = dims            # points along each dimension
+        self.spacing = spacing      # grid spacing along each dimension
+        self.origin = origin        # coordinates of the first point
+        self.t = t                  # time
+
+    def coordinates(self, d) :
+        return self.origin[d] + self.spacing[d] * np.arange(self.dims[d])
+
+    def __str__(self):
+        return 'dims %s  spacing %s  origin %s  t %g  %s' % (
+            self.dims, self.spacing, self.origin, self.t, self.dtype )
+
+def read_field_header(filename) :
+    with open(filename, 'rb') as file :
+        head = file.read(128)
+    if len(head) < 128 or head[0:8] != b'PDEFIELD' :
+        raise ValueError( filename + ' is not a field file' )
+    version, dtype, ndim, size = struct.unpack('<4I', head[8:24])
+    dims = struct.unpack('<3Q', head[24:48])[:ndim]
+    spacing = struct.unpack('<3d', head[48:72])[:ndim]
+    origin = struct.unpack('<3d', head[72:96])[:ndim]
+    t, = struct.unpack('<d', head[96:104])
+    return FieldHeader( np.dtype('<f4') if dtype == 0 else np.dtype('<f8'),
+                        dims, spacing, origin, t )
+
+# Returns the header and the values as an array of shape header.dims.
+# With mmap=True the array is a read-only view of the file, so only the
+# parts that are used get read.
+def read_field(filename, mmap=False) :
+    header = read_field_header(filename)
+    if mmap :
+        values = np.memmap(filename, dtype=header.dtype, mode='r', offset=128,
+                           shape=header.dims)
+    else :
+        values = np.fromfile(filename, dtype=header.dtype, offset=128).reshape(header.dims)
+    return header, values
+
+if __name__ == "__main__" :
+    for filename in sys.argv[1:] :
+        header, values = read_field(filename, mmap=True)
+        print( filename, header, ' min %g  max %g' % (values.min(), values.max()) )
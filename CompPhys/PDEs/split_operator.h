@@ -0,0 +1,271 @@
+// Split-operator time evolution of the Schroedinger equation on periodic grids
+#ifndef split_operator_h
+#define split_operator_h
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "fft.h"
+#include "field_io.h"
+#include "mg_grid.h"
+#include "thread_team.h"
+
+
+// Evolves
+//
+//   i dpsi/dt = -1/(2 m) laplacian(psi) + V psi      (hbar = 1)
+//
+// on a periodic box of n (1D) or nx x ny (2D) points, x = k dx, with the
+// second-order splitting of wavepacket.ipynb,
+//
+//   psi(t + dt) = exp(-i V dt/2) F^-1 exp(-i p^2 dt / 2m) F exp(-i V dt/2) psi(t).
+//
+// The scheme is unitary, so the norm is kept to round-off, and exact for
+// V = 0 when psi is resolved on the grid. evolve(n) merges the half
+// potential steps between consecutive steps into one and applies it
+// right after the inverse row transforms, so a 2D step makes one pass over
+// the rows for potential and transforms along y, plus the transforms
+// along x between two blocked transposes. Rows are split across the
+// thread team.
+template< typename T >
+class split_operator {
+public :
+
+  typedef std::complex<T> complex_type;
+  typedef std::vector<T> vector_type;
+  typedef std::vector< std::vector<T> > matrix_type;
+
+  // 1D: V holds the potential at the n points
+  split_operator( vector_type const & V, T dx, T dt, T mass = 1, int in_threads = 1 ) :
+    dim_(1), nx_(1), ny_(V.size()), dt_(dt), mass_(mass), t_(0), steps_(0),
+    fft_x_(1), fft_y_(V.size()), team_(in_threads)
+  {
+    h_[0] = h_[1] = dx;
+    allocate();
+    for (int j = 0; j < ny_; j++)
+      V_(0, j) = V[j];
+    set_phases();
+  }
+
+  // 2D: V is nx x ny, V_ij at x = i dx, y = j dy
+  split_operator( matrix_type const & V, T dx, T dy, T dt, T mass = 1, int in_threads = 1 ) :
+    dim_(2), nx_(V.size()), ny_(V.empty() ? 0 : V[0].size()), dt_(dt), mass_(mass),
+    t_(0), steps_(0), fft_x_(V.size()), fft_y_(V.empty() ? 0 : V[0].size()), team_(in_threads)
+  {
+    h_[0] = dx;
+    h_[1] = dy;
+    allocate();
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++)
+	V_(i, j) = V[i][j];
+    set_phases();
+  }
+
+  void step() { evolve( 1 ); }
+
+  void evolve( int n_steps )
+  {
+    if ( n_steps <= 0 )
+      return;
+    potential( half_ );
+    forward_rows();
+    for (int s = 0; s < n_steps; s++) {
+      kinetic();
+      bool last = s == n_steps - 1;
+      backward_rows( last ? half_ : full_, !last );
+      t_ += dt_;
+      ++steps_;
+    }
+  }
+
+  // integral of |psi|^2
+  T norm() const
+  {
+    T sum = 0;
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++)
+	sum += std::norm( psi_(i, j) );
+    return sum * ( dim_ == 1 ? h_[1] : h_[0] * h_[1] );
+  }
+
+  void set_psi( int k, T re, T im ) { psi_(0, k) = complex_type( re, im ); }
+  void set_psi( int i, int j, T re, T im ) { psi_(i, j) = complex_type( re, im ); }
+  complex_type get_psi( int k ) const { return psi_(0, k); }
+  complex_type get_psi( int i, int j ) const { return psi_(i, j); }
+
+  // real and imaginary parts and |psi|^2 as nested vectors, one row in 1D
+  matrix_type get_real() const { return to_matrix( 0 ); }
+  matrix_type get_imag() const { return to_matrix( 1 ); }
+  matrix_type get_density() const { return to_matrix( 2 ); }
+
+  // |psi|^2 as a binary field file (field_io.h), 1D or 2D, with the
+  // current time
+  bool write_density( std::string const & file, int dtype = FIELD_FLOAT64, int preview = 0 ) const
+  {
+    grid2d<T> rho( nx_, ny_ );
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++)
+	rho(i, j) = std::norm( psi_(i, j) );
+    field_header h( dtype );
+    h.time = t_;
+    if ( dim_ == 1 ) {
+      h.spacing[0] = h_[1];
+      return write_field( file, rho.row(0), ny_, h, FIELD_MMAP, preview );
+    }
+    h.spacing[0] = h_[0];
+    h.spacing[1] = h_[1];
+    return write_field( file, rho, 0, 0, nx_, ny_, h, FIELD_MMAP, preview );
+  }
+
+  void set_dt( T dt ) { dt_ = dt; set_phases(); }
+
+  T get_t() const { return t_; }
+  T get_dt() const { return dt_; }
+  int get_steps() const { return steps_; }
+  int get_nx() const { return nx_; }
+  int get_ny() const { return ny_; }
+  int get_n_threads() const { return team_.size(); }
+
+protected :
+
+  void allocate()
+  {
+    psi_.resize( nx_, ny_ );
+    V_.resize( nx_, ny_ );
+    half_.resize( nx_, ny_ );
+    full_.resize( nx_, ny_ );
+    if ( dim_ == 2 )
+      psi_t_.resize( ny_, nx_ );
+  }
+
+  // exp(-i V dt / 2), exp(-i V dt), and the kinetic phases along x and y;
+  // the latter include the 1 / (nx ny) of the inverse transforms
+  void set_phases()
+  {
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++) {
+	half_(i, j) = std::polar( T(1), -V_(i, j) * dt_ / 2 );
+	full_(i, j) = std::polar( T(1), -V_(i, j) * dt_ );
+      }
+    kinetic_phase( kin_y_, ny_, h_[1], T(1) / ( T(nx_) * ny_ ) );
+    kinetic_phase( kin_x_, nx_, h_[0], T(1) );
+  }
+
+  void kinetic_phase( std::vector<complex_type> & phase, int n, T h, T norm )
+  {
+    const T pi = 4 * std::atan( T(1) );
+    phase.resize( n );
+    for (int k = 0; k < n; k++) {
+      T p = 2 * pi * ( k < n / 2 ? k : k - n ) / ( n * h );
+      phase[k] = std::polar( norm, -p * p * dt_ / ( 2 * mass_ ) );
+    }
+  }
+
+  void potential( grid2d<complex_type> const & phase )
+  {
+    int ny = ny_;
+    team_.parallel_for( 0, nx_, [&, ny](int i0, int i1) {
+	for (int i = i0; i < i1; i++)
+	  multiply( psi_.row(i), phase.row(i), ny );
+      }, min_rows_per_thread );
+  }
+
+  // transforms along y
+  void forward_rows()
+  {
+    int ny = ny_;
+    team_.parallel_for( 0, nx_, [&, ny](int i0, int i1) {
+	std::vector<complex_type> work( fft_y_.work_size() + 1 );
+	for (int i = i0; i < i1; i++)
+	  fft_y_.transform( psi_.row(i), 1, &work[0] );
+      }, min_rows_per_thread );
+  }
+
+  // inverse transforms along y, the potential phase, and if next the
+  // forward transforms of the next step, row by row while in cache
+  void backward_rows( grid2d<complex_type> const & phase, bool next )
+  {
+    int ny = ny_;
+    team_.parallel_for( 0, nx_, [&, ny, next](int i0, int i1) {
+	std::vector<complex_type> work( fft_y_.work_size() + 1 );
+	for (int i = i0; i < i1; i++) {
+	  complex_type * row = psi_.row(i);
+	  fft_y_.transform( row, -1, &work[0] );
+	  multiply( row, phase.row(i), ny );
+	  if ( next )
+	    fft_y_.transform( row, 1, &work[0] );
+	}
+      }, min_rows_per_thread );
+  }
+
+  // exp(-i p^2 dt / 2m) on psi transformed along y; in 2D the x direction
+  // is transformed forward and back on the transpose
+  void kinetic()
+  {
+    int nx = nx_, ny = ny_;
+    if ( dim_ == 1 ) {
+      multiply( psi_.row(0), &kin_y_[0], ny );
+      return;
+    }
+    transpose( team_, psi_, psi_t_, nx, ny );
+    team_.parallel_for( 0, ny, [&, nx](int j0, int j1) {
+	std::vector<complex_type> work( fft_x_.work_size() + 1 );
+	std::vector<complex_type> phase( nx );
+	for (int j = j0; j < j1; j++) {
+	  complex_type * row = psi_t_.row(j);
+	  fft_x_.transform( row, 1, &work[0] );
+	  for (int i = 0; i < nx; i++)
+	    phase[i] = kin_x_[i] * kin_y_[j];
+	  multiply( row, &phase[0], nx );
+	  fft_x_.transform( row, -1, &work[0] );
+	}
+      }, min_rows_per_thread );
+    transpose( team_, psi_t_, psi_, ny, nx );
+  }
+
+  // a *= b, written out since std::complex multiplication checks for
+  // infinities and NaNs and does not vectorize
+  static void multiply( complex_type * a, complex_type const * b, int n )
+  {
+    T * __restrict ar = reinterpret_cast<T *>( a );
+    T const * __restrict br = reinterpret_cast<T const *>( b );
+    for (int k = 0; k < n; k++) {
+      T xr = ar[2 * k], xi = ar[2 * k + 1];
+      T yr = br[2 * k], yi = br[2 * k + 1];
+      ar[2 * k] = xr * yr - xi * yi;
+      ar[2 * k + 1] = xr * yi + xi * yr;
+    }
+  }
+
+  matrix_type to_matrix( int part ) const
+  {
+    matrix_type m( nx_, vector_type( ny_ ) );
+    for (int i = 0; i < nx_; i++)
+      for (int j = 0; j < ny_; j++) {
+	complex_type z = psi_(i, j);
+	m[i][j] = part == 0 ? z.real() : part == 1 ? z.imag() : std::norm( z );
+      }
+    return m;
+  }
+
+  int dim_;                           // 1 or 2; in 1D psi is row 0
+  int nx_, ny_;                       // points per period across and along rows
+  T h_[2];                            // spacing across rows (x in 2D) and along them
+  T dt_;                              // time step
+  T mass_;                            // particle mass
+  T t_;                               // time
+  int steps_;                         // steps taken
+  grid2d<complex_type> psi_;          // wave function
+  grid2d<complex_type> psi_t_;        // its transpose, 2D
+  grid2d<T> V_;                       // potential
+  grid2d<complex_type> half_;         // exp(-i V dt / 2)
+  grid2d<complex_type> full_;         // exp(-i V dt)
+  std::vector<complex_type> kin_x_;   // kinetic phases along x
+  std::vector<complex_type> kin_y_;   // and along y, times 1 / (nx ny)
+  fft_plan<T> fft_x_, fft_y_;         // transforms across and along rows
+  thread_team team_;                  // threads sharing the rows
+  static const int min_rows_per_thread = 8;
+};
+
+#endif
@@ -0,0 +1,31 @@
+%module evolve
+%{
+#include "advection.h"
+#include "crank_nicolson.h"
+#include "split_operator.h"
+%}
+
+%include "std_vector.i"
+%include "std_string.i"
+%include "std_complex.i"
+
+// dtypes of write_psi / write_u (field_io.h)
+%constant int FIELD_FLOAT32 = FIELD_FLOAT32;
+%constant int FIELD_FLOAT64 = FIELD_FLOAT64;
+
+namespace std {
+   %template(vector_type_d) vector< double>;
+   %template(matrix_type_d) vector< vector<double> >;
+};
+
+%include "advection.h"
+
+%template(advection_double) advection<double>;
+
+%include "crank_nicolson.h"
+
+%template(crank_nicolson_double) crank_nicolson<double>;
+
+%include "split_operator.h"
+
+%template(split_operator_double) split_operator<double>;
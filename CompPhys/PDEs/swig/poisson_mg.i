@@ -1,15 +1,36 @@
 %module poisson_mg
 %{
 #include "poisson_mg.h"
+#include "poisson_mg3d.h"
+#include "poisson_mg_var.h"
+#include "poisson_fft.h"
 %}
 
 %include "std_vector.i"
+%include "std_string.i"
+
+// dtypes of write_psi / write_u (field_io.h)
+%constant int FIELD_FLOAT32 = FIELD_FLOAT32;
+%constant int FIELD_FLOAT64 = FIELD_FLOAT64;
 
 namespace std {
    %template(vector_type_d) vector< double>;
    %template(matrix_type_d) vector< vector<double> >;
+   %template(cube_type_d) vector< vector< vector<double> > >;
 };
 
 %include "poisson_mg.h"
 
 %template(poisson_mg_double) poisson_mg<double>;
+
+%include "poisson_mg3d.h"
+
+%template(poisson_mg3d_double) poisson_mg3d<double>;
+
+%include "poisson_mg_var.h"
+
+%template(poisson_mg_var_double) poisson_mg_var<double>;
+
+%include "poisson_fft.h"
+
+%template(poisson_fft_double) poisson_fft<double>;
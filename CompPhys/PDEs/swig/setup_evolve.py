@@ -0,0 +1,22 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG evolve
+"""
+
+from distutils.core import setup, Extension
+
+
+evolve_module = Extension('_evolve',
+                           sources=['swig/evolve_wrap.cxx'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3", "-pthread"],
+                           extra_link_args=["-pthread"],
+                           )
+
+setup (name = 'evolve',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """Time stepping of advection, diffusion and Schroedinger equations""",
+       ext_modules = [evolve_module],
+       py_modules = ["evolve"],
+       )
@@ -0,0 +1,122 @@
+// Persistent team of threads for splitting grid sweeps into row blocks
+#ifndef thread_team_h
+#define thread_team_h
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class thread_team {
+public :
+
+  // n threads in total, the calling thread included; n <= 0 uses every core
+  thread_team( int n = 1 ) : generation_(0), remaining_(0), stop_(false)
+  {
+    if ( n <= 0 )
+      n = std::thread::hardware_concurrency();
+    if ( n <= 0 )
+      n = 1;
+    n_ = n;
+    for ( int t = 1; t < n_; ++t )
+      workers_.push_back( std::thread( &thread_team::work, this, t ) );
+  }
+
+  ~thread_team()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      stop_ = true;
+      ++generation_;
+    }
+    cv_start_.notify_all();
+    for ( unsigned int t = 0; t < workers_.size(); ++t )
+      workers_[t].join();
+  }
+
+  int size() const { return n_; }
+
+  // Call f(b, e) on contiguous blocks covering [begin, end) and return once
+  // all are done. Ranges shorter than min_per_thread per thread run serially
+  // on the caller, since waking the team costs a few microseconds.
+  void parallel_for( int begin, int end, std::function<void(int,int)> const & f,
+		     int min_per_thread = 1 )
+  {
+    int n = end - begin;
+    int T = n_;
+    if ( min_per_thread > 0 && n / min_per_thread < T )
+      T = n / min_per_thread;
+    if ( T <= 1 ) {
+      if ( n > 0 )
+	f( begin, end );
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      task_ = &f;
+      begin_ = begin;
+      end_ = end;
+      active_ = T;
+      remaining_ = T - 1;
+      ++generation_;
+    }
+    cv_start_.notify_all();
+
+    run_block( 0 );
+
+    std::unique_lock<std::mutex> lock(m_);
+    cv_done_.wait( lock, [this]() { return remaining_ == 0; } );
+    task_ = 0;
+  }
+
+protected :
+
+  void run_block( int t )
+  {
+    int n = end_ - begin_;
+    int b = begin_ + static_cast<int>( static_cast<long long>(n) * t / active_ );
+    int e = begin_ + static_cast<int>( static_cast<long long>(n) * (t + 1) / active_ );
+    (*task_)( b, e );
+  }
+
+  void work( int t )
+  {
+    unsigned long seen = 0;
+    for (;;) {
+      {
+	std::unique_lock<std::mutex> lock(m_);
+	cv_start_.wait( lock, [this, seen]() { return generation_ != seen; } );
+	seen = generation_;
+	if ( stop_ )
+	  return;
+	if ( t >= active_ )
+	  continue;
+      }
+      run_block( t );
+      {
+	std::lock_guard<std::mutex> lock(m_);
+	if ( --remaining_ == 0 )
+	  cv_done_.notify_one();
+      }
+    }
+  }
+
+  int n_;                                       // team size including the caller
+  std::vector<std::thread> workers_;
+
+  std::mutex m_;
+  std::condition_variable cv_start_;            // new task published
+  std::condition_variable cv_done_;             // all helpers finished
+  std::function<void(int,int)> const * task_ = 0;
+  int begin_ = 0, end_ = 0;                     // range of the current task
+  int active_ = 0;                              // threads taking part in it
+  unsigned long generation_;                    // bumped for every task
+  int remaining_;                               // helpers still running
+  bool stop_;
+};
+
+
+#endif
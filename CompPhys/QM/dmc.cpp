@@ -1,16 +1,16 @@
 // Diffusion Monte Carlo program for the 3-D harmonic oscillator
 #include "dmc.h"
+#include <algorithm>
 
 using namespace std;
 
 
 
   
-DiffusionMC::DiffusionMC(int nt, double idt) :
-  rd(), gen(rd()), dis(0,1.), gausdev(),
+DiffusionMC::DiffusionMC(int nt, double idt, int iseed) :
+  rd(), gen(iseed < 0 ? rd() : iseed), dis(0,1.), gausdev(),
   N_T(nt), dt(idt)
 {
-  std::cout << "Hello from DiffusionMC" << std::endl;
   N = N_T;                   // set N to target number specified by user
   ensureCapacity(N);    
   for (int n = 0; n < N; n++) {      
@@ -96,10 +96,16 @@ void DiffusionMC::oneTimeStep() {
     }
   N = newN;
 
-  // adjust E_T
+  // adjust E_T: centre it on the mean potential of the walkers, which damps
+  // the population oscillations, and relax log(N) back to log(N_T) by 10%
+  // per step independent of dt
 
-  if ( N > 0 )
-    E_T += log(N_T / double(N)) / 10;
+  if ( N > 0 ) {
+    double VSum = 0;
+    for (int n = 0; n < N; n++)
+      VSum += V(r[n]);
+    E_T = VSum / N + log(N_T / double(N)) / (10 * dt);
+  }
 
   // measure energy, wave function
   ESum += E_T;
@@ -130,15 +136,18 @@ void DiffusionMC::printout(std::ostream & out, int skip) {
 
 void DiffusionMC::run( int timeSteps )
 {
-  std::cout  << "Running" << std::endl;
+  if (verbose)
+    std::cout  << "Running" << std::endl;
   
   // do 20% of timeSteps as thermalization steps
   int thermSteps = static_cast<int>(0.2 * timeSteps);
   for (int i = 0; i < thermSteps; i++)
     this->oneTimeStep();
 
-  std::cout << "Initialization after thermalizing" << std::endl;
-  this->printout(std::cout,10);
+  if (verbose) {
+    std::cout << "Initialization after thermalizing" << std::endl;
+    this->printout(std::cout,10);
+  }
 
     
   // production steps
@@ -146,22 +155,23 @@ void DiffusionMC::run( int timeSteps )
   for (int i = 0; i < timeSteps; i++) {
     this->oneTimeStep();
 
-    if ( i % 100 == 0 && i > 0 ) {
+    if ( verbose && i % 100 == 0 && i > 0 ) {
       std::cout << "i = " << i << ", Eavg = " << this->getESum() / i << std::endl;
     }
   }
 
-  std::cout << "Final form" << std::endl;
-  this->printout(std::cout,10);
-
-  std::cout << "ESum = " << this->getESum() << std::endl;
-  std::cout << "ESqdSum = " << this->getESqdSum() << std::endl;
-    
   // compute averages
   double EAve = this->getESum() / timeSteps;
   double EVar = this->getESqdSum() / timeSteps - EAve * EAve;
-  cout << " <E> = " << EAve << " +/- " << sqrt(EVar / timeSteps) << endl;
-  cout << " <E^2> - <E>^2 = " << EVar << endl;
+  if (verbose) {
+    std::cout << "Final form" << std::endl;
+    this->printout(std::cout,10);
+
+    std::cout << "ESum = " << this->getESum() << std::endl;
+    std::cout << "ESqdSum = " << this->getESqdSum() << std::endl;
+    cout << " <E> = " << EAve << " +/- " << sqrt(EVar / timeSteps) << endl;
+    cout << " <E^2> - <E>^2 = " << EVar << endl;
+  }
   double psiNorm = 0, psiExactNorm = 0;
   double dr = this->getRMax() / this->getNPSI();
   for (int i = 0; i < this->getNPSI(); i++) {
@@ -177,3 +187,49 @@ void DiffusionMC::run( int timeSteps )
   }
   
 }
+
+
+int DiffusionMC::run_to_error( double target_error, int max_steps,
+			       int block_size, int min_blocks,
+			       double block_time )
+{
+  // thermalize for a few units of imaginary time
+  int thermSteps = std::max(block_size, static_cast<int>(5 / dt));
+  for (int i = 0; i < thermSteps; i++)
+    this->oneTimeStep();
+
+  // production steps, averaging E_T over blocks long enough to be
+  // roughly uncorrelated: E_T relaxes over a fixed span of imaginary
+  // time, which is ever more steps as dt shrinks
+  block_size = std::max(block_size, static_cast<int>(std::ceil(block_time / dt)));
+  this->zeroAccumulators();
+  double blockSum = 0, meanSum = 0, meanSqdSum = 0;
+  int blocks = 0, steps = 0;
+  EErr = 1e30;
+  while (steps < max_steps) {
+    this->oneTimeStep();
+    ++steps;
+    blockSum += E_T;
+    if (steps % block_size != 0)
+      continue;
+
+    double mean = blockSum / block_size;
+    blockSum = 0;
+    meanSum += mean;
+    meanSqdSum += mean * mean;
+    ++blocks;
+    if (blocks > 1) {
+      double ave = meanSum / blocks;
+      double var = (meanSqdSum / blocks - ave * ave) * blocks / (blocks - 1);
+      EErr = sqrt(std::max(var, 0.0) / blocks);
+    }
+    if (blocks >= min_blocks && EErr <= target_error)
+      break;
+  }
+
+  EAve = this->getESum() / steps;
+  if (verbose)
+    cout << " dt = " << dt << " : <E> = " << EAve << " +/- " << EErr
+	 << " after " << steps << " steps" << endl;
+  return steps;
+}
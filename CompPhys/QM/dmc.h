@@ -13,7 +13,8 @@
 class DiffusionMC {
 public:
   
-  DiffusionMC(int nt, double idt);
+  // a negative seed draws one from std::random_device
+  DiffusionMC(int nt, double idt, int iseed = -1);
 
   // harmonic oscillator in DIM dimensions
   double V( std::vector<double> const & r);
@@ -34,6 +35,21 @@ public:
   
   void run( int timeSteps );
 
+  // Thermalize, then run until the blocked error bar on E_T reaches
+  // target_error (and at least min_blocks blocks are done) or max_steps
+  // production steps have been taken. A block is block_size steps or
+  // block_time units of imaginary time, whichever is longer, so that it
+  // outlasts the correlation time of E_T at any dt.
+  // Returns the number of production steps.
+  int run_to_error( double target_error, int max_steps,
+		    int block_size = 100, int min_blocks = 16,
+		    double block_time = 5.0 );
+  inline double getEAve() const { return EAve; }
+  inline double getEErr() const { return EErr; }
+
+  // progress printout from the constructor and run()
+  void set_verbose(bool v) { verbose = v; }
+
   
 protected:
   // C++11 random number generator from Mersenne twister. 
@@ -60,6 +76,11 @@ protected:
   double rMax = 4;                        // max value of r to measure psi
   std::vector<double> psi;                // wave function histogram
 
+  bool verbose = true;                    // print progress in run()
+
+  double EAve = 0;                        // <E> from run_to_error
+  double EErr = 0;                        // blocked error on EAve
+
 };
 
 
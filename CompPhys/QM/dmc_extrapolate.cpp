@@ -0,0 +1,106 @@
+// Time-step extrapolation of Diffusion Monte Carlo energies
+#include "dmc_extrapolate.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+
+DMCExtrapolation::DMCExtrapolation(int iN_T, std::vector<double> const & idts, double itarget_error,
+				   int imax_steps, int iorder, int in_threads, int iseed) :
+  N_T(iN_T), dts(idts), target_error(itarget_error), max_steps(imax_steps),
+  order(iorder), n_threads(in_threads), seed(iseed), E0(0), E0_err(0), chi2(0)
+{
+  if (order < 0)
+    order = 0;
+  if (order > int(dts.size()) - 1)
+    order = int(dts.size()) - 1;
+}
+
+void DMCExtrapolation::run()
+{
+  int n = dts.size();
+  E.assign(n, 0);
+  E_err.assign(n, 0);
+  steps.assign(n, 0);
+
+  // smallest dt needs the most steps, so start it first
+  std::vector<int> order_by_dt(n);
+  for (int k = 0; k < n; ++k)
+    order_by_dt[k] = k;
+  std::sort(order_by_dt.begin(), order_by_dt.end(),
+	    [this](int a, int b) { return dts[a] < dts[b]; });
+
+  {
+    ThreadPool pool(n_threads);
+    for (int k = 0; k < n; ++k) {
+      int i = order_by_dt[k];
+      pool.submit([this, i]() {
+	  DiffusionMC dmc(N_T, dts[i], seed + i);
+	  dmc.set_verbose(false);
+	  steps[i] = dmc.run_to_error(target_error, max_steps);
+	  E[i] = dmc.getEAve();
+	  E_err[i] = dmc.getEErr();
+	});
+    }
+    pool.wait();
+  }
+
+  fit();
+}
+
+void DMCExtrapolation::fit()
+{
+  // normal equations A c = b with weights 1 / sigma^2
+  int n = dts.size(), p = order + 1;
+  std::vector< std::vector<double> > A(p, std::vector<double>(2 * p, 0.0));
+  std::vector<double> b(p, 0.0);
+  for (int k = 0; k < n; ++k) {
+    double w = 1 / (E_err[k] * E_err[k]);
+    std::vector<double> powers(p, 1.0);
+    for (int i = 1; i < p; ++i)
+      powers[i] = powers[i - 1] * dts[k];
+    for (int i = 0; i < p; ++i) {
+      b[i] += w * powers[i] * E[k];
+      for (int j = 0; j < p; ++j)
+	A[i][j] += w * powers[i] * powers[j];
+    }
+  }
+
+  // Gauss-Jordan elimination on [A | 1] gives the covariance matrix A^-1
+  for (int i = 0; i < p; ++i)
+    A[i][p + i] = 1;
+  for (int i = 0; i < p; ++i) {
+    int pivot = i;
+    for (int r = i + 1; r < p; ++r)
+      if (fabs(A[r][i]) > fabs(A[pivot][i]))
+	pivot = r;
+    std::swap(A[i], A[pivot]);
+    double d = A[i][i];
+    for (int j = 0; j < 2 * p; ++j)
+      A[i][j] /= d;
+    for (int r = 0; r < p; ++r)
+      if (r != i) {
+	double f = A[r][i];
+	for (int j = 0; j < 2 * p; ++j)
+	  A[r][j] -= f * A[i][j];
+      }
+  }
+
+  coefficients.assign(p, 0.0);
+  for (int i = 0; i < p; ++i)
+    for (int j = 0; j < p; ++j)
+      coefficients[i] += A[i][p + j] * b[j];
+
+  chi2 = 0;
+  for (int k = 0; k < n; ++k) {
+    double f = 0, x = 1;
+    for (int i = 0; i < p; ++i, x *= dts[k])
+      f += coefficients[i] * x;
+    chi2 += (E[k] - f) * (E[k] - f) / (E_err[k] * E_err[k]);
+  }
+
+  E0 = coefficients[0];
+  E0_err = sqrt(A[0][p]);
+}
@@ -0,0 +1,55 @@
+// Time-step extrapolation of Diffusion Monte Carlo energies
+#ifndef dmc_extrapolate_h
+#define dmc_extrapolate_h
+
+#include <vector>
+
+#include "dmc.h"
+
+
+class DMCExtrapolation {
+public:
+
+  // Run one DiffusionMC per time step in dts, each to the same target
+  // error bar, and fit E(dt) = E0 + a dt (+ b dt^2 for order 2).
+  DMCExtrapolation(int iN_T, std::vector<double> const & idts, double itarget_error,
+		   int imax_steps = 1000000, int iorder = 1, int in_threads = 0, int iseed = 12345);
+
+  // run the ladder concurrently, then fit
+  void run();
+
+  // weighted least squares fit of E(dt) to a polynomial of degree order
+  void fit();
+
+  double get_E0() const { return E0; }
+  double get_E0_err() const { return E0_err; }
+  std::vector<double> const & get_coefficients() const { return coefficients; }
+  double get_chi2() const { return chi2; }
+
+  std::vector<double> const & get_dts() const { return dts; }
+  std::vector<double> const & get_E() const { return E; }
+  std::vector<double> const & get_E_err() const { return E_err; }
+  std::vector<int> const & get_steps() const { return steps; }
+
+protected:
+
+  int N_T;                            // target number of walkers
+  std::vector<double> dts;            // time step ladder
+  double target_error;                // stop each run at this error bar
+  int max_steps;                      // but never run longer than this
+  int order;                          // degree of the fit polynomial in dt
+  int n_threads;                      // threads for the ladder
+  int seed;                           // seeds of the runs derive from this
+
+  std::vector<double> E;              // <E> at each dt
+  std::vector<double> E_err;          // blocked error at each dt
+  std::vector<int> steps;             // production steps used at each dt
+
+  std::vector<double> coefficients;   // E0, a, b, ...
+  double E0;                          // extrapolated dt -> 0 energy
+  double E0_err;                      // its uncertainty from the fit
+  double chi2;                        // chi^2 of the fit
+};
+
+
+#endif
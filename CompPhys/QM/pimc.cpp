@@ -1,22 +1,24 @@
 // Path Integral Monte Carlo program for the 1-D harmonic oscillator
 
 #include "pimc.h"
+#include <algorithm>
 
-PathIntegralMC::PathIntegralMC(double itau, int iM, int inbins, double ixmax, double idelta, int iMC_steps):
-  rd(), gen(rd()), dis(0,1.), gausdev(),
-  tau(itau),M(iM),Delta_tau(tau/M),n_bins(inbins),x_min(-ixmax),x_max(ixmax),x_new(0),dx((x_max - x_min) / n_bins),delta(idelta),MC_steps(iMC_steps)
+PathIntegralMC::PathIntegralMC(double itau, int iM, int inbins, double ixmax, double idelta, int iMC_steps, int imeasure_interval, int iseed):
+  rd(), gen(iseed < 0 ? rd() : iseed), dis(0,1.), gausdev(),
+  tau(itau),M(iM),Delta_tau(tau/M),histogram(inbins,-ixmax,ixmax),x_new(0),delta(idelta),MC_steps(iMC_steps),measure_interval(imeasure_interval),E_ave(0),E_var(0),E_err(0)
 {
   x.resize(M);
-  P.resize(n_bins);
   for (int j = 0; j < M; ++j)
-    x[j] = (2 * dis(gen) - 1) * x_max;
+    x[j] = (2 * dis(gen) - 1) * ixmax;
+  if (measure_interval < 1)
+    measure_interval = 1;
 }
 
   
 double PathIntegralMC::V(double x)          // potential energy function
 {
   // use units such that m = 1 and omega_0 = 1
-  return 0.5 * pow(x, 2.0);
+  return 0.5 * x * x;
 }
 
 double PathIntegralMC::dVdx(double x)       // derivative dV(x)/dx used in virial theorem
@@ -37,37 +39,61 @@ int PathIntegralMC::thermalize()
 
 void PathIntegralMC::do_steps()
 {
-  double E_sum = 0, E_sqd_sum = 0;    
-  int acceptances = 0;
-  P.clear();
-  P.resize(n_bins);
+  double E_sum = 0, E_sqd_sum = 0;
+  int acceptances = 0, measurements = 0;
+  int n_measure = MC_steps / measure_interval;
+  std::vector<double> block_sum(n_blocks, 0.0);
+  std::vector<int> block_count(n_blocks, 0);
+  histogram.clear();
   for (int step = 0; step < MC_steps; ++step) {
-    for (int j = 0; j < M; ++j) {
+    for (int j = 0; j < M; ++j)
       if (Metropolis_step_accepted())
 	++acceptances;
-      // add x_new to histogram bin
-      int bin = int((x_new - x_min) / (x_max - x_min) * n_bins);
-      if (bin >= 0 && bin < M)
-	P[bin] += 1;
-      // compute Energy using virial theorem formula and accumulate
-      double E = V(x_new) + 0.5 * x_new * dVdx(x_new);
-      E_sum += E;
-      E_sqd_sum += E * E;
+    // measure once per sweep over the whole path
+    if ((step + 1) % measure_interval == 0) {
+      int b = int((long long)measurements * n_blocks / n_measure);
+      double before = E_sum;
+      measure(E_sum, E_sqd_sum);
+      block_sum[b] += E_sum - before;
+      ++block_count[b];
+      ++measurements;
     }
   }
 
   // compute averages
-  double values = MC_steps * M;
-  E_ave = E_sum / values;
-  E_var = E_sqd_sum / values - E_ave * E_ave;
-  E_ave = 0;
-  for (int bin = 0; bin < n_bins; ++bin) {
-    double x = x_min + dx * (bin + 0.5);
-    E_ave += P[bin] / values * (0.5 * x * dVdx(x) + V(x));
+  double values = double(measurements) * M;
+  E_ave = values > 0 ? E_sum / values : 0;
+  E_var = values > 0 ? E_sqd_sum / values - E_ave * E_ave : 0;
+
+  // block averages are nearly independent if blocks are much longer
+  // than the autocorrelation time
+  double sum = 0, sqd_sum = 0;
+  int blocks = 0;
+  for (int b = 0; b < n_blocks; ++b)
+    if (block_count[b] > 0) {
+      double E_b = block_sum[b] / (double(block_count[b]) * M);
+      sum += E_b;
+      sqd_sum += E_b * E_b;
+      ++blocks;
+    }
+  E_err = 0;
+  if (blocks > 1) {
+    double mean = sum / blocks;
+    E_err = std::sqrt(std::max(0.0, sqd_sum / blocks - mean * mean) / (blocks - 1));
   }
+}
 
+void PathIntegralMC::measure(double & E_sum, double & E_sqd_sum)
+{
+  // add every x[j] to the histogram
+  histogram.add(&x[0], M);
+  for (int j = 0; j < M; ++j) {
+    // compute Energy using virial theorem formula and accumulate
+    double E = virial_energy(V(x[j]), x[j] * dVdx(x[j]));
+    E_sum += E;
+    E_sqd_sum += E * E;
+  }
 }
-    
 
 bool PathIntegralMC::Metropolis_step_accepted()
 {
@@ -81,10 +107,8 @@ bool PathIntegralMC::Metropolis_step_accepted()
   double x_trial = x[j] + (2 * dis(gen) - 1) * delta;
   // compute change in energy
   double Delta_E = V(x_trial) - V(x[j])
-    + 0.5 * pow((x[j_plus] - x_trial) / Delta_tau, 2.0)
-    + 0.5 * pow((x_trial - x[j_minus]) / Delta_tau, 2.0)
-    - 0.5 * pow((x[j_plus] - x[j]) / Delta_tau, 2.0)
-    - 0.5 * pow((x[j] - x[j_minus]) / Delta_tau, 2.0);
+    + (x_trial - x[j]) * (x_trial + x[j] - x[j_plus] - x[j_minus])
+    / (Delta_tau * Delta_tau);
   if (Delta_E < 0.0 || exp(- Delta_tau * Delta_E) > dis(gen)) {
     x_new = x[j] = x_trial;
     return true;
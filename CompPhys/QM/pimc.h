@@ -9,11 +9,15 @@
 #include <vector>
 #include <random>
 
+#include "pimc_estimators.h"
+
 
 class PathIntegralMC{
 public:
 
-  PathIntegralMC(double itau, int iM, int inbins, double ixmax, double idelta, int iMC_steps); 
+  // a negative seed draws one from std::random_device
+  PathIntegralMC(double itau, int iM, int inbins, double ixmax, double idelta, int iMC_steps,
+		 int imeasure_interval = 1, int iseed = -1);
 
   // potential energy function
   double V(double x);
@@ -24,17 +28,24 @@ public:
   int thermalize();
 
   void do_steps();
-    
+
+  // accumulate histogram and virial energy over all M beads of the path
+  void measure(double & E_sum, double & E_sqd_sum);
+
 
   bool Metropolis_step_accepted();
 
-  std::vector<double> const & get_P() const {return P;}
+  std::vector<double> const & get_P() const {return histogram.get_P();}
 
-  double get_x_min() const { return x_min; }
-  double get_x_max() const { return x_max; }
-  double get_dx() const { return dx; }
+  double get_x_min() const { return histogram.get_x_min(); }
+  double get_x_max() const { return histogram.get_x_max(); }
+  double get_dx() const { return histogram.get_dx(); }
   double get_E_ave() const { return E_ave; }
   double get_E_var() const { return E_var; }
+  // standard error of E_ave from the scatter of n_blocks block averages
+  double get_E_err() const { return E_err; }
+  int get_measure_interval() const { return measure_interval; }
+  void set_measure_interval(int n) { measure_interval = n > 0 ? n : 1; }
   
 protected :
 
@@ -49,19 +60,18 @@ protected :
   double Delta_tau;           // imaginary time step
   std::vector<double> x;      // displacements from equilibrium of M "atoms"
 
-  int n_bins;                 // number of bins for psi histogram
-  double x_min;               // bottom of first bin
-  double x_max;               // top of last bin
+  PathHistogram histogram;    // histogram for |psi|^2 over [-x_max, x_max]
   double x_new;               // New x value after Metropolis step
-  double dx;                  // bin width
-  std::vector<double> P;      // histogram for |psi|^2
 
   double delta;               // Metropolis step size in x
   int MC_steps;               // number of Monte Carlo steps in simulation
+  int measure_interval;       // measure every this many Monte Carlo steps
 
 
   double E_ave;               // average energy
   double E_var;               // energy variance
+  double E_err;               // standard error of E_ave
+  static const int n_blocks = 20;   // blocks for E_err
 };
 
 
@@ -0,0 +1,60 @@
+// Estimators shared by the path integral programs PathIntegralMC and
+// ManyBodyPIMC: a histogram of bead coordinates for |psi|^2, and the
+// virial estimator of the energy
+#ifndef pimc_estimators_h
+#define pimc_estimators_h
+
+#include <algorithm>
+#include <vector>
+
+
+class PathHistogram {
+public:
+
+  PathHistogram(int in_bins, double ix_min, double ix_max) :
+    n_bins(in_bins), x_min(ix_min), x_max(ix_max), dx((x_max - x_min) / n_bins),
+    scale(n_bins / (x_max - x_min)), P(n_bins, 0.0) { }
+
+  void clear() { std::fill(P.begin(), P.end(), 0.0); }
+
+  // count x, if it falls in [x_min, x_max)
+  void add(double x)
+  {
+    int bin = int((x - x_min) * scale);
+    if (bin >= 0 && bin < n_bins)
+      P[bin] += 1;
+  }
+
+  // count x[0], x[stride], ... x[(n - 1) * stride]
+  void add(double const * x, int n, int stride = 1)
+  {
+    for (int k = 0; k < n; ++k)
+      add(x[k * stride]);
+  }
+
+  std::vector<double> const & get_P() const { return P; }
+  int get_n_bins() const { return n_bins; }
+  double get_x_min() const { return x_min; }
+  double get_x_max() const { return x_max; }
+  double get_dx() const { return dx; }
+
+protected:
+
+  int n_bins;                 // number of bins
+  double x_min;               // bottom of first bin
+  double x_max;               // top of last bin
+  double dx;                  // bin width
+  double scale;               // bins per unit x
+  std::vector<double> P;      // counts in each bin
+};
+
+
+// virial estimator of the energy, V + (1/2) r . grad V, from the potential
+// and r . grad V of a bead or summed over the beads of a slice
+inline double virial_energy(double V, double r_dV)
+{
+  return V + 0.5 * r_dV;
+}
+
+
+#endif
@@ -0,0 +1,321 @@
+// Path Integral Monte Carlo for N interacting particles in 3-D
+
+#include "pimc_many.h"
+#include <algorithm>
+
+ManyBodyPIMC::ManyBodyPIMC(int iN, double itau, int iM, int inbins, double ixmax, double idelta, int iMC_steps,
+			   double iepsilon, double isigma, double ir_cut, int in_threads):
+  rd(), dis(0,1.),
+  N(iN),tau(itau),M(iM),Delta_tau(tau/M),histogram(inbins,-ixmax,ixmax),x_min(-ixmax),x_max(ixmax),
+  delta(idelta),MC_steps(iMC_steps),epsilon(iepsilon),sigma(isigma),r_cut(ir_cut),n_threads(in_threads),
+  E_ave(0),E_var(0),acceptance(0)
+{
+  if (n_threads < 1)
+    n_threads = 1;
+  // start the workers once; every colour of every sweep reuses them
+  if (n_threads > 1)
+    pool.reset(new ThreadPool(n_threads));
+
+  // seed one generator per slice from the random device
+  std::vector<unsigned int> seeds(M);
+  for (int j = 0; j < M; ++j)
+    seeds[j] = rd();
+  std::seed_seq seq(seeds.begin(), seeds.end());
+  std::vector<unsigned int> slice_seeds(M);
+  seq.generate(slice_seeds.begin(), slice_seeds.end());
+  for (int j = 0; j < M; ++j)
+    gens.push_back(std::mt19937(slice_seeds[j]));
+
+  r.resize(M * N * DIM);
+
+  // start every slice of a particle at the same random point
+  for (int i = 0; i < N; ++i) {
+    double start[DIM];
+    for (int d = 0; d < DIM; ++d)
+      start[d] = (2 * dis(gens[0]) - 1) * 0.5 * x_max;
+    for (int j = 0; j < M; ++j)
+      for (int d = 0; d < DIM; ++d)
+	bead(j, i)[d] = start[d];
+  }
+
+  // cells no smaller than the cutoff so that neighbours lie in adjacent cells
+  n_cell = std::max(1, int((x_max - x_min) / r_cut));
+  cell_size = (x_max - x_min) / n_cell;
+  build_cells();
+
+  // slices j and j+1 are coupled by the kinetic springs, so update even and
+  // odd slices in turn; with M odd the last slice touches slice 0 and goes alone
+  colors.resize(3);
+  for (int j = 0; j < M; ++j) {
+    if (M % 2 == 1 && j == M - 1)
+      colors[2].push_back(j);
+    else
+      colors[j % 2].push_back(j);
+  }
+}
+
+
+double ManyBodyPIMC::V_ext(double const * ri) const
+{
+  double r2 = 0;
+  for (int d = 0; d < DIM; ++d)
+    r2 += ri[d] * ri[d];
+  return 0.5 * r2;
+}
+
+double ManyBodyPIMC::r_dV_ext(double const * ri) const
+{
+  double r2 = 0;
+  for (int d = 0; d < DIM; ++d)
+    r2 += ri[d] * ri[d];
+  return r2;
+}
+
+double ManyBodyPIMC::u_pair(double r2) const
+{
+  if (r2 >= r_cut * r_cut)
+    return 0;
+  double s6 = sigma * sigma / r2;
+  s6 = s6 * s6 * s6;
+  return 4 * epsilon * (s6 * s6 - s6);
+}
+
+double ManyBodyPIMC::r_du_pair(double r2) const
+{
+  if (r2 >= r_cut * r_cut)
+    return 0;
+  double s6 = sigma * sigma / r2;
+  s6 = s6 * s6 * s6;
+  return - 24 * epsilon * (2 * s6 * s6 - s6);
+}
+
+
+int ManyBodyPIMC::cell_index(double const * ri) const
+{
+  // beads outside [x_min, x_max] are clamped into the boundary cells,
+  // which keeps any pair closer than r_cut in adjacent cells
+  int c = 0;
+  for (int d = 0; d < DIM; ++d) {
+    int k = int(std::floor((ri[d] - x_min) / cell_size));
+    k = std::min(std::max(k, 0), n_cell - 1);
+    c = c * n_cell + k;
+  }
+  return c;
+}
+
+void ManyBodyPIMC::build_cells()
+{
+  int cells = n_cell * n_cell * n_cell;
+  head.assign(M * cells, -1);
+  next.assign(M * N, -1);
+  prev.assign(M * N, -1);
+  cell.assign(M * N, 0);
+  for (int j = 0; j < M; ++j)
+    for (int i = 0; i < N; ++i) {
+      int c = cell_index(bead(j, i));
+      int b = j * N + i;
+      int & h = head[j * cells + c];
+      cell[b] = c;
+      next[b] = h;
+      if (h >= 0)
+	prev[j * N + h] = i;
+      h = i;
+    }
+}
+
+void ManyBodyPIMC::move_to_cell(int j, int i, int c)
+{
+  int cells = n_cell * n_cell * n_cell;
+  int b = j * N + i;
+  if (cell[b] == c)
+    return;
+
+  // unlink from the old cell
+  if (prev[b] >= 0)
+    next[j * N + prev[b]] = next[b];
+  else
+    head[j * cells + cell[b]] = next[b];
+  if (next[b] >= 0)
+    prev[j * N + next[b]] = prev[b];
+
+  // push onto the new cell
+  int & h = head[j * cells + c];
+  prev[b] = -1;
+  next[b] = h;
+  if (h >= 0)
+    prev[j * N + h] = i;
+  h = i;
+  cell[b] = c;
+}
+
+double ManyBodyPIMC::pair_energy(int j, int i, double const * ri) const
+{
+  if (epsilon == 0)
+    return 0;
+
+  int cells = n_cell * n_cell * n_cell;
+  int c = cell_index(ri);
+  int cz = c % n_cell, cy = (c / n_cell) % n_cell, cx = c / (n_cell * n_cell);
+  double U = 0;
+  for (int ax = std::max(cx - 1, 0); ax <= std::min(cx + 1, n_cell - 1); ++ax)
+    for (int ay = std::max(cy - 1, 0); ay <= std::min(cy + 1, n_cell - 1); ++ay)
+      for (int az = std::max(cz - 1, 0); az <= std::min(cz + 1, n_cell - 1); ++az) {
+	int a = (ax * n_cell + ay) * n_cell + az;
+	for (int k = head[j * cells + a]; k >= 0; k = next[j * N + k]) {
+	  if (k == i)
+	    continue;
+	  double const * rk = bead(j, k);
+	  double r2 = 0;
+	  for (int d = 0; d < DIM; ++d)
+	    r2 += (ri[d] - rk[d]) * (ri[d] - rk[d]);
+	  U += u_pair(r2);
+	}
+      }
+  return U;
+}
+
+
+int ManyBodyPIMC::update_slice(int j)
+{
+  std::mt19937 & gen = gens[j];
+  std::uniform_real_distribution<> uni(0, 1.);
+  int j_minus = j - 1, j_plus = j + 1;
+  if (j_minus < 0) j_minus = M - 1;
+  if (j_plus > M - 1) j_plus = 0;
+
+  int acceptances = 0;
+  for (int n = 0; n < N; ++n) {
+    // choose a particle at random
+    int i = int(uni(gen) * N);
+    double * ri = bead(j, i);
+    double const * rp = bead(j_plus, i);
+    double const * rm = bead(j_minus, i);
+
+    // choose a random trial displacement
+    double trial[DIM];
+    for (int d = 0; d < DIM; ++d)
+      trial[d] = ri[d] + (2 * uni(gen) - 1) * delta;
+
+    // compute change in energy
+    double kinetic = 0;
+    for (int d = 0; d < DIM; ++d)
+      kinetic += (rp[d] - trial[d]) * (rp[d] - trial[d])
+	+ (trial[d] - rm[d]) * (trial[d] - rm[d])
+	- (rp[d] - ri[d]) * (rp[d] - ri[d])
+	- (ri[d] - rm[d]) * (ri[d] - rm[d]);
+    double Delta_E = V_ext(trial) - V_ext(ri)
+      + pair_energy(j, i, trial) - pair_energy(j, i, ri)
+      + 0.5 * kinetic / (Delta_tau * Delta_tau);
+
+    if (Delta_E < 0.0 || exp(- Delta_tau * Delta_E) > uni(gen)) {
+      for (int d = 0; d < DIM; ++d)
+	ri[d] = trial[d];
+      move_to_cell(j, i, cell_index(ri));
+      ++acceptances;
+    }
+  }
+  return acceptances;
+}
+
+void ManyBodyPIMC::measure_slice(int j, double & pot, double & vir) const
+{
+  int cells = n_cell * n_cell * n_cell;
+  pot = vir = 0;
+  for (int i = 0; i < N; ++i) {
+    double const * ri = bead(j, i);
+    pot += V_ext(ri);
+    vir += r_dV_ext(ri);
+    if (epsilon == 0)
+      continue;
+
+    // count each pair once by only looking at partners k > i
+    int c = cell[j * N + i];
+    int cz = c % n_cell, cy = (c / n_cell) % n_cell, cx = c / (n_cell * n_cell);
+    for (int ax = std::max(cx - 1, 0); ax <= std::min(cx + 1, n_cell - 1); ++ax)
+      for (int ay = std::max(cy - 1, 0); ay <= std::min(cy + 1, n_cell - 1); ++ay)
+	for (int az = std::max(cz - 1, 0); az <= std::min(cz + 1, n_cell - 1); ++az) {
+	  int a = (ax * n_cell + ay) * n_cell + az;
+	  for (int k = head[j * cells + a]; k >= 0; k = next[j * N + k]) {
+	    if (k <= i)
+	      continue;
+	    double const * rk = bead(j, k);
+	    double r2 = 0;
+	    for (int d = 0; d < DIM; ++d)
+	      r2 += (ri[d] - rk[d]) * (ri[d] - rk[d]);
+	    pot += u_pair(r2);
+	    vir += r_du_pair(r2);
+	  }
+	}
+  }
+}
+
+
+template<typename F>
+void ManyBodyPIMC::for_slices(std::vector<int> const & slices, F f)
+{
+  int n = slices.size();
+  int T = std::min(n_threads, n);
+  if (T <= 1) {
+    for (int s = 0; s < n; ++s)
+      f(slices[s]);
+    return;
+  }
+  for (int t = 0; t < T; ++t)
+    pool->submit([&slices, &f, n, t, T]() {
+	for (int s = t; s < n; s += T)
+	  f(slices[s]);
+      });
+  pool->wait();
+}
+
+int ManyBodyPIMC::sweep()
+{
+  std::vector<int> accepted(M, 0);
+  for (unsigned int color = 0; color < colors.size(); ++color)
+    for_slices(colors[color], [this, &accepted](int j) { accepted[j] = update_slice(j); });
+  int acceptances = 0;
+  for (int j = 0; j < M; ++j)
+    acceptances += accepted[j];
+  return acceptances;
+}
+
+int ManyBodyPIMC::thermalize()
+{
+  int therm_steps = MC_steps / 5, acceptances = 0;
+  for (int step = 0; step < therm_steps; ++step)
+    acceptances += sweep();
+  return acceptances;
+}
+
+void ManyBodyPIMC::do_steps()
+{
+  double E_sum = 0, E_sqd_sum = 0;
+  long acceptances = 0;
+  histogram.clear();
+
+  std::vector<int> all(M);
+  for (int j = 0; j < M; ++j)
+    all[j] = j;
+  std::vector<double> pot(M), vir(M);
+
+  for (int step = 0; step < MC_steps; ++step) {
+    acceptances += sweep();
+
+    // add the x coordinate of every bead to the histogram
+    histogram.add(&r[0], M * N, DIM);
+
+    // compute Energy using virial theorem formula averaged over slices
+    for_slices(all, [this, &pot, &vir](int j) { measure_slice(j, pot[j], vir[j]); });
+    double E = 0;
+    for (int j = 0; j < M; ++j)
+      E += virial_energy(pot[j], vir[j]);
+    E /= M;
+    E_sum += E;
+    E_sqd_sum += E * E;
+  }
+
+  // compute averages
+  E_ave = E_sum / MC_steps;
+  E_var = E_sqd_sum / MC_steps - E_ave * E_ave;
+  acceptance = acceptances / (double(MC_steps) * M * N);
+}
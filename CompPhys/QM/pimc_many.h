@@ -0,0 +1,123 @@
+// Path Integral Monte Carlo for N interacting particles in 3-D
+// confined by a harmonic trap and interacting through a
+// Lennard-Jones pair potential
+#ifndef pimc_many_h
+#define pimc_many_h
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <random>
+
+#include "pimc_estimators.h"
+#include "thread_pool.h"
+
+
+class ManyBodyPIMC{
+public:
+
+  ManyBodyPIMC(int iN, double itau, int iM, int inbins, double ixmax, double idelta, int iMC_steps,
+	       double iepsilon = 1.0, double isigma = 1.0, double ir_cut = 2.5, int in_threads = 1);
+
+  // external trap potential, in units such that m = 1 and omega_0 = 1
+  double V_ext(double const * r) const;
+
+  // r . grad V_ext(r) used in virial theorem
+  double r_dV_ext(double const * r) const;
+
+  // pair potential u(r) as a function of r^2, zero beyond r_cut
+  double u_pair(double r2) const;
+
+  // r du(r)/dr as a function of r^2 used in virial theorem
+  double r_du_pair(double r2) const;
+
+  int thermalize();
+
+  void do_steps();
+
+  // one sweep over all N beads of every time slice, even/odd slices in parallel
+  int sweep();
+
+  std::vector<double> const & get_P() const {return histogram.get_P();}
+  std::vector<double> const & get_r() const {return r;}
+
+  int get_N() const { return N; }
+  int get_M() const { return M; }
+  int get_DIM() const { return DIM; }
+  double get_x_min() const { return x_min; }
+  double get_x_max() const { return x_max; }
+  double get_dx() const { return histogram.get_dx(); }
+  double get_E_ave() const { return E_ave; }
+  double get_E_var() const { return E_var; }
+  double get_acceptance() const { return acceptance; }
+
+protected :
+
+  static const int DIM = 3;   // dimensionality of space
+
+  // position of bead i on time slice j
+  double * bead(int j, int i) { return &r[(j * N + i) * DIM]; }
+  double const * bead(int j, int i) const { return &r[(j * N + i) * DIM]; }
+
+  // cell list over the beads of one time slice
+  int cell_index(double const * ri) const;
+  void build_cells();
+  void move_to_cell(int j, int i, int c);
+
+  // pair energy of bead i at position ri with all other beads of slice j
+  double pair_energy(int j, int i, double const * ri) const;
+
+  // Metropolis updates of every bead on slice j, returns acceptances
+  int update_slice(int j);
+
+  // potential and virial terms of slice j
+  void measure_slice(int j, double & pot, double & vir) const;
+
+  // run f(j) for every slice j in slices, split across the workers of pool
+  template<typename F> void for_slices(std::vector<int> const & slices, F f);
+
+  // C++11 random number generator from Mersenne twister, one per time slice
+  // so that slices of the same parity can be updated concurrently
+  std::random_device rd;
+  std::vector<std::mt19937> gens;
+  std::uniform_real_distribution<> dis;
+
+  int N;                      // number of particles
+  double tau;                 // imaginary time period
+  int M;                      // number of time slices
+  double Delta_tau;           // imaginary time step
+  std::vector<double> r;      // bead positions, M x N x DIM
+
+  PathHistogram histogram;    // histogram for |psi|^2 in x
+  double x_min;               // bottom of first bin and of the cell list
+  double x_max;               // top of last bin and of the cell list
+
+  double delta;               // Metropolis step size in each direction
+  int MC_steps;               // number of Monte Carlo sweeps in simulation
+
+  double epsilon;             // Lennard-Jones well depth
+  double sigma;               // Lennard-Jones length scale
+  double r_cut;               // pair potential cutoff
+
+  int n_cell;                 // cells per dimension spanning [x_min, x_max]
+  double cell_size;           // cell edge, at least r_cut
+  std::vector<int> head;      // first bead in each cell of each slice, -1 if empty
+  std::vector<int> next;      // next bead in the same cell, -1 at end
+  std::vector<int> prev;      // previous bead in the same cell, -1 at start
+  std::vector<int> cell;      // cell of each bead
+
+  std::vector< std::vector<int> > colors;  // slices grouped so no two are neighbours
+  int n_threads;              // number of threads used per sweep
+  std::unique_ptr<ThreadPool> pool;  // workers kept for every sweep, none with one thread
+
+  double E_ave;               // average energy
+  double E_var;               // energy variance
+  double acceptance;          // fraction of accepted moves in do_steps
+};
+
+
+
+#endif
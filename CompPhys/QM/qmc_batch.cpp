@@ -0,0 +1,234 @@
+// Batch driver running grids of VMC, DMC and PIMC jobs on a thread pool
+#include "qmc_batch.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+using namespace std;
+
+
+double QMCJob::cost() const
+{
+  switch (engine) {
+  case VMC  : return double(steps) * N;
+  case DMC  : return double(steps) * N_T;
+  case PIMC : return double(steps) * M;
+  }
+  return steps;
+}
+
+std::string QMCJob::engine_name(int e)
+{
+  switch (e) {
+  case VMC  : return "vmc";
+  case DMC  : return "dmc";
+  case PIMC : return "pimc";
+  }
+  return "unknown";
+}
+
+
+bool QMCBatch::set_param(QMCJob & job, std::string const & key, double value) const
+{
+  if      (key == "steps")  job.steps = int(value);
+  else if (key == "N")      job.N = int(value);
+  else if (key == "alpha")  job.alpha = value;
+  else if (key == "dt")     job.dt = value;
+  else if (key == "N_T")    job.N_T = int(value);
+  else if (key == "tau")    job.tau = value;
+  else if (key == "M")      job.M = int(value);
+  else if (key == "delta")  job.delta = value;
+  else if (key == "x_max")  job.x_max = value;
+  else if (key == "n_bins") job.n_bins = int(value);
+  else return false;
+  return true;
+}
+
+int QMCBatch::job_seed(int id) const
+{
+  // decorrelate neighbouring ids before handing the seed to mt19937
+  std::seed_seq seq{ base_seed, id };
+  unsigned int s;
+  seq.generate(&s, &s + 1);
+  return int(s & 0x7fffffff);
+}
+
+// parse "a,b,c" or "start:stop:step" (or a mix of both) into values
+static bool parse_values(std::string const & text, std::vector<double> & values)
+{
+  std::stringstream items(text);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    std::vector<double> range;
+    std::stringstream parts(item);
+    std::string part;
+    while (std::getline(parts, part, ':')) {
+      std::stringstream ss(part);
+      double v;
+      if (!(ss >> v))
+	return false;
+      range.push_back(v);
+    }
+    if (range.size() == 1)
+      values.push_back(range[0]);
+    else if (range.size() == 3 && range[2] > 0) {
+      for (int k = 0; range[0] + k * range[2] <= range[1] + 1e-9 * range[2]; ++k)
+	values.push_back(range[0] + k * range[2]);
+    } else
+      return false;
+  }
+  return !values.empty();
+}
+
+bool QMCBatch::read_grid(std::istream & in)
+{
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    std::size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.erase(hash);
+    std::stringstream tokens(line);
+    std::string name;
+    if (!(tokens >> name))
+      continue;
+
+    QMCJob proto;
+    if      (name == "vmc")  { proto.engine = QMCJob::VMC;  proto.steps = 10000; }
+    else if (name == "dmc")  { proto.engine = QMCJob::DMC;  proto.steps = 1000; }
+    else if (name == "pimc") { proto.engine = QMCJob::PIMC; proto.steps = 100000; }
+    else {
+      std::cerr << " line " << line_number << ": unknown engine " << name << std::endl;
+      return false;
+    }
+
+    // collect the axes of this line
+    std::vector<std::string> keys;
+    std::vector< std::vector<double> > axes;
+    int repeats = 1;
+    std::string token;
+    while (tokens >> token) {
+      std::size_t eq = token.find('=');
+      std::vector<double> values;
+      if (eq == std::string::npos || !parse_values(token.substr(eq + 1), values)) {
+	std::cerr << " line " << line_number << ": cannot parse " << token << std::endl;
+	return false;
+      }
+      std::string key = token.substr(0, eq);
+      if (key == "repeats") {
+	repeats = std::max(1, int(values[0]));
+	continue;
+      }
+      QMCJob test;
+      if (!set_param(test, key, values[0])) {
+	std::cerr << " line " << line_number << ": unknown parameter " << key << std::endl;
+	return false;
+      }
+      keys.push_back(key);
+      axes.push_back(values);
+    }
+
+    // expand the Cartesian product, last axis fastest
+    std::vector<unsigned int> index(axes.size(), 0);
+    for (;;) {
+      QMCJob job = proto;
+      for (unsigned int a = 0; a < axes.size(); ++a)
+	set_param(job, keys[a], axes[a][index[a]]);
+      for (int r = 0; r < repeats; ++r) {
+	job.id = jobs.size();
+	job.seed = job_seed(job.id);
+	jobs.push_back(job);
+      }
+      int a = int(axes.size()) - 1;
+      while (a >= 0 && ++index[a] == axes[a].size())
+	index[a--] = 0;
+      if (a < 0)
+	break;
+    }
+  }
+  return true;
+}
+
+
+QMCResult QMCBatch::run_job(QMCJob const & job)
+{
+  QMCResult result;
+  auto t0 = std::chrono::steady_clock::now();
+
+  switch (job.engine) {
+  case QMCJob::VMC : {
+    QHO qho(job.N, job.alpha, job.steps, job.seed);
+    qho.set_verbose(false);
+    qho.adjustStep();
+    qho.doProductionSteps();
+    result.E = qho.get_eAve();
+    result.E_var = qho.get_eVar();
+    result.E_err = sqrt(result.E_var / (double(job.N) * job.steps));
+    break;
+  }
+  case QMCJob::DMC : {
+    DiffusionMC dmc(job.N_T, job.dt, job.seed);
+    dmc.set_verbose(false);
+    dmc.run(job.steps);
+    result.E = dmc.getESum() / job.steps;
+    result.E_var = dmc.getESqdSum() / job.steps - result.E * result.E;
+    result.E_err = sqrt(result.E_var / job.steps);
+    break;
+  }
+  case QMCJob::PIMC : {
+    PathIntegralMC pimc(job.tau, job.M, job.n_bins, job.x_max, job.delta, job.steps, 1, job.seed);
+    pimc.thermalize();
+    pimc.do_steps();
+    result.E = pimc.get_E_ave();
+    result.E_var = pimc.get_E_var();
+    result.E_err = sqrt(result.E_var / (double(job.M) * job.steps));
+    break;
+  }
+  }
+
+  auto t1 = std::chrono::steady_clock::now();
+  result.seconds = std::chrono::duration<double>(t1 - t0).count();
+  return result;
+}
+
+void QMCBatch::write_header(std::ostream & out)
+{
+  out << "id,engine,seed,steps,N,alpha,dt,N_T,tau,M,delta,x_max,n_bins,E,E_err,E_var,seconds\n";
+}
+
+void QMCBatch::write_row(std::ostream & out, QMCJob const & job, QMCResult const & result)
+{
+  out << job.id << ',' << QMCJob::engine_name(job.engine) << ',' << job.seed << ',' << job.steps << ','
+      << job.N << ',' << job.alpha << ',' << job.dt << ',' << job.N_T << ','
+      << job.tau << ',' << job.M << ',' << job.delta << ',' << job.x_max << ',' << job.n_bins << ','
+      << result.E << ',' << result.E_err << ',' << result.E_var << ',' << result.seconds << '\n';
+}
+
+void QMCBatch::run(std::ostream & out)
+{
+  // longest jobs first, so the short ones fill in the gaps at the end
+  std::vector<int> order(jobs.size());
+  for (unsigned int k = 0; k < order.size(); ++k)
+    order[k] = k;
+  std::stable_sort(order.begin(), order.end(),
+		   [this](int a, int b) { return jobs[a].cost() > jobs[b].cost(); });
+
+  std::mutex out_mutex;
+  write_header(out);
+  {
+    ThreadPool pool(n_threads);
+    for (unsigned int k = 0; k < order.size(); ++k) {
+      QMCJob const & job = jobs[order[k]];
+      pool.submit([&job, &out, &out_mutex]() {
+	  QMCResult result = run_job(job);
+	  std::lock_guard<std::mutex> lock(out_mutex);
+	  write_row(out, job, result);
+	  out.flush();
+	});
+    }
+    pool.wait();
+  }
+}
@@ -0,0 +1,86 @@
+// Batch driver running grids of VMC, DMC and PIMC jobs on a thread pool
+#ifndef qmc_batch_h
+#define qmc_batch_h
+
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "vmc.h"
+#include "dmc.h"
+#include "pimc.h"
+
+
+// one parameter point; only the fields of its engine are used
+struct QMCJob {
+  enum { VMC = 0, DMC, PIMC };
+
+  int id = 0;                 // row in the grid, in file order
+  int engine = VMC;           // which simulation to run
+  int seed = 0;               // seed for the engine's generator
+  int steps = 0;              // MC steps (VMC, PIMC) or time steps (DMC)
+
+  int N = 10;                 // VMC number of walkers
+  double alpha = 0.2;         // VMC trial function exp(-alpha*x^2)
+
+  double dt = 0.1;            // DMC time step
+  int N_T = 100;              // DMC target number of walkers
+
+  double tau = 10.0;          // PIMC imaginary time period
+  int M = 100;                // PIMC number of time slices
+  double delta = 1.0;         // PIMC Metropolis step size
+  double x_max = 4.0;         // PIMC histogram range
+  int n_bins = 100;           // PIMC histogram bins
+
+  // rough relative run time, used to start the longest jobs first
+  double cost() const;
+
+  static std::string engine_name(int e);
+};
+
+struct QMCResult {
+  double E = 0;               // average energy
+  double E_err = 0;           // naive statistical error on E
+  double E_var = 0;           // energy variance
+  double seconds = 0;         // wall clock time of the job
+};
+
+
+class QMCBatch {
+public:
+
+  // n_threads <= 0 uses one thread per core
+  QMCBatch(int in_threads = 0, int ibase_seed = 12345) :
+    n_threads(in_threads), base_seed(ibase_seed) {}
+
+  // Parse a grid file. Each line names an engine (vmc, dmc or pimc) followed
+  // by key=values pairs, where values is a comma separated list of numbers or
+  // start:stop:step ranges. The line expands into the Cartesian product of
+  // its values; repeats=n runs every point n times with different seeds.
+  // Returns false and prints the offending line on a parse error.
+  bool read_grid(std::istream & in);
+
+  // run every job and stream one CSV row per job to out as it finishes,
+  // with every field of the QMCJob, used by its engine or not
+  void run(std::ostream & out);
+
+  static QMCResult run_job(QMCJob const & job);
+
+  static void write_header(std::ostream & out);
+  static void write_row(std::ostream & out, QMCJob const & job, QMCResult const & result);
+
+  std::vector<QMCJob> const & get_jobs() const { return jobs; }
+
+protected:
+
+  bool set_param(QMCJob & job, std::string const & key, double value) const;
+  int job_seed(int id) const;
+
+  int n_threads;              // worker threads
+  int base_seed;              // per-job seeds derive from this and the job id
+  std::vector<QMCJob> jobs;   // expanded parameter grid
+};
+
+
+#endif
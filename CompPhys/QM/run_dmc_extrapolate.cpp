@@ -0,0 +1,23 @@
+#include "dmc_extrapolate.h"
+using namespace std;
+
+int main() {
+
+  cout << " Diffusion Monte Carlo time-step extrapolation\n"
+       << " ---------------------------------------------" << endl;
+
+  int N_T = 300, order = 1;
+  double target_error = 0.005;
+  vector<double> dts = { 0.01, 0.02, 0.04, 0.08 };
+
+  DMCExtrapolation extrap(N_T, dts, target_error, 1000000, order);
+  extrap.run();
+
+  for (unsigned int k = 0; k < dts.size(); ++k)
+    cout << " dt = " << dts[k] << " : <E> = " << extrap.get_E()[k]
+         << " +/- " << extrap.get_E_err()[k]
+         << " after " << extrap.get_steps()[k] << " steps" << endl;
+  cout << " E(dt -> 0) = " << extrap.get_E0() << " +/- " << extrap.get_E0_err()
+       << "\n chi^2 = " << extrap.get_chi2()
+       << "\n Exact ground state energy = 1.5" << endl;
+}
@@ -18,9 +18,31 @@ int main()
          << "\n Number of Monte Carlo steps = " << (MC_steps = 100000)
          << endl;
 
-    PathIntegralMC pimc(tau, M, n_bins, x_max,  delta, MC_steps);
+    // fixed seed, so that the check below is reproducible
+    int seed = 12345;
+    PathIntegralMC pimc(tau, M, n_bins, x_max,  delta, MC_steps, 1, seed);
     pimc.thermalize();    
     pimc.do_steps();
 
+    // regression check against the exact energy of the discretized path:
+    // the virial estimator is <x^2>, and the normal modes of the ring of
+    // M beads give <x^2> = (1/M) sum_k 1 / ((2 - 2 cos(2 pi k / M)) / dtau + dtau),
+    // which differs from the continuum value 0.5 / tanh(0.5 tau) by O(dtau^2)
+    double pi = 4 * atan(1.0), dtau = tau / M, E_exact = 0;
+    for (int k = 0; k < M; ++k)
+        E_exact += 1 / ((2 - 2 * cos(2 * pi * k / M)) / dtau + dtau);
+    E_exact /= M;
+    double tolerance = 4 * pimc.get_E_err();
+    cout << " <E> = " << pimc.get_E_ave() << " +- " << pimc.get_E_err()
+         << "\n <E^2> - <E>^2 = " << pimc.get_E_var()
+         << "\n Exact <E> for M slices = " << E_exact
+         << "\n Exact <E> for M -> infinity = " << 0.5 / tanh(0.5 * tau) << endl;
+    if (fabs(pimc.get_E_ave() - E_exact) > tolerance) {
+        cout << " FAILED: <E> differs from exact value by more than 4 standard errors, "
+             << tolerance << endl;
+        return EXIT_FAILURE;
+    }
+    cout << " PASSED" << endl;
+
     return 0;
 }
@@ -0,0 +1,37 @@
+#include "pimc_many.h"
+#include <thread>
+
+using namespace std;
+
+int main()
+{
+    cout << " Path Integral Monte Carlo for N Lennard-Jones particles in a 3-D trap\n"
+         << " ---------------------------------------------------------------------\n";
+
+    // set simulation parameters
+    double tau, delta, x_max, epsilon, sigma, r_cut;
+    int N, M, n_bins, MC_steps, n_threads;
+    cout << " Number of particles N = " << (N = 8)
+         << "\n Imaginary time period tau = " << (tau = 10.0)
+         << "\n Number of time slices M = " << (M = 100)
+         << "\n Maximum displacement to bin x_max = " << (x_max = 4.0)
+         << "\n Number of histogram bins in x = " << (n_bins = 100)
+         << "\n Metropolis step size delta = " << (delta = 0.5)
+         << "\n Number of Monte Carlo sweeps = " << (MC_steps = 10000)
+         << "\n Lennard-Jones epsilon = " << (epsilon = 0.1)
+         << "\n Lennard-Jones sigma = " << (sigma = 0.5)
+         << "\n Number of threads = " << (n_threads = max(1u, thread::hardware_concurrency()))
+         << endl;
+    cout << " Pair potential cutoff = " << (r_cut = 2.5 * sigma) << endl;
+
+    ManyBodyPIMC pimc(N, tau, M, n_bins, x_max, delta, MC_steps, epsilon, sigma, r_cut, n_threads);
+    pimc.thermalize();
+    pimc.do_steps();
+
+    cout << " <E> = " << pimc.get_E_ave()
+         << "\n <E^2> - <E>^2 = " << pimc.get_E_var()
+         << "\n Acceptance ratio = " << pimc.get_acceptance()
+         << "\n Non-interacting ground state = " << 1.5 * N << endl;
+
+    return 0;
+}
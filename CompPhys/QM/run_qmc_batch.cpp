@@ -0,0 +1,40 @@
+#include "qmc_batch.h"
+#include <cstdlib>
+#include <fstream>
+
+using namespace std;
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2) {
+        cerr << " Usage: " << argv[0] << " grid_file [results.csv] [n_threads] [base_seed]" << endl;
+        return EXIT_FAILURE;
+    }
+    string grid_name = argv[1];
+    string out_name = argc > 2 ? argv[2] : "qmc_batch.csv";
+    int n_threads = argc > 3 ? atoi(argv[3]) : 0;
+    int base_seed = argc > 4 ? atoi(argv[4]) : 12345;
+
+    ifstream grid(grid_name.c_str());
+    if (!grid) {
+        cerr << " Cannot open " << grid_name << endl;
+        return EXIT_FAILURE;
+    }
+
+    QMCBatch batch(n_threads, base_seed);
+    if (!batch.read_grid(grid))
+        return EXIT_FAILURE;
+
+    cout << " Batch QMC runner\n"
+         << " ----------------\n"
+         << " Jobs in " << grid_name << " = " << batch.get_jobs().size()
+         << "\n Results streamed to " << out_name << endl;
+
+    ofstream out(out_name.c_str());
+    clock_t t0 = clock();
+    batch.run(out);
+    clock_t t1 = clock();
+    cout << " CPU time = " << double(t1 - t0) / CLOCKS_PER_SEC << " sec" << endl;
+
+    return 0;
+}
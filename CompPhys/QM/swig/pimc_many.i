@@ -0,0 +1,14 @@
+%module pimc_many
+/* First: Include your own code.*/
+%{
+#define SWIG_FILE_WITH_INIT
+#include "pimc_many.h"
+%}
+
+%include "std_vector.i"
+
+namespace std {
+   %template(vector_double) vector<double>;
+};
+
+%include "pimc_many.h"
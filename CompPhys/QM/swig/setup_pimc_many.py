@@ -0,0 +1,22 @@
+#!/usr/bin/env python
+
+"""
+setup.py file for SWIG pimc_many
+"""
+
+from distutils.core import setup, Extension
+
+
+pimc_many_module = Extension('_pimc_many',
+                           sources=['swig/pimc_many_wrap.cxx', 'pimc_many.cpp'],
+                           extra_compile_args=["-I./", "-std=c++11", "-O3", "-pthread"],
+                           extra_link_args=["-pthread"],
+                           )
+
+setup (name = 'pimc_many',
+       version = '0.1',
+       author      = "SWIG Docs",
+       description = """Implementation of many-body Path integral computation""",
+       ext_modules = [pimc_many_module],
+       py_modules = ["pimc_many"],
+       )
@@ -0,0 +1,134 @@
+// Work-stealing thread pool for independent jobs of unequal length
+#ifndef thread_pool_h
+#define thread_pool_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool {
+public:
+
+  typedef std::function<void()> job_type;
+
+  // n_threads <= 0 uses one thread per hardware core
+  ThreadPool(int n_threads = 0) : queued(0), pending(0), next(0), stop(false)
+  {
+    if (n_threads <= 0)
+      n_threads = std::thread::hardware_concurrency();
+    if (n_threads <= 0)
+      n_threads = 1;
+    for (int w = 0; w < n_threads; ++w)
+      queues.push_back(std::unique_ptr<Queue>(new Queue));
+    for (int w = 0; w < n_threads; ++w)
+      workers.push_back(std::thread(&ThreadPool::work, this, w));
+  }
+
+  ~ThreadPool()
+  {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+    }
+    cv_work.notify_all();
+    for (unsigned int w = 0; w < workers.size(); ++w)
+      workers[w].join();
+  }
+
+  // deal jobs round-robin onto the worker queues; idle workers steal the rest
+  void submit(job_type job)
+  {
+    unsigned int w;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      w = next++ % queues.size();
+    }
+    Queue & q = *queues[w];
+    {
+      std::lock_guard<std::mutex> lock(q.m);
+      q.jobs.push_back(job);
+    }
+    {
+      std::lock_guard<std::mutex> lock(m);
+      ++queued;
+      ++pending;
+    }
+    cv_work.notify_one();
+  }
+
+  // block until every submitted job has finished
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(m);
+    cv_done.wait(lock, [this]() { return pending == 0; });
+  }
+
+  int get_n_threads() const { return workers.size(); }
+
+protected:
+
+  struct Queue {
+    std::mutex m;
+    std::deque<job_type> jobs;
+  };
+
+  // take the oldest job of our own queue, else steal the oldest of another,
+  // so jobs still start roughly in submission order
+  bool try_pop(int w, job_type & job)
+  {
+    int n = queues.size();
+    for (int k = 0; k < n; ++k) {
+      Queue & q = *queues[(w + k) % n];
+      std::lock_guard<std::mutex> lock(q.m);
+      if (q.jobs.empty())
+	continue;
+      job = q.jobs.front();
+      q.jobs.pop_front();
+      return true;
+    }
+    return false;
+  }
+
+  void work(int w)
+  {
+    for (;;) {
+      {
+	// reserve one queued job, so the search below always finds it
+	std::unique_lock<std::mutex> lock(m);
+	cv_work.wait(lock, [this]() { return stop || queued > 0; });
+	if (queued == 0)
+	  return;
+	--queued;
+      }
+      job_type job;
+      while (!try_pop(w, job))
+	std::this_thread::yield();
+      job();
+      {
+	std::lock_guard<std::mutex> lock(m);
+	if (--pending == 0)
+	  cv_done.notify_all();
+      }
+    }
+  }
+
+  std::vector< std::unique_ptr<Queue> > queues;  // one job queue per worker
+  std::vector<std::thread> workers;
+
+  std::mutex m;                     // guards the counters below
+  std::condition_variable cv_work;  // signalled when a job is queued
+  std::condition_variable cv_done;  // signalled when pending drops to zero
+  int queued;                       // jobs in queues not yet reserved by a worker
+  int pending;                      // jobs submitted but not yet finished
+  unsigned int next;                // queue for the next submitted job
+  bool stop;                        // set by the destructor
+};
+
+
+#endif
@@ -1,8 +1,8 @@
 // Variational Monte Carlo for the harmonic oscillator
 #include "vmc.h"
 
-QHO::QHO(int Nin, double alphain, int MCStepsin) :
-  rd(), gen(rd()), dis(0,1.), gausdev(),
+QHO::QHO(int Nin, double alphain, int MCStepsin, int seedin) :
+  rd(), gen(seedin < 0 ? rd() : seedin), dis(0,1.), gausdev(),
   N(Nin), alpha(alphain), MCSteps(MCStepsin)
 {
   x.resize(N);
@@ -72,8 +72,9 @@ void QHO::adjustStep() {
   int thermSteps = int(0.2 * MCSteps);
   int adjustInterval = int(0.1 * thermSteps) + 1;
 
-  std::cout << " Performing " << thermSteps << " thermalization steps ..."
-	    << std::flush;
+  if (verbose)
+    std::cout << " Performing " << thermSteps << " thermalization steps ..."
+	      << std::flush;
   for (int i = 0; i < thermSteps; i++) {
     oneMonteCarloStep();
     if ((i+1) % adjustInterval == 0) {
@@ -81,7 +82,8 @@ void QHO::adjustStep() {
       nAccept = 0;
     }
   }
-  std::cout << "\n Adjusted Gaussian step size = " << delta << std::endl;    
+  if (verbose)
+    std::cout << "\n Adjusted Gaussian step size = " << delta << std::endl;
 }
 
 
@@ -89,7 +91,8 @@ void QHO::adjustStep() {
 void QHO::doProductionSteps( ) {
   zeroAccumulators();
   nAccept = 0;
-  std::cout << " Performing " << MCSteps << " production steps ..." << std::flush;
+  if (verbose)
+    std::cout << " Performing " << MCSteps << " production steps ..." << std::flush;
   for (int i = 0; i < MCSteps; i++)
     oneMonteCarloStep();
 }
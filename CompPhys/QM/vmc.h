@@ -13,7 +13,8 @@
 class QHO {
 public :
 
-  QHO(int Nin, double alphain, int MCStepsin); 
+  // a negative seed draws one from std::random_device
+  QHO(int Nin, double alphain, int MCStepsin, int seedin = -1); 
 
   
   void zeroAccumulators();
@@ -39,6 +40,9 @@ public :
 
   void printout();
 
+  // progress printout from adjustStep() and doProductionSteps()
+  void set_verbose(bool v) { verbose = v; }
+
   void normPsi();
 
   std::vector<double> const & get_psiSqd() const { return psiSqd; }
@@ -72,6 +76,7 @@ protected :
   double alpha;                  // trial function is exp(-alpha*x^2)
   int nAccept;                   // accumulator for number of accepted steps
   int MCSteps;                   // number of MC steps
+  bool verbose = true;           // print progress messages
 };
   
 
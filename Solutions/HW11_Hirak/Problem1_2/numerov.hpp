@@ -0,0 +1,214 @@
+// Re-entrant Numerov shooting solver for the 1-D Schroedinger equation
+//
+//   phi''(x) + q(x) phi(x) = 0,   q(x) = 2 m / hbar^2 (E - V(x))
+//
+// with phi = 0 at both ends of [x_left, x_right]. The potential is sampled
+// on the grid once; every call works on its own buffers, so one solver can
+// be shared between threads.
+#ifndef NUMEROV_HPP
+#define NUMEROV_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+class Numerov {
+
+public :
+
+  template<typename Potential>
+  Numerov(Potential V, int iN = 500, double ixl = -15.0, double ixr = 15.0,
+	  double ihbar = 1.0, double im = 1.0) :
+    hbar(ihbar), m(im), N(iN), x_left(ixl), x_right(ixr),
+    h( (x_right-x_left) / N), V_grid(N+1)
+  {
+    for (int i = 0; i <= N; i++)
+      V_grid[i] = V(x(i));
+  }
+
+  double x(int i) const { return x_left + i * h; }
+  double V(int i) const { return V_grid[i]; }
+
+  // Sturm-Liouville q function on the whole grid for one energy
+  void q_grid(double E, std::vector<double> & q) const
+  {
+    double k = 2 * m / (hbar * hbar);
+    q.resize(N+1);
+    for (int i = 0; i <= N; i++)
+      q[i] = k * (E - V_grid[i]);
+  }
+
+  // Matching function, zero at the eigenvalues. phi_left and phi_right are
+  // integrated towards the right turning point and the difference of their
+  // log derivatives is returned; its sign is flipped with the number of
+  // nodes of phi_left so that F(E) is continuous across the poles. If phi
+  // is given it receives the matched (unnormalized) wave function.
+  double F(double E, std::vector<double> * phi = 0) const
+  {
+    std::vector<double> q;
+    q_grid(E, q);
+
+    // find right turning point
+    int i_match = N;
+    while (i_match > 1 && q[i_match] < 0)
+      --i_match;
+    if (i_match >= N - 1)
+      i_match = N - 2;
+
+    // integrate phi_left using Numerov algorithm
+    double c = h * h / 12;          // constant in Numerov formula
+    std::vector<double> phi_left(N+1), phi_right(N+1);
+    phi_left[0] = 0;
+    phi_left[1] = 1e-10;
+    for (int i = 1; i <= i_match; i++)
+      phi_left[i+1] = (2 * (1 - 5 * c * q[i]) * phi_left[i]
+		       - (1 + c * q[i-1]) * phi_left[i-1]) / (1 + c * q[i+1]);
+
+    // integrate phi_right
+    phi_right[N]   = 0;
+    phi_right[N-1] = 1e-10;
+    for (int i = N - 1; i >= i_match; i--)
+      phi_right[i-1] = (2 * (1 - 5 * c * q[i]) * phi_right[i]
+			- (1 + c * q[i+1]) * phi_right[i+1]) / (1 + c * q[i-1]);
+
+    // rescale phi_left
+    double scale = phi_right[i_match] / phi_left[i_match];
+    for (int i = 0; i <= i_match + 1; i++)
+      phi_left[i] *= scale;
+
+    // count number of nodes in phi_left
+    int n = 0;
+    for (int i = 1; i <= i_match; i++)
+      if (phi_left[i-1] * phi_left[i] < 0)
+	++n;
+    int sign = n % 2 == 0 ? 1 : -1;
+
+    if (phi) {
+      phi->resize(N+1);
+      for (int i = 0; i <= N; i++)
+	(*phi)[i] = i <= i_match ? phi_left[i] : phi_right[i];
+    }
+
+    return sign * ( phi_right[i_match-1] - phi_right[i_match+1]
+		    - phi_left[i_match-1] + phi_left[i_match+1] )
+      / (2 * h * phi_right[i_match]);
+  }
+
+  // Shoot from the left boundary for all energies E[k] at once, one energy
+  // per lane. nodes[k] is the number of sign changes of phi on (x_left,
+  // x_right], which equals the number of eigenvalues below E[k]; end[k] is
+  // phi(x_right) up to a positive scale. q is evaluated once per grid point
+  // and energy, and the inner loop over lanes vectorizes.
+  void shoot(std::vector<double> const & E, std::vector<int> & nodes,
+	     std::vector<double> & end) const
+  {
+    int K = E.size();
+    double c = h * h / 12 * 2 * m / (hbar * hbar);
+    std::vector<double> p0(K, 0.0), p1(K, 1.0), w0(K), wm(K), Ek(E);
+    std::vector<int> n(K, 0);
+
+    // w = 1 + h^2/12 q on the previous and current grid points
+    for (int k = 0; k < K; k++) {
+      wm[k] = 1 + c * (Ek[k] - V_grid[0]);
+      w0[k] = 1 + c * (Ek[k] - V_grid[1]);
+    }
+
+    for (int i = 1; i < N; i++) {
+      double Vp = V_grid[i+1];
+      for (int k = 0; k < K; k++) {
+	double wp = 1 + c * (Ek[k] - Vp);
+	double p2 = ((12 - 10 * w0[k]) * p1[k] - wm[k] * p0[k]) / wp;
+	n[k] += (p2 * p1[k] < 0);
+	// keep the growing solution in range without changing its sign
+	double s = std::fabs(p2) > 1e100 ? 1e-100 : 1.0;
+	p0[k] = p1[k] * s;
+	p1[k] = p2 * s;
+	wm[k] = w0[k];
+	w0[k] = wp;
+      }
+    }
+
+    nodes = n;
+    end = p1;
+  }
+
+  // All eigenvalues in [E_min, E_max]. One batched shot over n_scan
+  // energies brackets every level by its node count, then all brackets
+  // are bisected together, one lane per level, until narrower than accuracy
+  // or, when accuracy is below the spacing of doubles there, until the
+  // midpoint of every bracket is one of its ends.
+  std::vector<double> spectrum(double E_min, double E_max, int n_scan = 64,
+			       double accuracy = 1e-10) const
+  {
+    n_scan = std::max(n_scan, 2);
+    std::vector<double> E(n_scan), end;
+    std::vector<int> nodes;
+    for (int k = 0; k < n_scan; k++)
+      E[k] = E_min + (E_max - E_min) * k / (n_scan - 1);
+    shoot(E, nodes, end);
+
+    // bracket level n by the last scan energy with at most n nodes and the
+    // first with more than n
+    std::vector<double> lo, hi;
+    std::vector<int> level;
+    for (int n = nodes.front(); n < nodes.back(); n++) {
+      int a = 0;
+      while (a + 1 < n_scan && nodes[a+1] <= n)
+	++a;
+      int b = a + 1;
+      lo.push_back(E[a]);
+      hi.push_back(E[b]);
+      level.push_back(n);
+    }
+
+    int L = level.size();
+    std::vector<double> mid(L);
+    while (L > 0) {
+      double width = 0;
+      for (int l = 0; l < L; l++) {
+	mid[l] = 0.5 * (lo[l] + hi[l]);
+	if (mid[l] > lo[l] && mid[l] < hi[l])
+	  width = std::max(width, hi[l] - lo[l]);
+      }
+      if (width == 0 || width < accuracy)
+	break;
+      shoot(mid, nodes, end);
+      for (int l = 0; l < L; l++)
+	(nodes[l] <= level[l] ? lo[l] : hi[l]) = mid[l];
+    }
+    return mid;
+  }
+
+  // eigenfunction at eigenvalue E, normalized to sum phi^2 h = 1
+  void eigenfunction(double E, std::vector<double> & phi) const
+  {
+    F(E, &phi);
+    double norm = 0;
+    for (int i = 0; i <= N; i++)
+      norm += phi[i] * phi[i] * h;
+    norm = std::sqrt(norm);
+    for (int i = 0; i <= N; i++)
+      phi[i] /= norm;
+  }
+
+  int get_N() const { return N;}
+  double get_x_left() const { return x_left;}
+  double get_x_right() const { return x_right;}
+  double get_h() const { return h; }
+
+protected :
+
+  double hbar ;               // Planck's constant / 2pi
+  double m ;                  // particle mass
+
+  int N ;                     // number of lattice points = N + 1
+  double x_left;              // left boundary
+  double x_right;             // right boundary
+  double h ;                  // grid spacing
+
+  std::vector<double> V_grid; // potential at the lattice points
+};
+
+
+#endif